@@ -0,0 +1,537 @@
+// astra_bench, a self-contained benchmark runner for the astra primitives. every case is timed in batches that are
+// doubled until a batch takes long enough to measure, the reported time per operation is the median batch. results go
+// to stdout (or --out) as text, csv or json so runs can be compared between compilers and commits.
+//
+// astra_bench [--format text|csv|json] [--out path] [--filter substring] [--min-time ms] [--samples n] [--workers n]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <astra/bcn.hpp>
+#include <astra/bcn_encode.hpp>
+#include <astra/binary_io.hpp>
+#include <astra/byteswap.hpp>
+#include <astra/cpu_features.hpp>
+#include <astra/file_helper.hpp>
+#include <astra/fnv.hpp>
+#include <astra/fnv_batch.hpp>
+#include <astra/fnv_index.hpp>
+#include <astra/lz4.hpp>
+#include <astra/pixel_convert.hpp>
+#include <astra/runtime_array.hpp>
+#include <astra/text_writer.hpp>
+
+namespace {
+    template<typename T>
+    inline void keep(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void *sink;
+        sink = &value;
+#endif
+    }
+
+    struct options_t {
+        std::string format = "text";
+        std::string out;
+        std::string filter;
+        double min_time = 50; // milliseconds per sample.
+        size_t samples  = 5;
+        size_t workers  = 1;
+    };
+
+    // the body runs one operation that touches `bytes` bytes (0 when throughput doesn't apply).
+    struct case_t {
+        std::string name;
+        uint64_t bytes = 0;
+        std::function<std::function<void()>()> setup;
+    };
+
+    struct result_t {
+        std::string name;
+        uint64_t iterations     = 0;
+        double ns_per_op        = 0;
+        double bytes_per_second = 0;
+    };
+
+    std::vector<uint8_t> random_bytes(size_t size, uint32_t seed = 1) {
+        std::vector<uint8_t> bytes(size);
+        std::mt19937 rng(seed);
+        for (auto &byte : bytes) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return bytes;
+    }
+
+    std::string size_name(uint64_t bytes) {
+        if (bytes >= (1 << 20) && bytes % (1 << 20) == 0) {
+            return std::to_string(bytes >> 20) + "M";
+        }
+        if (bytes >= (1 << 10) && bytes % (1 << 10) == 0) {
+            return std::to_string(bytes >> 10) + "K";
+        }
+        return std::to_string(bytes);
+    }
+
+    result_t run(const case_t &bench, const options_t &options) {
+        using clock = std::chrono::steady_clock;
+        auto body   = bench.setup();
+        body();
+
+        auto time = [&](uint64_t iterations) {
+            auto start = clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                body();
+            }
+            return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        };
+
+        uint64_t iterations = 1;
+        while (time(iterations) < options.min_time * 1e6 && iterations < (uint64_t(1) << 40)) {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (size_t i = 0; i < std::max<size_t>(options.samples, 1); ++i) {
+            samples.push_back(time(iterations) / static_cast<double>(iterations));
+        }
+        std::ranges::sort(samples);
+
+        result_t result;
+        result.name             = bench.name;
+        result.iterations       = iterations * samples.size();
+        result.ns_per_op        = samples[samples.size() / 2];
+        result.bytes_per_second = bench.bytes == 0 ? 0 : static_cast<double>(bench.bytes) * 1e9 / result.ns_per_op;
+        return result;
+    }
+
+    void add_runtime_array(std::vector<case_t> &cases) {
+        for (size_t count : {64u, 4096u, 1u << 20}) {
+            cases.push_back({"runtime_array/construct/" + size_name(count), 0, [count] {
+                                 return [count] {
+                                     astra::mem::runtime_array<uint8_t> array(nullptr, count);
+                                     keep(array.data());
+                                 };
+                             }});
+
+            cases.push_back({"runtime_array/fill/" + size_name(count), count, [count] {
+                                 auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, count);
+                                 return [array] {
+                                     array->fill(0x5A);
+                                     keep(array->data()[0]);
+                                 };
+                             }});
+
+            cases.push_back({"runtime_array/to_vector/" + size_name(count), count, [count] {
+                                 auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, count);
+                                 return [array] {
+                                     auto vector = array->to_vector();
+                                     keep(vector.data());
+                                 };
+                             }});
+        }
+
+        cases.push_back({"runtime_array/view", 0, [] {
+                             auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, 4096);
+                             return [array] {
+                                 auto view = array->view(128, 1024);
+                                 keep(view.data());
+                             };
+                         }});
+
+        cases.push_back({"runtime_array/slice", 0, [] {
+                             auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, 4096);
+                             return [array] {
+                                 auto slice = array->slice(128, 1024);
+                                 keep(slice->data());
+                             };
+                         }});
+    }
+
+    template<typename H>
+    void add_fnv(std::vector<case_t> &cases, const std::string &name, H (*hash)(const uint8_t *, size_t, H, H), H basis, H prime) {
+        for (size_t size : {8u, 32u, 256u, 4096u, 1u << 20}) {
+            cases.push_back({"fnv/" + name + "/" + size_name(size), size, [=] {
+                                 auto bytes = std::make_shared<std::vector<uint8_t>>(random_bytes(size));
+                                 return [=] { keep(hash(bytes->data(), bytes->size(), basis, prime)); };
+                             }});
+        }
+    }
+
+    void add_fnv_batch(std::vector<case_t> &cases) {
+        for (size_t size : {16u, 256u}) {
+            static constexpr size_t count = 4096;
+            cases.push_back({"fnv_batch/fnva64/" + size_name(size) + "x4096", size * count, [=] {
+                                 struct state_t {
+                                     std::vector<uint8_t> bytes;
+                                     std::vector<const uint8_t *> buffers;
+                                     std::vector<size_t> sizes;
+                                     std::vector<uint64_t> hashes;
+                                 };
+                                 auto state   = std::make_shared<state_t>();
+                                 state->bytes = random_bytes(size * count);
+                                 for (size_t i = 0; i < count; ++i) {
+                                     state->buffers.push_back(state->bytes.data() + i * size);
+                                     state->sizes.push_back(size);
+                                 }
+                                 state->hashes.resize(count);
+                                 return [state] {
+                                     astra::hash::fnva64_batch(state->buffers.data(), state->sizes.data(), state->hashes.data(), count);
+                                     keep(state->hashes[0]);
+                                 };
+                             }});
+        }
+    }
+
+    void add_fnv_index(std::vector<case_t> &cases) {
+        static constexpr size_t count = 1 << 20;
+        cases.push_back({"fnv_index/find_many/1M", count * sizeof(uint64_t), [=] {
+                             struct state_t {
+                                 astra::io::fnv_index<> index;
+                                 std::vector<uint64_t> lookup;
+                                 std::vector<const astra::io::fnv_index_entry_t *> results;
+                             };
+                             auto state = std::make_shared<state_t>();
+                             astra::io::fnv_index_builder<> builder;
+                             builder.reserve(count);
+                             std::mt19937_64 random(3);
+                             for (size_t i = 0; i < count; ++i) {
+                                 state->lookup.push_back(random());
+                                 builder.add(state->lookup.back(), {0, 0, i, i});
+                             }
+                             std::shuffle(state->lookup.begin(), state->lookup.end(), random);
+                             state->index = astra::io::fnv_index<>(builder.build());
+                             state->results.resize(count);
+                             return [state] {
+                                 state->index.find_many(state->lookup.data(), count, state->results.data());
+                                 keep(state->results[0]);
+                             };
+                         }});
+    }
+
+    void add_text_writer(std::vector<case_t> &cases) {
+        static constexpr size_t lines = 1 << 16;
+        cases.push_back({"text_writer/lines/64K", 0, [] {
+                             return [] {
+                                 size_t written = 0;
+                                 astra::io::text_writer writer([&](std::string_view text) { written += text.size(); });
+                                 for (size_t i = 0; i < lines; ++i) {
+                                     writer.indent(i % 4);
+                                     writer.write_indent() << "\"entry" << i << "\": " << static_cast<double>(i) * 0.5 << ", ";
+                                     writer.hash(static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15).write('\n');
+                                     writer.dedent(i % 4);
+                                 }
+                                 writer.flush();
+                                 keep(written);
+                             };
+                         }});
+    }
+
+    void add_byteswap(std::vector<case_t> &cases, const options_t &options) {
+        static constexpr size_t size = 16 << 20;
+        cases.push_back({"byteswap/u32/16M", size, [workers = options.workers] {
+                             auto array = std::make_shared<astra::mem::runtime_array<uint32_t>>(nullptr, size / 4);
+                             std::memset(array->data(), 1, size);
+                             return [array, workers] { astra::mem::byteswap(*array, workers); };
+                         }});
+
+        cases.push_back({"binary_reader/read_array_swapped/u32/16M", size, [] {
+                             auto bytes = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, size);
+                             std::memset(bytes->data(), 1, size);
+                             return [bytes] {
+                                 astra::io::binary_reader reader(*bytes, std::endian::big);
+                                 auto values = reader.read_array<uint32_t>(size / 4);
+                                 keep(values.data());
+                             };
+                         }});
+    }
+
+    // a noisy test image: smooth gradients plus per-pixel noise, closer to real textures than pure noise.
+    std::vector<uint8_t> test_image(uint32_t width, uint32_t height) {
+        auto noise = random_bytes(size_t(width) * height * 4, 7);
+        std::vector<uint8_t> pixels(noise.size());
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                auto at        = (size_t(y) * width + x) * 4;
+                pixels[at + 0] = static_cast<uint8_t>((x * 255 / width + noise[at] % 16) & 0xFF);
+                pixels[at + 1] = static_cast<uint8_t>((y * 255 / height + noise[at + 1] % 16) & 0xFF);
+                pixels[at + 2] = static_cast<uint8_t>(((x + y) * 127 / width + noise[at + 2] % 16) & 0xFF);
+                pixels[at + 3] = 255;
+            }
+        }
+        return pixels;
+    }
+
+    void add_gdx(std::vector<case_t> &cases, const options_t &options) {
+        using astra::gdx::dxgi_format_t;
+        static constexpr uint32_t width = 512, height = 512;
+        static constexpr uint64_t pixels = uint64_t(width) * height * 4;
+
+        struct format_t {
+            const char *name;
+            dxgi_format_t format;
+            size_t block;
+        };
+
+        for (auto [name, format, block] : {format_t{"bc1", dxgi_format_t::BC1_UNORM, 8}, format_t{"bc3", dxgi_format_t::BC3_UNORM, 16}, format_t{"bc4", dxgi_format_t::BC4_UNORM, 8}, format_t{"bc5", dxgi_format_t::BC5_UNORM, 16}}) {
+            for (auto quality : {astra::gdx::bcn_quality::fast, astra::gdx::bcn_quality::high}) {
+                auto tier = std::string(quality == astra::gdx::bcn_quality::fast ? "fast" : "high");
+                cases.push_back({std::string("bcn/encode/") + name + "/" + tier + "/512x512", pixels, [=, workers = options.workers] {
+                                     auto source = std::make_shared<std::vector<uint8_t>>(test_image(width, height));
+                                     auto blocks = std::make_shared<std::vector<uint8_t>>(size_t(width / 4) * (height / 4) * block);
+                                     return [=] {
+                                         astra::gdx::encode_bcn(format, source->data(), width, height, size_t(width) * 4, blocks->data(), {quality, workers});
+                                         keep(blocks->data()[0]);
+                                     };
+                                 }});
+            }
+
+            cases.push_back({std::string("bcn/decode/") + name + "/512x512", pixels, [=, workers = options.workers] {
+                                 auto source = test_image(width, height);
+                                 auto blocks = std::make_shared<std::vector<uint8_t>>(size_t(width / 4) * (height / 4) * block);
+                                 astra::gdx::encode_bcn(format, source.data(), width, height, size_t(width) * 4, blocks->data(), {astra::gdx::bcn_quality::fast, workers});
+                                 auto decoded = std::make_shared<std::vector<uint8_t>>(pixels * 4);
+                                 return [=] {
+                                     astra::gdx::decode_bcn(format, blocks->data(), width, height, decoded->data(), size_t(width) * 16, workers);
+                                     keep(decoded->data()[0]);
+                                 };
+                             }});
+        }
+
+        // there is no bc6h/bc7 encoder, so the blocks are random with their mode bits spread evenly over the valid modes.
+        struct bptc_t {
+            const char *name;
+            dxgi_format_t format;
+            uint64_t pixel_bytes;
+        };
+
+        for (auto [name, format, pixel_bytes] : {bptc_t{"bc6h_uf16", dxgi_format_t::BC6H_UF16, 8}, bptc_t{"bc6h_sf16", dxgi_format_t::BC6H_SF16, 8}, bptc_t{"bc7", dxgi_format_t::BC7_UNORM, 4}}) {
+            cases.push_back({std::string("bcn/decode/") + name + "/512x512", pixels, [=, workers = options.workers] {
+                                 auto blocks = std::make_shared<std::vector<uint8_t>>(random_bytes(size_t(width / 4) * (height / 4) * 16, 7));
+                                 static constexpr uint8_t bc6h_codes[] = {0x00, 0x01, 0x02, 0x06, 0x0A, 0x0E, 0x12, 0x16, 0x1A, 0x1E, 0x03, 0x07, 0x0B, 0x0F};
+                                 for (size_t i = 0; i < blocks->size(); i += 16) {
+                                     auto &first = (*blocks)[i];
+                                     if (format == dxgi_format_t::BC7_UNORM) {
+                                         auto mode = i / 16 % 8; // mode m is m zero bits and a one.
+                                         first     = static_cast<uint8_t>(first << (mode + 1) | 1u << mode);
+                                     } else {
+                                         auto code = bc6h_codes[i / 16 % 14];
+                                         first     = static_cast<uint8_t>((first & (code < 2 ? ~0x03u : ~0x1Fu)) | code);
+                                     }
+                                 }
+                                 auto decoded = std::make_shared<std::vector<uint8_t>>(size_t(width) * height * pixel_bytes);
+                                 return [=] {
+                                     astra::gdx::decode_bcn(format, blocks->data(), width, height, decoded->data(), size_t(width) * pixel_bytes, workers);
+                                     keep(decoded->data()[0]);
+                                 };
+                             }});
+        }
+
+        struct conversion_t {
+            const char *name;
+            dxgi_format_t from;
+            dxgi_format_t to;
+            size_t to_bytes;
+        };
+
+        for (auto [name, from, to, to_bytes] : {conversion_t{"rgba8_to_rgba16f", dxgi_format_t::R8G8B8A8_UNORM, dxgi_format_t::R16G16B16A16_FLOAT, 8}, conversion_t{"rgba8_to_bgra8_srgb", dxgi_format_t::R8G8B8A8_UNORM, dxgi_format_t::B8G8R8A8_UNORM_SRGB, 4}, conversion_t{"rgba8_to_rgba32f", dxgi_format_t::R8G8B8A8_UNORM, dxgi_format_t::R32G32B32A32_FLOAT, 16}}) {
+            cases.push_back({std::string("convert/") + name + "/512x512", pixels, [=, workers = options.workers] {
+                                 auto source = std::make_shared<std::vector<uint8_t>>(test_image(width, height));
+                                 auto target = std::make_shared<std::vector<uint8_t>>(size_t(width) * height * to_bytes);
+                                 return [=] {
+                                     astra::gdx::convert(from, to, source->data(), target->data(), size_t(width) * height, workers);
+                                     keep(target->data()[0]);
+                                 };
+                             }});
+        }
+    }
+
+    // files live in a private temp directory that is removed when the runner exits.
+    void add_lz4(std::vector<case_t> &cases, const options_t &options) {
+        static constexpr size_t size = 16 << 20;
+        cases.push_back({"lz4/compress/16M", size, [workers = options.workers] {
+                             auto source = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, size);
+                             auto pixels = test_image(2048, 2048);
+                             std::memcpy(source->data(), pixels.data(), size);
+                             auto frame = std::make_shared<std::vector<uint8_t>>(astra::io::lz4_frame_bound(size));
+                             return [=] { keep(astra::io::lz4_compress(*source, *frame, {.workers = workers})); };
+                         }});
+
+        cases.push_back({"lz4/decompress/16M", size, [workers = options.workers] {
+                             auto pixels = test_image(2048, 2048);
+                             auto frame  = std::make_shared<astra::mem::runtime_array<uint8_t>>(astra::io::lz4_compress(astra::mem::runtime_array<uint8_t>(pixels.data(), size)));
+                             auto output = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, size);
+                             return [=] { keep(astra::io::lz4_decompress(*frame, *output, {.workers = workers})); };
+                         }});
+    }
+
+    void add_files(std::vector<case_t> &cases, const std::filesystem::path &directory) {
+        for (size_t size : {4096u, 1u << 20, 64u << 20}) {
+            auto path = directory / ("file_" + size_name(size) + ".bin");
+
+            cases.push_back({"file/write_file/" + size_name(size), size, [=] {
+                                 auto bytes = std::make_shared<std::vector<uint8_t>>(random_bytes(size));
+                                 auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(bytes->data(), bytes->size());
+                                 return [=]() mutable { astra::io::write_file(path, array); };
+                             }});
+
+            cases.push_back({"file/read_file/" + size_name(size), size, [=] {
+                                 auto bytes = random_bytes(size);
+                                 auto array = std::make_shared<astra::mem::runtime_array<uint8_t>>(bytes.data(), bytes.size());
+                                 astra::io::write_file(path, array);
+                                 return [=] {
+                                     auto data = astra::io::read_file(path);
+                                     keep(data->data());
+                                 };
+                             }});
+        }
+    }
+
+    std::string context_compiler() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string context_features() {
+        auto &cpu = astra::cpu::current();
+        std::string result;
+        for (auto [name, enabled] : {std::pair{"ssse3", cpu.ssse3}, std::pair{"sse4.1", cpu.sse41}, std::pair{"avx2", cpu.avx2}, std::pair{"bmi2", cpu.bmi2}, std::pair{"f16c", cpu.f16c}, std::pair{"avx512", cpu.avx512}}) {
+            if (enabled) {
+                result += result.empty() ? name : std::string(" ") + name;
+            }
+        }
+        return result;
+    }
+
+    void report(std::ostream &out, const std::vector<result_t> &results, const options_t &options) {
+        out << std::setprecision(10);
+        if (options.format == "csv") {
+            out << "name,iterations,ns_per_op,bytes_per_second\n";
+            for (auto &result : results) {
+                out << result.name << ',' << result.iterations << ',' << result.ns_per_op << ',' << result.bytes_per_second << '\n';
+            }
+            return;
+        }
+
+        if (options.format == "json") {
+            // names and context strings are plain ascii without quotes or backslashes, nothing needs escaping.
+            out << "{\n  \"context\": {\"compiler\": \"" << context_compiler() << "\", \"features\": \"" << context_features() << "\", \"workers\": " << options.workers << ", \"samples\": " << options.samples << "},\n  \"benchmarks\": [";
+            for (size_t i = 0; i < results.size(); ++i) {
+                auto &result = results[i];
+                out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.ns_per_op << ", \"bytes_per_second\": " << result.bytes_per_second << "}";
+            }
+            out << "\n  ]\n}\n";
+            return;
+        }
+
+        for (auto &result : results) {
+            char line[256];
+            if (result.bytes_per_second > 0) {
+                std::snprintf(line, sizeof(line), "%-48s %14.1f ns %12.1f MB/s\n", result.name.c_str(), result.ns_per_op, result.bytes_per_second / 1e6);
+            } else {
+                std::snprintf(line, sizeof(line), "%-48s %14.1f ns\n", result.name.c_str(), result.ns_per_op);
+            }
+            out << line;
+        }
+    }
+
+    bool parse(int argc, char **argv, options_t &options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value      = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+            if (arg == "--format") {
+                options.format = value();
+            } else if (arg == "--out") {
+                options.out = value();
+            } else if (arg == "--filter") {
+                options.filter = value();
+            } else if (arg == "--min-time") {
+                options.min_time = std::stod(value());
+            } else if (arg == "--samples") {
+                options.samples = std::stoul(value());
+            } else if (arg == "--workers") {
+                options.workers = std::stoul(value());
+            } else {
+                return false;
+            }
+        }
+        return options.format == "text" || options.format == "csv" || options.format == "json";
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    options_t options;
+    try {
+        if (!parse(argc, argv, options)) {
+            std::cerr << "usage: astra_bench [--format text|csv|json] [--out path] [--filter substring] [--min-time ms] [--samples n] [--workers n]\n";
+            return 2;
+        }
+    } catch (const std::exception &) {
+        std::cerr << "astra_bench: invalid option value\n";
+        return 2;
+    }
+
+    auto directory = std::filesystem::temp_directory_path() / ("astra_bench_" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory);
+
+    std::vector<case_t> cases;
+    add_runtime_array(cases);
+    add_fnv<uint32_t>(cases, "fnv32", astra::hash::fnv32, astra::hash::FNV1_BASIS_32, astra::hash::FNV_PRIME_32);
+    add_fnv<uint32_t>(cases, "fnva32", astra::hash::fnva32, astra::hash::FNV1_BASIS_32, astra::hash::FNV_PRIME_32);
+    add_fnv<uint64_t>(cases, "fnv64", astra::hash::fnv64, astra::hash::FNV1_BASIS_64, astra::hash::FNV_PRIME_64);
+    add_fnv<uint64_t>(cases, "fnva64", astra::hash::fnva64, astra::hash::FNV1_BASIS_64, astra::hash::FNV_PRIME_64);
+    add_fnv_batch(cases);
+    add_fnv_index(cases);
+    add_text_writer(cases);
+    add_byteswap(cases, options);
+    add_gdx(cases, options);
+    add_lz4(cases, options);
+    add_files(cases, directory);
+
+    std::vector<result_t> results;
+    int status = 0;
+    try {
+        for (auto &bench : cases) {
+            if (bench.name.find(options.filter) != std::string::npos) {
+                results.push_back(run(bench, options));
+                if (options.format == "text" && options.out.empty()) {
+                    report(std::cout, {results.back()}, options);
+                }
+            }
+        }
+    } catch (const std::exception &error) {
+        std::cerr << "astra_bench: " << error.what() << '\n';
+        status = 1;
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+
+    if (!options.out.empty()) {
+        std::ofstream file(options.out);
+        report(file, results, options);
+    } else if (options.format != "text") {
+        report(std::cout, results, options);
+    }
+    return status;
+}
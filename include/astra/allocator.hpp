@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "macros.hpp"
+
+namespace astra::mem {
+    // a source of raw, ASTRA_ALIGNMENT aligned blocks for runtime_array storage.
+    // arrays keep a reference to the allocator they came from, so it outlives every buffer it handed out.
+    class allocator {
+    public:
+        virtual ~allocator() = default;
+
+        virtual void *allocate(std::size_t size) = 0;
+
+        virtual void deallocate(void *block, std::size_t size) = 0;
+    };
+
+    // the allocator runtime_array::alloc uses on this thread, nullptr means aligned operator new.
+    [[maybe_unused]] inline std::shared_ptr<allocator> &current_allocator() {
+        thread_local std::shared_ptr<allocator> instance = nullptr;
+        return instance;
+    }
+
+    // installs an allocator for the current thread until the scope ends.
+    class allocator_scope {
+    private:
+        std::shared_ptr<allocator> previous;
+
+    public:
+        explicit allocator_scope(std::shared_ptr<allocator> source) : previous(std::move(current_allocator())) { current_allocator() = std::move(source); }
+
+        ~allocator_scope() { current_allocator() = std::move(previous); }
+
+        allocator_scope(const allocator_scope &)            = delete;
+        allocator_scope &operator=(const allocator_scope &) = delete;
+    };
+
+    // recycles freed blocks in power of two size classes, requests above `max_size` go straight to operator new.
+    // the free lists belong to the thread that created the pool and are used without any locking. blocks released on
+    // other threads are pushed onto a lock-free stack, threaded through the freed blocks themselves, that the owner takes
+    // over in one exchange when its own list for a class runs dry. other threads allocate from the system.
+    class size_class_pool final : public allocator {
+    private:
+        static constexpr std::size_t min_shift = std::countr_zero<std::size_t>(ASTRA_ALIGNMENT);
+
+        struct remote_block {
+            remote_block *next;
+            std::size_t index;
+        };
+
+        static_assert(sizeof(remote_block) <= ASTRA_ALIGNMENT, "the smallest size class has to hold a remote_block");
+
+        std::size_t max_size;
+        std::size_t max_cached; // per size class, in blocks.
+        std::thread::id owner;
+        std::vector<std::vector<void *>> free_lists;
+        std::atomic<remote_block *> remote = nullptr;
+
+        [[nodiscard]] static std::size_t size_class(std::size_t size) {
+            auto shift = static_cast<std::size_t>(std::bit_width(size <= 1 ? 0 : size - 1));
+            return shift < min_shift ? 0 : shift - min_shift;
+        }
+
+        [[nodiscard]] static std::size_t class_size(std::size_t index) { return std::size_t(1) << (index + min_shift); }
+
+        void cache(void *block, std::size_t index) {
+            auto &list = free_lists[index];
+            if (list.size() < max_cached) {
+                list.push_back(block);
+            } else {
+                ::operator delete(block, std::align_val_t(ASTRA_ALIGNMENT));
+            }
+        }
+
+        // moves every block freed by other threads onto the owner's lists, owner only.
+        void drain() {
+            for (auto block = remote.exchange(nullptr, std::memory_order_acquire); block != nullptr;) {
+                auto next  = block->next;
+                auto index = block->index;
+                cache(block, index);
+                block = next;
+            }
+        }
+
+    public:
+        explicit size_class_pool(std::size_t max_size = 16 << 20, std::size_t max_cached = 64) : max_size(max_size), max_cached(max_cached), owner(std::this_thread::get_id()), free_lists(size_class(max_size) + 1) { }
+
+        ~size_class_pool() override { trim(); }
+
+        // a pool per thread, so allocations on different threads never contend.
+        [[maybe_unused]] static std::shared_ptr<size_class_pool> thread_instance() {
+            thread_local auto instance = std::make_shared<size_class_pool>();
+            return instance;
+        }
+
+        void *allocate(std::size_t size) override {
+            if (size > max_size) {
+                return ::operator new(size, std::align_val_t(ASTRA_ALIGNMENT));
+            }
+
+            auto index = size_class(size);
+            if (std::this_thread::get_id() == owner) {
+                auto &list = free_lists[index];
+                if (list.empty() && remote.load(std::memory_order_relaxed) != nullptr) {
+                    drain();
+                }
+
+                if (!list.empty()) {
+                    auto block = list.back();
+                    list.pop_back();
+                    return block;
+                }
+            }
+
+            return ::operator new(class_size(index), std::align_val_t(ASTRA_ALIGNMENT));
+        }
+
+        void deallocate(void *block, std::size_t size) override {
+            if (size > max_size) {
+                ::operator delete(block, std::align_val_t(ASTRA_ALIGNMENT));
+                return;
+            }
+
+            if (std::this_thread::get_id() == owner) {
+                cache(block, size_class(size));
+                return;
+            }
+
+            // only the owner ever takes blocks off the stack, and it takes all of them at once, so there is no aba.
+            auto node = ::new (block) remote_block {remote.load(std::memory_order_relaxed), size_class(size)};
+            while (!remote.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) { }
+        }
+
+        // returns every cached block to the system. call it on the owning thread, or once no other thread uses the pool.
+        [[maybe_unused]] void trim() {
+            drain();
+            for (auto &list : free_lists) {
+                for (auto block : list) {
+                    ::operator delete(block, std::align_val_t(ASTRA_ALIGNMENT));
+                }
+                list.clear();
+            }
+        }
+    };
+
+    // bump allocates out of large chunks and never frees individual blocks, everything is released together when the arena dies.
+    // allocation is not thread safe, use one arena per job. releasing blocks from other threads is fine.
+    class monotonic_arena final : public allocator {
+    private:
+        std::size_t chunk_size;
+        std::vector<std::pair<std::byte *, std::size_t>> chunks;
+        std::byte *cursor = nullptr;
+        std::byte *limit  = nullptr;
+        std::atomic<std::size_t> live = 0;
+
+        void grow(std::size_t size) {
+            auto capacity = size > chunk_size ? size : chunk_size;
+            auto chunk    = static_cast<std::byte *>(::operator new(capacity, std::align_val_t(ASTRA_ALIGNMENT)));
+            chunks.emplace_back(chunk, capacity);
+            cursor = chunk;
+            limit  = chunk + capacity;
+        }
+
+        void release() {
+            for (auto [chunk, capacity] : chunks) {
+                ::operator delete(chunk, std::align_val_t(ASTRA_ALIGNMENT));
+            }
+            chunks.clear();
+            cursor = limit = nullptr;
+        }
+
+    public:
+        explicit monotonic_arena(std::size_t chunk_size = 4 << 20) : chunk_size(chunk_size) { }
+
+        ~monotonic_arena() override { release(); }
+
+        void *allocate(std::size_t size) override {
+            size = (size + ASTRA_ALIGNMENT - 1) & ~static_cast<std::size_t>(ASTRA_ALIGNMENT - 1);
+            if (size == 0) {
+                size = ASTRA_ALIGNMENT;
+            }
+
+            if (static_cast<std::size_t>(limit - cursor) < size) {
+                grow(size);
+            }
+
+            auto block = cursor;
+            cursor += size;
+            live.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+
+        void deallocate(void *, std::size_t) override { live.fetch_sub(1, std::memory_order_relaxed); }
+
+        // frees every chunk so the arena can be reused for the next job, no buffer from it may still be alive.
+        [[maybe_unused]] void reset() {
+            assert(live.load() == 0);
+            release();
+        }
+
+        [[maybe_unused]] [[nodiscard]] std::size_t live_blocks() const { return live.load(std::memory_order_relaxed); }
+    };
+} // namespace astra::mem
@@ -0,0 +1,665 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "bptc.hpp"
+#include "cpu_features.hpp"
+#include "dds_layout.hpp"
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "runtime_array.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// BC1-BC7 decoding. BC1-BC5 and BC7 decode to RGBA8, BC6H to RGBA16F (see bptc.hpp).
+// every kernel, scalar or simd, produces the same bytes: endpoints are bit-replicated to 8 bits and interpolated with
+// integer math rounded to nearest. BC4/BC5 decode to (r, 0, 0, 255) and (r, g, 0, 255) like d3d does, snorm channels
+// are remapped from [-127, 127] to [0, 255]. srgb formats are left srgb encoded.
+
+namespace astra::gdx {
+    namespace detail {
+        // decodes `blocks` consecutive blocks of one block row into four pixel rows `pitch` bytes apart.
+        using bcn_row_fn = void (*)(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch);
+
+        ASTRA_INLINE uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a) { return r | g << 8 | b << 16 | a << 24; }
+
+        // the four colors of a BC1-BC3 color block, as rgba8 words.
+        inline void bc1_palette(const uint8_t *block, bool punch_through, uint32_t palette[4]) {
+            uint32_t c0 = block[0] | block[1] << 8;
+            uint32_t c1 = block[2] | block[3] << 8;
+
+            uint32_t r0 = (c0 >> 11) & 31, g0 = (c0 >> 5) & 63, b0 = c0 & 31;
+            uint32_t r1 = (c1 >> 11) & 31, g1 = (c1 >> 5) & 63, b1 = c1 & 31;
+            r0 = r0 << 3 | r0 >> 2;
+            g0 = g0 << 2 | g0 >> 4;
+            b0 = b0 << 3 | b0 >> 2;
+            r1 = r1 << 3 | r1 >> 2;
+            g1 = g1 << 2 | g1 >> 4;
+            b1 = b1 << 3 | b1 >> 2;
+
+            palette[0] = rgba(r0, g0, b0, 255);
+            palette[1] = rgba(r1, g1, b1, 255);
+            if (!punch_through || c0 > c1) {
+                palette[2] = rgba((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255);
+                palette[3] = rgba((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255);
+            } else {
+                palette[2] = rgba((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+                palette[3] = 0;
+            }
+        }
+
+        // the eight values of a BC3 alpha / BC4 / BC5 channel block.
+        // snorm endpoints are moved to [0, 254] first so both variants share the unsigned math.
+        template<bool snorm>
+        inline void bc4_palette(const uint8_t *block, uint8_t palette[8]) {
+            uint32_t a0 = block[0];
+            uint32_t a1 = block[1];
+            uint32_t top = 255;
+            if constexpr (snorm) {
+                a0  = static_cast<uint32_t>(std::max<int>(static_cast<int8_t>(block[0]), -127) + 127);
+                a1  = static_cast<uint32_t>(std::max<int>(static_cast<int8_t>(block[1]), -127) + 127);
+                top = 254;
+            }
+
+            uint32_t values[8] = {a0, a1};
+            if (a0 > a1) {
+                for (uint32_t i = 1; i < 7; ++i) {
+                    values[i + 1] = (a0 * (7 - i) + a1 * i + 3) / 7;
+                }
+            } else {
+                for (uint32_t i = 1; i < 5; ++i) {
+                    values[i + 1] = (a0 * (5 - i) + a1 * i + 2) / 5;
+                }
+                values[6] = 0;
+                values[7] = top;
+            }
+
+            for (size_t i = 0; i < 8; ++i) {
+                palette[i] = static_cast<uint8_t>(snorm ? values[i] + (values[i] >> 7) : values[i]);
+            }
+        }
+
+        ASTRA_INLINE uint64_t load48(const uint8_t *bytes) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < 6; ++i) {
+                value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        ASTRA_INLINE uint32_t load32(const uint8_t *bytes) { return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24; }
+
+        // the 16 pixel values of a channel block in pixel order.
+        template<bool snorm>
+        inline void bc4_pixels(const uint8_t *block, uint8_t pixels[16]) {
+            uint8_t palette[8];
+            bc4_palette<snorm>(block, palette);
+            auto bits = load48(block + 2);
+            for (size_t i = 0; i < 16; ++i) {
+                pixels[i] = palette[(bits >> (3 * i)) & 7];
+            }
+        }
+
+        inline void bc1_color(const uint8_t *block, bool punch_through, uint8_t *dst, size_t pitch) {
+            uint32_t palette[4];
+            bc1_palette(block, punch_through, palette);
+            auto bits = load32(block + 4);
+            for (size_t y = 0; y < 4; ++y) {
+                uint32_t row[4];
+                for (size_t x = 0; x < 4; ++x) {
+                    row[x] = palette[(bits >> (2 * (y * 4 + x))) & 3];
+                }
+                std::memcpy(dst + y * pitch, row, sizeof(row));
+            }
+        }
+
+        inline void bc1_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            for (size_t i = 0; i < blocks; ++i) {
+                bc1_color(src + i * 8, true, dst + i * 16, pitch);
+            }
+        }
+
+        inline void bc2_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            for (size_t i = 0; i < blocks; ++i) {
+                auto block = src + i * 16;
+                auto out   = dst + i * 16;
+                bc1_color(block + 8, false, out, pitch);
+                for (size_t p = 0; p < 16; ++p) {
+                    auto nibble = (block[p / 2] >> (4 * (p & 1))) & 0xF;
+                    out[(p / 4) * pitch + (p % 4) * 4 + 3] = static_cast<uint8_t>(nibble * 17);
+                }
+            }
+        }
+
+        inline void bc3_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            for (size_t i = 0; i < blocks; ++i) {
+                auto block = src + i * 16;
+                auto out   = dst + i * 16;
+                uint8_t alpha[16];
+                bc4_pixels<false>(block, alpha);
+                bc1_color(block + 8, false, out, pitch);
+                for (size_t p = 0; p < 16; ++p) {
+                    out[(p / 4) * pitch + (p % 4) * 4 + 3] = alpha[p];
+                }
+            }
+        }
+
+        template<bool snorm>
+        inline void bc4_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            for (size_t i = 0; i < blocks; ++i) {
+                uint8_t red[16];
+                bc4_pixels<snorm>(src + i * 8, red);
+                for (size_t p = 0; p < 16; ++p) {
+                    auto word = rgba(red[p], 0, 0, 255);
+                    std::memcpy(dst + i * 16 + (p / 4) * pitch + (p % 4) * 4, &word, 4);
+                }
+            }
+        }
+
+        template<bool snorm>
+        inline void bc5_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            for (size_t i = 0; i < blocks; ++i) {
+                uint8_t red[16];
+                uint8_t green[16];
+                bc4_pixels<snorm>(src + i * 16, red);
+                bc4_pixels<snorm>(src + i * 16 + 8, green);
+                for (size_t p = 0; p < 16; ++p) {
+                    auto word = rgba(red[p], green[p], 0, 255);
+                    std::memcpy(dst + i * 16 + (p / 4) * pitch + (p % 4) * 4, &word, 4);
+                }
+            }
+        }
+
+#ifdef ASTRA_X86
+        struct alignas(16) shuffle_mask_t {
+            uint8_t bytes[16];
+        };
+
+        // pshufb masks that turn one row byte of BC1 indices (four 2-bit indices) into four rgba8 palette lookups.
+        constexpr std::array<shuffle_mask_t, 256> make_bc1_shuffle() {
+            std::array<shuffle_mask_t, 256> table = {};
+            for (size_t row = 0; row < 256; ++row) {
+                for (size_t x = 0; x < 4; ++x) {
+                    auto index = (row >> (2 * x)) & 3;
+                    for (size_t c = 0; c < 4; ++c) {
+                        table[row].bytes[x * 4 + c] = static_cast<uint8_t>(index * 4 + c);
+                    }
+                }
+            }
+            return table;
+        }
+
+        // pshufb masks that move the four channel values of pixel row `row` into byte `channel` of four rgba8 pixels.
+        constexpr std::array<shuffle_mask_t, 12> make_channel_spread() {
+            std::array<shuffle_mask_t, 12> table = {};
+            for (size_t channel = 0; channel < 3; ++channel) {
+                for (size_t row = 0; row < 4; ++row) {
+                    auto &mask = table[channel * 4 + row];
+                    for (size_t i = 0; i < 16; ++i) {
+                        mask.bytes[i] = 0x80;
+                    }
+                    for (size_t x = 0; x < 4; ++x) {
+                        mask.bytes[x * 4 + (channel == 2 ? 3 : channel)] = static_cast<uint8_t>(row * 4 + x);
+                    }
+                }
+            }
+            return table;
+        }
+
+        inline constexpr std::array<shuffle_mask_t, 256> bc1_shuffle     = make_bc1_shuffle();
+        inline constexpr std::array<shuffle_mask_t, 12> channel_spread   = make_channel_spread(); // red, green, alpha
+
+        constexpr size_t spread_red   = 0;
+        constexpr size_t spread_green = 4;
+        constexpr size_t spread_alpha = 8;
+
+        ASTRA_TARGET("sse4.1") inline __m128i bc1_expand_third(__m128i a, __m128i b) {
+            // (2a + b + 1) / 3, exact for the [0, 766] range the sums fall in.
+            return _mm_mulhi_epu16(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(a, a), b), _mm_set1_epi32(1)), _mm_set1_epi32(21846));
+        }
+
+        ASTRA_TARGET("sse4.1") inline __m128i bc1_pack(__m128i r, __m128i g, __m128i b) { return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_set1_epi32(static_cast<int>(0xFF000000)))); }
+
+        // computes the palettes of four color blocks at once, `endpoints` holds c0 | c1 << 16 of each block.
+        ASTRA_TARGET("sse4.1") inline void bc1_palettes_sse41(__m128i endpoints, bool punch_through, __m128i palettes[4]) {
+            auto low16 = _mm_set1_epi32(0xFFFF);
+            auto c0    = _mm_and_si128(endpoints, low16);
+            auto c1    = _mm_srli_epi32(endpoints, 16);
+
+            auto m5 = _mm_set1_epi32(31);
+            auto m6 = _mm_set1_epi32(63);
+
+            auto r0 = _mm_and_si128(_mm_srli_epi32(c0, 11), m5);
+            auto g0 = _mm_and_si128(_mm_srli_epi32(c0, 5), m6);
+            auto b0 = _mm_and_si128(c0, m5);
+            auto r1 = _mm_and_si128(_mm_srli_epi32(c1, 11), m5);
+            auto g1 = _mm_and_si128(_mm_srli_epi32(c1, 5), m6);
+            auto b1 = _mm_and_si128(c1, m5);
+
+            r0 = _mm_or_si128(_mm_slli_epi32(r0, 3), _mm_srli_epi32(r0, 2));
+            g0 = _mm_or_si128(_mm_slli_epi32(g0, 2), _mm_srli_epi32(g0, 4));
+            b0 = _mm_or_si128(_mm_slli_epi32(b0, 3), _mm_srli_epi32(b0, 2));
+            r1 = _mm_or_si128(_mm_slli_epi32(r1, 3), _mm_srli_epi32(r1, 2));
+            g1 = _mm_or_si128(_mm_slli_epi32(g1, 2), _mm_srli_epi32(g1, 4));
+            b1 = _mm_or_si128(_mm_slli_epi32(b1, 3), _mm_srli_epi32(b1, 2));
+
+            auto p0 = bc1_pack(r0, g0, b0);
+            auto p1 = bc1_pack(r1, g1, b1);
+            auto p2 = bc1_pack(bc1_expand_third(r0, r1), bc1_expand_third(g0, g1), bc1_expand_third(b0, b1));
+            auto p3 = bc1_pack(bc1_expand_third(r1, r0), bc1_expand_third(g1, g0), bc1_expand_third(b1, b0));
+
+            if (punch_through) {
+                auto four = _mm_cmpgt_epi32(c0, c1);
+                auto half = bc1_pack(_mm_avg_epu16(r0, r1), _mm_avg_epu16(g0, g1), _mm_avg_epu16(b0, b1));
+                p2        = _mm_blendv_epi8(half, p2, four);
+                p3        = _mm_and_si128(p3, four);
+            }
+
+            auto t0     = _mm_unpacklo_epi32(p0, p1);
+            auto t1     = _mm_unpacklo_epi32(p2, p3);
+            auto t2     = _mm_unpackhi_epi32(p0, p1);
+            auto t3     = _mm_unpackhi_epi32(p2, p3);
+            palettes[0] = _mm_unpacklo_epi64(t0, t1);
+            palettes[1] = _mm_unpackhi_epi64(t0, t1);
+            palettes[2] = _mm_unpacklo_epi64(t2, t3);
+            palettes[3] = _mm_unpackhi_epi64(t2, t3);
+        }
+
+        // gathers the 32-bit words at `offset` of four blocks `stride` bytes apart.
+        ASTRA_TARGET("sse4.1") inline __m128i gather4(const uint8_t *src, size_t stride, size_t offset) {
+            int32_t words[4];
+            for (size_t i = 0; i < 4; ++i) {
+                std::memcpy(&words[i], src + i * stride + offset, 4);
+            }
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(words));
+        }
+
+        ASTRA_TARGET("sse4.1") inline __m128i bc1_lookup_sse41(__m128i palette, uint32_t bits, size_t row) { return _mm_shuffle_epi8(palette, _mm_load_si128(reinterpret_cast<const __m128i *>(bc1_shuffle[(bits >> (8 * row)) & 0xFF].bytes))); }
+
+        // the 8 palette entries of a channel block as bytes 0-7 (and repeated in 8-15).
+        template<bool snorm>
+        ASTRA_TARGET("sse4.1") inline __m128i bc4_palette_sse41(const uint8_t *block) {
+            int a0 = block[0];
+            int a1 = block[1];
+            int top = 255;
+            if constexpr (snorm) {
+                a0  = std::max<int>(static_cast<int8_t>(block[0]), -127) + 127;
+                a1  = std::max<int>(static_cast<int8_t>(block[1]), -127) + 127;
+                top = 254;
+            }
+
+            auto v0    = _mm_set1_epi16(static_cast<short>(a0));
+            auto v1    = _mm_set1_epi16(static_cast<short>(a1));
+            auto eight = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)), _mm_mullo_epi16(v1, _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6))), _mm_set1_epi16(3));
+            auto six   = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)), _mm_mullo_epi16(v1, _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0))), _mm_set1_epi16(2));
+            eight      = _mm_mulhi_epu16(eight, _mm_set1_epi16(9363));
+            six        = _mm_or_si128(_mm_mulhi_epu16(six, _mm_set1_epi16(13108)), _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, static_cast<short>(top)));
+            auto value = a0 > a1 ? eight : six;
+            if constexpr (snorm) {
+                value = _mm_add_epi16(value, _mm_srli_epi16(value, 7));
+            }
+            return _mm_packus_epi16(value, value);
+        }
+
+        // the 3-bit indices of a channel block spread to one byte per pixel.
+        ASTRA_TARGET("sse4.1") inline __m128i bc4_indices_sse41(const uint8_t *block) {
+            auto bits   = load48(block + 2);
+            uint64_t lo = 0;
+            uint64_t hi = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                lo |= ((bits >> (3 * i)) & 7) << (8 * i);
+                hi |= ((bits >> (24 + 3 * i)) & 7) << (8 * i);
+            }
+            return _mm_set_epi64x(static_cast<int64_t>(hi), static_cast<int64_t>(lo));
+        }
+
+        template<bool snorm>
+        ASTRA_TARGET("sse4.1") inline __m128i bc4_pixels_sse41(const uint8_t *block) { return _mm_shuffle_epi8(bc4_palette_sse41<snorm>(block), bc4_indices_sse41(block)); }
+
+        ASTRA_TARGET("sse4.1") inline __m128i bc2_alpha_sse41(const uint8_t *block) {
+            auto packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(block));
+            auto nibble = _mm_set1_epi8(0x0F);
+            auto alpha  = _mm_unpacklo_epi8(_mm_and_si128(packed, nibble), _mm_and_si128(_mm_srli_epi16(packed, 4), nibble));
+            return _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+        }
+
+        ASTRA_TARGET("sse4.1") inline __m128i spread_sse41(__m128i pixels, size_t which, size_t row) { return _mm_shuffle_epi8(pixels, _mm_load_si128(reinterpret_cast<const __m128i *>(channel_spread[which + row].bytes))); }
+
+        // color blocks are 8 bytes (BC1) or the second half of 16 byte blocks (BC2, BC3).
+        // alpha_mode is 0 for BC1, 2 for explicit BC2 alpha and 3 for interpolated BC3 alpha.
+        template<size_t stride, size_t color_offset, bool punch_through, int alpha_mode>
+        ASTRA_TARGET("sse4.1") void color_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto rgb = _mm_set1_epi32(0x00FFFFFF);
+            size_t i = 0;
+            for (; i + 4 <= blocks; i += 4) {
+                auto block = src + i * stride;
+                __m128i palettes[4];
+                bc1_palettes_sse41(gather4(block, stride, color_offset), punch_through, palettes);
+                for (size_t b = 0; b < 4; ++b) {
+                    auto bits = load32(block + b * stride + color_offset + 4);
+                    auto out  = dst + (i + b) * 16;
+
+                    __m128i alpha = {};
+                    if constexpr (alpha_mode == 2) {
+                        alpha = bc2_alpha_sse41(block + b * stride);
+                    } else if constexpr (alpha_mode == 3) {
+                        alpha = bc4_pixels_sse41<false>(block + b * stride);
+                    }
+
+                    for (size_t y = 0; y < 4; ++y) {
+                        auto color = bc1_lookup_sse41(palettes[b], bits, y);
+                        if constexpr (alpha_mode != 0) {
+                            color = _mm_or_si128(_mm_and_si128(color, rgb), spread_sse41(alpha, spread_alpha, y));
+                        }
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + y * pitch), color);
+                    }
+                }
+            }
+
+            if (i < blocks) {
+                if constexpr (alpha_mode == 0) {
+                    bc1_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                } else if constexpr (alpha_mode == 2) {
+                    bc2_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                } else {
+                    bc3_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                }
+            }
+        }
+
+        ASTRA_TARGET("sse4.1") inline void bc1_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_sse41<8, 0, true, 0>(src, blocks, dst, pitch); }
+
+        ASTRA_TARGET("sse4.1") inline void bc2_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_sse41<16, 8, false, 2>(src, blocks, dst, pitch); }
+
+        ASTRA_TARGET("sse4.1") inline void bc3_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_sse41<16, 8, false, 3>(src, blocks, dst, pitch); }
+
+        template<bool snorm>
+        ASTRA_TARGET("sse4.1") void bc4_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+            for (size_t i = 0; i < blocks; ++i) {
+                auto red = bc4_pixels_sse41<snorm>(src + i * 8);
+                for (size_t y = 0; y < 4; ++y) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 16 + y * pitch), _mm_or_si128(spread_sse41(red, spread_red, y), opaque));
+                }
+            }
+        }
+
+        template<bool snorm>
+        ASTRA_TARGET("sse4.1") void bc5_row_sse41(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+            for (size_t i = 0; i < blocks; ++i) {
+                auto red   = bc4_pixels_sse41<snorm>(src + i * 16);
+                auto green = bc4_pixels_sse41<snorm>(src + i * 16 + 8);
+                for (size_t y = 0; y < 4; ++y) {
+                    auto pixels = _mm_or_si128(spread_sse41(red, spread_red, y), spread_sse41(green, spread_green, y));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 16 + y * pitch), _mm_or_si128(pixels, opaque));
+                }
+            }
+        }
+
+        // the avx2 kernels decode two horizontally adjacent blocks per instruction, one per 128-bit lane,
+        // so every store writes 8 pixels of a row.
+        ASTRA_TARGET("avx2,bmi2") inline __m256i pair(__m128i lo, __m128i hi) { return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1); }
+
+        ASTRA_TARGET("avx2,bmi2") inline __m256i mask_pair(const shuffle_mask_t &lo, const shuffle_mask_t &hi) { return pair(_mm_load_si128(reinterpret_cast<const __m128i *>(lo.bytes)), _mm_load_si128(reinterpret_cast<const __m128i *>(hi.bytes))); }
+
+        ASTRA_TARGET("avx2,bmi2") inline __m256i spread_avx2(__m256i pixels, size_t which, size_t row) { return _mm256_shuffle_epi8(pixels, _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(channel_spread[which + row].bytes)))); }
+
+        ASTRA_TARGET("avx2,bmi2") inline __m128i bc4_indices_avx2(const uint8_t *block) {
+            auto bits = load48(block + 2);
+            auto lo   = _pdep_u64(bits, 0x0707070707070707ull);
+            auto hi   = _pdep_u64(bits >> 24, 0x0707070707070707ull);
+            return _mm_set_epi64x(static_cast<int64_t>(hi), static_cast<int64_t>(lo));
+        }
+
+        template<bool snorm>
+        ASTRA_TARGET("avx2,bmi2") inline __m256i bc4_pixels_avx2(const uint8_t *a, const uint8_t *b) {
+            auto palette = pair(bc4_palette_sse41<snorm>(a), bc4_palette_sse41<snorm>(b));
+            return _mm256_shuffle_epi8(palette, pair(bc4_indices_avx2(a), bc4_indices_avx2(b)));
+        }
+
+        template<size_t stride, size_t color_offset, bool punch_through, int alpha_mode>
+        ASTRA_TARGET("avx2,bmi2") void color_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto rgb = _mm256_set1_epi32(0x00FFFFFF);
+            size_t i = 0;
+            for (; i + 4 <= blocks; i += 4) {
+                auto block = src + i * stride;
+                __m128i palettes[4];
+                bc1_palettes_sse41(gather4(block, stride, color_offset), punch_through, palettes);
+                for (size_t b = 0; b < 4; b += 2) {
+                    auto first   = block + b * stride;
+                    auto second  = first + stride;
+                    auto bits0   = load32(first + color_offset + 4);
+                    auto bits1   = load32(second + color_offset + 4);
+                    auto palette = pair(palettes[b], palettes[b + 1]);
+                    auto out     = dst + (i + b) * 16;
+
+                    __m256i alpha = {};
+                    if constexpr (alpha_mode == 2) {
+                        alpha = pair(bc2_alpha_sse41(first), bc2_alpha_sse41(second));
+                    } else if constexpr (alpha_mode == 3) {
+                        alpha = bc4_pixels_avx2<false>(first, second);
+                    }
+
+                    for (size_t y = 0; y < 4; ++y) {
+                        auto color = _mm256_shuffle_epi8(palette, mask_pair(bc1_shuffle[(bits0 >> (8 * y)) & 0xFF], bc1_shuffle[(bits1 >> (8 * y)) & 0xFF]));
+                        if constexpr (alpha_mode != 0) {
+                            color = _mm256_or_si256(_mm256_and_si256(color, rgb), spread_avx2(alpha, spread_alpha, y));
+                        }
+                        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + y * pitch), color);
+                    }
+                }
+            }
+
+            if (i < blocks) {
+                if constexpr (alpha_mode == 0) {
+                    bc1_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                } else if constexpr (alpha_mode == 2) {
+                    bc2_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                } else {
+                    bc3_row_scalar(src + i * stride, blocks - i, dst + i * 16, pitch);
+                }
+            }
+        }
+
+        ASTRA_TARGET("avx2,bmi2") inline void bc1_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_avx2<8, 0, true, 0>(src, blocks, dst, pitch); }
+
+        ASTRA_TARGET("avx2,bmi2") inline void bc2_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_avx2<16, 8, false, 2>(src, blocks, dst, pitch); }
+
+        ASTRA_TARGET("avx2,bmi2") inline void bc3_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) { color_row_avx2<16, 8, false, 3>(src, blocks, dst, pitch); }
+
+        template<bool snorm>
+        ASTRA_TARGET("avx2,bmi2") void bc4_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+            size_t i    = 0;
+            for (; i + 2 <= blocks; i += 2) {
+                auto red = bc4_pixels_avx2<snorm>(src + i * 8, src + i * 8 + 8);
+                for (size_t y = 0; y < 4; ++y) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 16 + y * pitch), _mm256_or_si256(spread_avx2(red, spread_red, y), opaque));
+                }
+            }
+
+            if (i < blocks) {
+                bc4_row_scalar<snorm>(src + i * 8, blocks - i, dst + i * 16, pitch);
+            }
+        }
+
+        template<bool snorm>
+        ASTRA_TARGET("avx2,bmi2") void bc5_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+            auto opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+            size_t i    = 0;
+            for (; i + 2 <= blocks; i += 2) {
+                auto block = src + i * 16;
+                auto red   = bc4_pixels_avx2<snorm>(block, block + 16);
+                auto green = bc4_pixels_avx2<snorm>(block + 8, block + 24);
+                for (size_t y = 0; y < 4; ++y) {
+                    auto pixels = _mm256_or_si256(spread_avx2(red, spread_red, y), spread_avx2(green, spread_green, y));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 16 + y * pitch), _mm256_or_si256(pixels, opaque));
+                }
+            }
+
+            if (i < blocks) {
+                bc5_row_scalar<snorm>(src + i * 16, blocks - i, dst + i * 16, pitch);
+            }
+        }
+#endif
+
+        enum class bcn_isa { scalar, sse41, avx2 };
+
+        inline bcn_isa best_bcn_isa() {
+#ifdef ASTRA_X86
+            auto &cpu = cpu::current();
+            if (cpu.avx2 && cpu.bmi2) {
+                return bcn_isa::avx2;
+            }
+            if (cpu.sse41) {
+                return bcn_isa::sse41;
+            }
+#endif
+            return bcn_isa::scalar;
+        }
+
+        // returns nullptr for formats that aren't BC1-BC7. BC6H and BC7 have no sse4.1 kernel.
+        inline bcn_row_fn bcn_kernel(dxgi_format_t format, [[maybe_unused]] bcn_isa isa) {
+            using enum dxgi_format_t;
+
+#ifdef ASTRA_X86
+#    define ASTRA_BCN_PICK(scalar_fn, sse41_fn, avx2_fn) (isa == bcn_isa::avx2 ? static_cast<bcn_row_fn>(avx2_fn) : isa == bcn_isa::sse41 ? static_cast<bcn_row_fn>(sse41_fn) : static_cast<bcn_row_fn>(scalar_fn))
+#else
+#    define ASTRA_BCN_PICK(scalar_fn, sse41_fn, avx2_fn) static_cast<bcn_row_fn>(scalar_fn)
+#endif
+            switch (format) {
+                case BC1_TYPELESS:
+                case BC1_UNORM:
+                case BC1_UNORM_SRGB: return ASTRA_BCN_PICK(bc1_row_scalar, bc1_row_sse41, bc1_row_avx2);
+                case BC2_TYPELESS:
+                case BC2_UNORM:
+                case BC2_UNORM_SRGB: return ASTRA_BCN_PICK(bc2_row_scalar, bc2_row_sse41, bc2_row_avx2);
+                case BC3_TYPELESS:
+                case BC3_UNORM:
+                case BC3_UNORM_SRGB: return ASTRA_BCN_PICK(bc3_row_scalar, bc3_row_sse41, bc3_row_avx2);
+                case BC4_TYPELESS:
+                case BC4_UNORM: return ASTRA_BCN_PICK(bc4_row_scalar<false>, bc4_row_sse41<false>, bc4_row_avx2<false>);
+                case BC4_SNORM: return ASTRA_BCN_PICK(bc4_row_scalar<true>, bc4_row_sse41<true>, bc4_row_avx2<true>);
+                case BC5_TYPELESS:
+                case BC5_UNORM: return ASTRA_BCN_PICK(bc5_row_scalar<false>, bc5_row_sse41<false>, bc5_row_avx2<false>);
+                case BC5_SNORM: return ASTRA_BCN_PICK(bc5_row_scalar<true>, bc5_row_sse41<true>, bc5_row_avx2<true>);
+                case BC6H_TYPELESS:
+                case BC6H_UF16: return ASTRA_BCN_PICK(bc6h_row_scalar<false>, bc6h_row_scalar<false>, bc6h_row_avx2<false>);
+                case BC6H_SF16: return ASTRA_BCN_PICK(bc6h_row_scalar<true>, bc6h_row_scalar<true>, bc6h_row_avx2<true>);
+                case BC7_TYPELESS:
+                case BC7_UNORM:
+                case BC7_UNORM_SRGB: return ASTRA_BCN_PICK(bc7_row_scalar, bc7_row_scalar, bc7_row_avx2);
+                default: return nullptr;
+            }
+#undef ASTRA_BCN_PICK
+        }
+
+        // decodes one surface with a given row kernel, ragged right and bottom edges go through a scratch buffer.
+        inline void decode_surface(bcn_row_fn kernel, size_t block_bytes, size_t pixel_bytes, const uint8_t *src, uint32_t width, uint32_t height, uint8_t *dst, size_t dst_pitch, size_t workers) {
+            size_t blocks_wide = std::max<size_t>(1, (width + 3) / 4);
+            size_t blocks_high = std::max<size_t>(1, (height + 3) / 4);
+            size_t full_cols   = width / 4;
+            size_t row_bytes   = static_cast<size_t>(width) * pixel_bytes;
+            size_t block_row   = pixel_bytes * 4; // one row of one decoded block
+
+            // roughly 256k pixels per task, tiny surfaces stay on the calling thread.
+            auto grain = std::max<size_t>(1, (1 << 14) / blocks_wide);
+            parallel::for_ranges(
+                blocks_high, grain,
+                [&](size_t first, size_t last) {
+                    std::vector<uint8_t> scratch;
+                    for (auto by = first; by < last; ++by) {
+                        auto row_src = src + by * blocks_wide * block_bytes;
+                        auto row_dst = dst + by * 4 * dst_pitch;
+                        auto rows    = std::min<size_t>(4, height - by * 4);
+
+                        if (rows < 4) {
+                            scratch.resize(blocks_wide * block_row * 4);
+                            kernel(row_src, blocks_wide, scratch.data(), blocks_wide * block_row);
+                            for (size_t y = 0; y < rows; ++y) {
+                                std::memcpy(row_dst + y * dst_pitch, scratch.data() + y * blocks_wide * block_row, row_bytes);
+                            }
+                            continue;
+                        }
+
+                        if (full_cols > 0) {
+                            kernel(row_src, full_cols, row_dst, dst_pitch);
+                        }
+
+                        if (full_cols < blocks_wide) {
+                            uint8_t edge[128];
+                            kernel(row_src + full_cols * block_bytes, 1, edge, block_row);
+                            for (size_t y = 0; y < 4; ++y) {
+                                std::memcpy(row_dst + y * dst_pitch + full_cols * block_row, edge + y * block_row, row_bytes - full_cols * block_row);
+                            }
+                        }
+                    }
+                },
+                workers);
+        }
+    } // namespace detail
+
+    [[maybe_unused]] inline bool can_decode_bcn(dxgi_format_t format) { return detail::bcn_kernel(format, detail::bcn_isa::scalar) != nullptr; }
+
+    // the format decode_bcn produces: R16G16B16A16_FLOAT for BC6H, R8G8B8A8 (srgb or not) for everything else.
+    [[maybe_unused]] inline dxgi_format_t bcn_decoded_format(dxgi_format_t format) {
+        using enum dxgi_format_t;
+        if (format == BC6H_TYPELESS || format == BC6H_UF16 || format == BC6H_SF16) {
+            return R16G16B16A16_FLOAT;
+        }
+        return is_srgb(format) ? R8G8B8A8_UNORM_SRGB : R8G8B8A8_UNORM;
+    }
+
+    // decodes a width x height BC1-BC7 surface into rows `dst_pitch` bytes apart, block rows are split across `workers` threads.
+    [[maybe_unused]] inline void decode_bcn(dxgi_format_t format, const uint8_t *src, uint32_t width, uint32_t height, uint8_t *dst, size_t dst_pitch, size_t workers = 0) {
+        static const auto isa = detail::best_bcn_isa();
+        auto kernel           = detail::bcn_kernel(format, isa);
+        if (kernel == nullptr) {
+            throw std::invalid_argument("format is not BC1-BC7");
+        }
+
+        detail::decode_surface(kernel, format_info(format).bytes_per_block, format_info(bcn_decoded_format(format)).bits_per_pixel / 8, src, width, height, dst, dst_pitch, workers);
+    }
+
+    // the layout decode_bcn writes a dds payload to: the same subresources in the same order, in bcn_decoded_format.
+    [[maybe_unused]] inline dds_layout bcn_decoded_layout(const dds10_t &header) {
+        dds_layout result(header); // only the format changes, partial legacy cubemaps keep their faces.
+        result.format = bcn_decoded_format(result.format);
+        result.build();
+        return result;
+    }
+
+    // decodes every subresource of a dds payload into `dst`, which must hold at least bcn_decoded_layout(header).payload_size bytes.
+    [[maybe_unused]] inline void decode_bcn(const dds10_t &header, const astra::mem::runtime_array<uint8_t> &payload, astra::mem::runtime_array<uint8_t> &dst, size_t workers = 0) {
+        dds_layout source(header);
+        auto target = bcn_decoded_layout(header);
+        if (!can_decode_bcn(source.format)) {
+            throw std::invalid_argument("format is not BC1-BC7");
+        }
+
+        if (payload.size() < source.payload_size) {
+            throw std::out_of_range("dds payload is smaller than its header describes");
+        }
+
+        if (dst.size() < target.payload_size) {
+            throw std::out_of_range("destination is too small for the decoded surface");
+        }
+
+        for (size_t i = 0; i < source.subresource_count(); ++i) {
+            auto &from = source[i];
+            auto &to   = target[i];
+            for (uint32_t z = 0; z < from.depth; ++z) {
+                decode_bcn(source.format, payload.data() + from.offset + z * from.slice_pitch, from.width, from.height, dst.data() + to.offset + z * to.slice_pitch, to.row_pitch, workers);
+            }
+        }
+    }
+} // namespace astra::gdx
@@ -0,0 +1,906 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bcn.hpp"
+#include "cpu_features.hpp"
+#include "dds_layout.hpp"
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "pixel_convert.hpp"
+#include "runtime_array.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// BC1, BC3, BC4 and BC5 encoding from the RGBA8 pixels decode_bcn produces, so a decode / encode round trip is stable.
+// fast quality fits the color endpoints to the extent of the block along its principal axis. high quality adds a cluster
+// fit: the pixels are ordered along the axis and every split of that order into 4 (or 3) runs is scored with the least
+// squares endpoints of the split, eight splits per avx2 register. channel blocks refine their endpoints by least squares
+// and a small neighbourhood search. every candidate is scored against the palette bcn.hpp decodes, indices are picked
+// with sse2. BC1 pixels with alpha below 128 become transparent, BC4/BC5 read red and green.
+
+namespace astra::gdx {
+    enum class bcn_quality {
+        fast, // range fit.
+        high, // cluster fit, several times slower.
+    };
+
+    struct bcn_encode_options_t {
+        bcn_quality quality = bcn_quality::fast;
+        size_t workers      = 0;
+    };
+
+    namespace detail {
+        // encodes the 16 rgba8 pixels of a block, in pixel order.
+        using bcn_block_fn = void (*)(const uint32_t pixels[16], bool high, uint8_t *dst);
+
+        // snorm channels decode to [0, 255] as v + (v >> 7) for v in [0, 254], this is the inverse.
+        ASTRA_INLINE uint32_t bc4_unmap(uint32_t value, bool snorm) { return snorm ? value - (value >> 7) : value; }
+
+        // the nearest palette entry of every value, ties go to the lower index. returns the squared error.
+        inline uint32_t bc4_assign(const uint8_t values[16], const uint8_t palette[8], uint8_t indices[16]) {
+#ifdef ASTRA_X86
+            auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+            auto best   = _mm_set1_epi8(static_cast<char>(0xFF));
+            auto index  = _mm_setzero_si128();
+            for (int i = 0; i < 8; ++i) {
+                auto entry    = _mm_set1_epi8(static_cast<char>(palette[i]));
+                auto distance = _mm_sub_epi8(_mm_max_epu8(pixels, entry), _mm_min_epu8(pixels, entry));
+                // distance < best, sse2 has no unsigned byte compare.
+                auto closer = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_max_epu8(distance, best), distance), _mm_set1_epi8(-1));
+                best        = _mm_min_epu8(distance, best);
+                index       = _mm_or_si128(_mm_andnot_si128(closer, index), _mm_and_si128(closer, _mm_set1_epi8(static_cast<char>(i))));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), index);
+
+            auto lo  = _mm_unpacklo_epi8(best, _mm_setzero_si128());
+            auto hi  = _mm_unpackhi_epi8(best, _mm_setzero_si128());
+            auto sum = _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi));
+            sum      = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum      = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+#else
+            uint32_t error = 0;
+            for (size_t p = 0; p < 16; ++p) {
+                uint32_t best = 256;
+                for (uint8_t i = 0; i < 8; ++i) {
+                    uint32_t distance = values[p] > palette[i] ? values[p] - palette[i] : palette[i] - values[p];
+                    if (distance < best) {
+                        best       = distance;
+                        indices[p] = i;
+                    }
+                }
+                error += best * best;
+            }
+            return error;
+#endif
+        }
+
+        struct bc4_candidate_t {
+            uint8_t bytes[8] = {};
+            uint32_t error   = std::numeric_limits<uint32_t>::max();
+        };
+
+        // the endpoints of a channel block in the unsigned [0, 255] or [0, 254] space.
+        template<bool snorm>
+        ASTRA_INLINE std::pair<int, int> bc4_endpoints(const uint8_t *block) {
+            if constexpr (snorm) {
+                return {std::max<int>(static_cast<int8_t>(block[0]), -127) + 127, std::max<int>(static_cast<int8_t>(block[1]), -127) + 127};
+            }
+            return {block[0], block[1]};
+        }
+
+        // scores the endpoints (e0, e1) and keeps them when they beat `best`.
+        template<bool snorm>
+        inline void bc4_try(const uint8_t values[16], int e0, int e1, bc4_candidate_t &best) {
+            constexpr int top = snorm ? 254 : 255;
+            if (e0 < 0 || e1 < 0 || e0 > top || e1 > top) {
+                return;
+            }
+
+            uint8_t block[8] = {};
+            block[0]         = static_cast<uint8_t>(snorm ? e0 - 127 : e0);
+            block[1]         = static_cast<uint8_t>(snorm ? e1 - 127 : e1);
+
+            uint8_t palette[8];
+            uint8_t indices[16];
+            bc4_palette<snorm>(block, palette);
+            auto error = bc4_assign(values, palette, indices);
+            if (error >= best.error) {
+                return;
+            }
+
+            uint64_t bits = 0;
+            for (size_t p = 0; p < 16; ++p) {
+                bits |= static_cast<uint64_t>(indices[p]) << (3 * p);
+            }
+            for (size_t i = 0; i < 6; ++i) {
+                block[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+            }
+            std::memcpy(best.bytes, block, sizeof(block));
+            best.error = error;
+        }
+
+        // the least squares endpoints for the indices of `block`. false when the indices can't pin both endpoints down.
+        template<bool snorm>
+        inline bool bc4_refine(const uint8_t values[16], const uint8_t *block, int &e0, int &e1) {
+            constexpr int top = snorm ? 254 : 255;
+            auto [a0, a1]     = bc4_endpoints<snorm>(block);
+            auto eight        = a0 > a1;
+            auto bits         = load48(block + 2);
+
+            double aa = 0.0, ab = 0.0, bb = 0.0, ax = 0.0, bx = 0.0;
+            for (size_t p = 0; p < 16; ++p) {
+                auto index = static_cast<int>((bits >> (3 * p)) & 7);
+                if (!eight && index >= 6) {
+                    continue; // the fixed 0 and top entries don't depend on the endpoints.
+                }
+
+                double weight = index == 0 ? 1.0 : index == 1 ? 0.0 : eight ? (8 - index) / 7.0 : (6 - index) / 5.0;
+                double value  = bc4_unmap(values[p], snorm);
+                aa += weight * weight;
+                ab += weight * (1.0 - weight);
+                bb += (1.0 - weight) * (1.0 - weight);
+                ax += weight * value;
+                bx += (1.0 - weight) * value;
+            }
+
+            auto det = aa * bb - ab * ab;
+            if (std::abs(det) < 1e-9) {
+                return false;
+            }
+
+            e0 = std::clamp(static_cast<int>(std::lround((ax * bb - bx * ab) / det)), 0, top);
+            e1 = std::clamp(static_cast<int>(std::lround((bx * aa - ax * ab) / det)), 0, top);
+            return true;
+        }
+
+        // one BC4 block (BC3 alpha, BC5 red or green) from 16 decoded-space values.
+        template<bool snorm>
+        inline void bc4_encode_block(const uint8_t values[16], bool high, uint8_t *dst) {
+            constexpr int top = snorm ? 254 : 255;
+            int lo = top, hi = 0, inner_lo = top, inner_hi = 0;
+            for (size_t p = 0; p < 16; ++p) {
+                auto value = static_cast<int>(bc4_unmap(values[p], snorm));
+                lo         = std::min(lo, value);
+                hi         = std::max(hi, value);
+                if (value > 0 && value < top) {
+                    inner_lo = std::min(inner_lo, value);
+                    inner_hi = std::max(inner_hi, value);
+                }
+            }
+
+            bc4_candidate_t best;
+            if (lo == hi) {
+                bc4_try<snorm>(values, lo, lo, best);
+                std::memcpy(dst, best.bytes, 8);
+                return;
+            }
+
+            bc4_try<snorm>(values, hi, lo, best);
+            if (high) {
+                // the 6 value mode spends its range on the values between the exact 0 and top entries.
+                if (inner_lo <= inner_hi) {
+                    bc4_try<snorm>(values, inner_lo, inner_hi, best);
+                }
+
+                for (int pass = 0; pass < 2; ++pass) {
+                    int e0 = 0, e1 = 0;
+                    auto before = best.error;
+                    if (!bc4_refine<snorm>(values, best.bytes, e0, e1)) {
+                        break;
+                    }
+                    bc4_try<snorm>(values, e0, e1, best);
+                    if (best.error == before) {
+                        break;
+                    }
+                }
+
+                auto [a0, a1] = bc4_endpoints<snorm>(best.bytes);
+                for (int d0 = -1; d0 <= 1; ++d0) {
+                    for (int d1 = -1; d1 <= 1; ++d1) {
+                        bc4_try<snorm>(values, a0 + d0, a1 + d1, best);
+                    }
+                }
+            }
+            std::memcpy(dst, best.bytes, 8);
+        }
+
+        ASTRA_INLINE uint32_t bc1_expand5(uint32_t value) { return value << 3 | value >> 2; }
+
+        ASTRA_INLINE uint32_t bc1_expand6(uint32_t value) { return value << 2 | value >> 4; }
+
+        ASTRA_INLINE uint16_t bc1_rgb565(uint32_t r, uint32_t g, uint32_t b) { return static_cast<uint16_t>(r << 11 | g << 5 | b); }
+
+        // the 5 or 6 bit value nearest to an 8 bit channel value.
+        ASTRA_INLINE uint32_t bc1_quantize(float value, size_t channel) {
+            auto scale = channel == 1 ? 63.f / 255.f : 31.f / 255.f;
+            return static_cast<uint32_t>(std::nearbyint(std::min(std::max(value, 0.f), 255.f) * scale));
+        }
+
+        ASTRA_INLINE float bc1_expand(uint32_t value, size_t channel) { return static_cast<float>(channel == 1 ? bc1_expand6(value) : bc1_expand5(value)); }
+
+        // the endpoint pairs whose first 4-color interpolant, (2 * e0 + e1 + 1) / 3, comes closest to each 8 bit value.
+        // solid blocks use them to hit colors the 565 grid can't store.
+        struct bc1_single_t {
+            uint8_t e0 = 0;
+            uint8_t e1 = 0;
+        };
+
+        inline const std::array<std::array<bc1_single_t, 256>, 2> &bc1_single_color() {
+            static const auto tables = [] {
+                std::array<std::array<bc1_single_t, 256>, 2> result = {};
+                for (size_t wide = 0; wide < 2; ++wide) {
+                    uint32_t limit = wide != 0 ? 63 : 31;
+                    for (int value = 0; value < 256; ++value) {
+                        int best_error = 256, best_spread = 256;
+                        for (uint32_t q0 = 0; q0 <= limit; ++q0) {
+                            for (uint32_t q1 = 0; q1 <= limit; ++q1) {
+                                int x0     = static_cast<int>(wide != 0 ? bc1_expand6(q0) : bc1_expand5(q0));
+                                int x1     = static_cast<int>(wide != 0 ? bc1_expand6(q1) : bc1_expand5(q1));
+                                int error  = std::abs((2 * x0 + x1 + 1) / 3 - value);
+                                int spread = std::abs(x0 - x1);
+                                if (error < best_error || (error == best_error && spread < best_spread)) {
+                                    best_error           = error;
+                                    best_spread          = spread;
+                                    result[wide][value] = {static_cast<uint8_t>(q0), static_cast<uint8_t>(q1)};
+                                }
+                            }
+                        }
+                    }
+                }
+                return result;
+            }();
+            return tables;
+        }
+
+        // the nearest palette color of every opaque pixel, transparent pixels take index 3 when the palette is in
+        // 3-color mode. returns the squared rgb error, or UINT32_MAX when the palette can't show the transparent pixels.
+        inline uint32_t bc1_assign(const uint32_t pixels[16], uint32_t transparent, const uint32_t palette[4], bool three, uint32_t &bits) {
+            if (transparent != 0 && !three) {
+                return std::numeric_limits<uint32_t>::max();
+            }
+
+            uint32_t best[16];
+            uint32_t index[16];
+            auto entries = three ? 3 : 4;
+#ifdef ASTRA_X86
+            auto zero     = _mm_setzero_si128();
+            auto rgb      = _mm_set1_epi32(0x00FFFFFF);
+            auto distance = [&](__m128i colors, __m128i entry) {
+                auto lo = _mm_sub_epi16(_mm_unpacklo_epi8(colors, zero), _mm_unpacklo_epi8(entry, zero));
+                auto hi = _mm_sub_epi16(_mm_unpackhi_epi8(colors, zero), _mm_unpackhi_epi8(entry, zero));
+                auto a  = _mm_castsi128_ps(_mm_madd_epi16(lo, lo)); // (rg, ba) of pixels 0 and 1
+                auto b  = _mm_castsi128_ps(_mm_madd_epi16(hi, hi)); // and of pixels 2 and 3
+                return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+            };
+
+            for (size_t group = 0; group < 16; group += 4) {
+                auto colors  = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + group)), rgb);
+                auto nearest = distance(colors, _mm_set1_epi32(static_cast<int>(palette[0] & 0x00FFFFFF)));
+                auto which   = _mm_setzero_si128();
+                for (int i = 1; i < entries; ++i) {
+                    auto current = distance(colors, _mm_set1_epi32(static_cast<int>(palette[i] & 0x00FFFFFF)));
+                    auto closer  = _mm_cmplt_epi32(current, nearest);
+                    nearest      = _mm_or_si128(_mm_andnot_si128(closer, nearest), _mm_and_si128(closer, current));
+                    which        = _mm_or_si128(_mm_andnot_si128(closer, which), _mm_and_si128(closer, _mm_set1_epi32(i)));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(best + group), nearest);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(index + group), which);
+            }
+#else
+            auto distance = [](uint32_t a, uint32_t b) {
+                uint32_t sum = 0;
+                for (size_t c = 0; c < 3; ++c) {
+                    int d = static_cast<int>((a >> (8 * c)) & 0xFF) - static_cast<int>((b >> (8 * c)) & 0xFF);
+                    sum += static_cast<uint32_t>(d * d);
+                }
+                return sum;
+            };
+
+            for (size_t p = 0; p < 16; ++p) {
+                best[p]  = distance(pixels[p], palette[0]);
+                index[p] = 0;
+                for (uint32_t i = 1; i < static_cast<uint32_t>(entries); ++i) {
+                    auto current = distance(pixels[p], palette[i]);
+                    if (current < best[p]) {
+                        best[p]  = current;
+                        index[p] = i;
+                    }
+                }
+            }
+#endif
+            uint32_t error = 0;
+            bits           = 0;
+            for (size_t p = 0; p < 16; ++p) {
+                if ((transparent >> p) & 1) {
+                    bits |= 3u << (2 * p);
+                    continue;
+                }
+                bits |= index[p] << (2 * p);
+                error += best[p];
+            }
+            return error;
+        }
+
+        // the opaque pixels of a color block as floats, with their mean and principal axis.
+        struct bc1_points_t {
+            float rgb[16][3] = {};
+            uint32_t count   = 0;
+            float mean[3]    = {};
+            float axis[3]    = {}; // zero when every point is the same.
+        };
+
+        inline void bc1_principal_axis(bc1_points_t &points) {
+            // the covariance from plain and product sums in one pass, the sums of 16 8-bit values are exact in floats.
+            float sum[3] = {}, product[6] = {};
+            for (uint32_t p = 0; p < points.count; ++p) {
+                auto &rgb = points.rgb[p];
+                for (size_t c = 0; c < 3; ++c) {
+                    sum[c] += rgb[c];
+                }
+                product[0] += rgb[0] * rgb[0];
+                product[1] += rgb[0] * rgb[1];
+                product[2] += rgb[0] * rgb[2];
+                product[3] += rgb[1] * rgb[1];
+                product[4] += rgb[1] * rgb[2];
+                product[5] += rgb[2] * rgb[2];
+            }
+
+            auto inverse = 1.f / static_cast<float>(std::max<uint32_t>(points.count, 1));
+            for (size_t c = 0; c < 3; ++c) {
+                points.mean[c] = sum[c] * inverse;
+            }
+
+            float covariance[3][3];
+            covariance[0][0] = product[0] - sum[0] * points.mean[0];
+            covariance[0][1] = covariance[1][0] = product[1] - sum[0] * points.mean[1];
+            covariance[0][2] = covariance[2][0] = product[2] - sum[0] * points.mean[2];
+            covariance[1][1] = product[3] - sum[1] * points.mean[1];
+            covariance[1][2] = covariance[2][1] = product[4] - sum[1] * points.mean[2];
+            covariance[2][2] = product[5] - sum[2] * points.mean[2];
+
+            // power iteration, starting from the column with the most variance so colors that only differ in
+            // one channel converge too.
+            size_t widest = 0;
+            for (size_t c = 1; c < 3; ++c) {
+                widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+            }
+            if (covariance[widest][widest] < 1e-2f) {
+                return;
+            }
+
+            float axis[3] = {covariance[0][widest], covariance[1][widest], covariance[2][widest]};
+            for (int iteration = 0; iteration < 4; ++iteration) {
+                float next[3];
+                for (size_t r = 0; r < 3; ++r) {
+                    next[r] = covariance[r][0] * axis[0] + covariance[r][1] * axis[1] + covariance[r][2] * axis[2];
+                }
+                auto largest = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+                if (largest < 1e-12f) {
+                    return;
+                }
+                auto scale = 1.f / largest;
+                for (size_t c = 0; c < 3; ++c) {
+                    axis[c] = next[c] * scale;
+                }
+            }
+
+            auto scale = 1.f / std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            for (size_t c = 0; c < 3; ++c) {
+                points.axis[c] = axis[c] * scale;
+            }
+        }
+
+        // the quantized endpoints at the extent of the points along their principal axis.
+        inline std::pair<uint16_t, uint16_t> bc1_range_fit(const bc1_points_t &points) {
+            float low = 0.f, high = 0.f;
+            for (uint32_t p = 0; p < points.count; ++p) {
+                float t = 0.f;
+                for (size_t c = 0; c < 3; ++c) {
+                    t += (points.rgb[p][c] - points.mean[c]) * points.axis[c];
+                }
+                low  = std::min(low, t);
+                high = std::max(high, t);
+            }
+
+            uint32_t a[3], b[3];
+            for (size_t c = 0; c < 3; ++c) {
+                a[c] = bc1_quantize(points.mean[c] + points.axis[c] * low, c);
+                b[c] = bc1_quantize(points.mean[c] + points.axis[c] * high, c);
+            }
+            return {bc1_rgb565(a[0], a[1], a[2]), bc1_rgb565(b[0], b[1], b[2])};
+        }
+
+        // prefix sums of the ordered points per channel, padded so a full register can be loaded past the last one.
+        inline constexpr size_t bc1_prefix_size = 32;
+        inline constexpr float bc1_min_det     = 1e-3f;
+
+        struct bc1_cluster_t {
+            float error = std::numeric_limits<float>::infinity();
+            uint32_t i  = 0; // the runs are [0, i), [i, j), [j, k) and [k, count), 3-color splits leave k unused.
+            uint32_t j  = 0;
+            uint32_t k  = 0;
+        };
+
+        using bc1_search_fn = void (*)(const float prefix[3][bc1_prefix_size], uint32_t count, bc1_cluster_t &best);
+
+        // the error of the least squares endpoints of a split, up to a constant, after snapping them to the 565 grid.
+        // the avx2 search evaluates the same expressions in the same order.
+        inline float bc1_cluster_error(float alpha2, float beta2, float alphabeta, const float alphax[3], const float betax[3], uint32_t *quantized = nullptr) {
+            auto det = alpha2 * beta2 - alphabeta * alphabeta;
+            if (!(det >= bc1_min_det)) {
+                return std::numeric_limits<float>::infinity();
+            }
+
+            auto inverse = 1.f / det;
+            auto error   = 0.f;
+            for (size_t c = 0; c < 3; ++c) {
+                auto qa = bc1_quantize((alphax[c] * beta2 - betax[c] * alphabeta) * inverse, c);
+                auto qb = bc1_quantize((betax[c] * alpha2 - alphax[c] * alphabeta) * inverse, c);
+                auto a  = bc1_expand(qa, c);
+                auto b  = bc1_expand(qb, c);
+                auto s  = a * a * alpha2 + b * b * beta2;
+                auto u  = a * b * alphabeta - a * alphax[c] - b * betax[c];
+                error   = error + (s + 2.f * u);
+                if (quantized != nullptr) {
+                    quantized[c]     = qa;
+                    quantized[c + 3] = qb;
+                }
+            }
+            return error;
+        }
+
+        // the weights of the runs are 1, 2/3, 1/3 and 0 for 4-color splits, 1, 1/2 and 0 for 3-color splits.
+        struct bc1_weights {
+            static constexpr float w23 = 2.f / 3.f;
+            static constexpr float w13 = 1.f / 3.f;
+            static constexpr float w49 = 4.f / 9.f;
+            static constexpr float w19 = 1.f / 9.f;
+            static constexpr float w29 = 2.f / 9.f;
+            static constexpr float w12 = 0.5f;
+            static constexpr float w14 = 0.25f;
+        };
+
+        inline float bc1_split4(const float prefix[3][bc1_prefix_size], uint32_t count, uint32_t i, uint32_t j, uint32_t k, uint32_t *quantized = nullptr) {
+            using w   = bc1_weights;
+            auto n0   = static_cast<float>(i);
+            auto n1   = static_cast<float>(j) - static_cast<float>(i);
+            auto n2   = static_cast<float>(k) - static_cast<float>(j);
+            auto n3   = static_cast<float>(count) - static_cast<float>(k);
+            auto head = n0 + w::w49 * n1;
+
+            float alphax[3], betax[3];
+            for (size_t c = 0; c < 3; ++c) {
+                auto x0   = prefix[c][i];
+                auto x1   = prefix[c][j] - prefix[c][i];
+                auto x2   = prefix[c][k] - prefix[c][j];
+                auto x3   = prefix[c][count] - prefix[c][k];
+                alphax[c] = (x0 + w::w23 * x1) + w::w13 * x2;
+                betax[c]  = (x3 + w::w23 * x2) + w::w13 * x1;
+            }
+            return bc1_cluster_error(head + w::w19 * n2, (n3 + w::w49 * n2) + w::w19 * n1, w::w29 * (n1 + n2), alphax, betax, quantized);
+        }
+
+        inline float bc1_split3(const float prefix[3][bc1_prefix_size], uint32_t count, uint32_t i, uint32_t j, uint32_t *quantized = nullptr) {
+            using w = bc1_weights;
+            auto n0 = static_cast<float>(i);
+            auto n1 = static_cast<float>(j) - static_cast<float>(i);
+            auto n2 = static_cast<float>(count) - static_cast<float>(j);
+
+            float alphax[3], betax[3];
+            for (size_t c = 0; c < 3; ++c) {
+                auto x1   = prefix[c][j] - prefix[c][i];
+                alphax[c] = prefix[c][i] + w::w12 * x1;
+                betax[c]  = (prefix[c][count] - prefix[c][j]) + w::w12 * x1;
+            }
+            return bc1_cluster_error(n0 + w::w14 * n1, n2 + w::w14 * n1, w::w14 * n1, alphax, betax, quantized);
+        }
+
+        inline void bc1_search4_scalar(const float prefix[3][bc1_prefix_size], uint32_t count, bc1_cluster_t &best) {
+            for (uint32_t i = 0; i <= count; ++i) {
+                for (uint32_t j = i; j <= count; ++j) {
+                    for (uint32_t k = j; k <= count; ++k) {
+                        auto error = bc1_split4(prefix, count, i, j, k);
+                        if (error < best.error) {
+                            best = {error, i, j, k};
+                        }
+                    }
+                }
+            }
+        }
+
+        inline void bc1_search3_scalar(const float prefix[3][bc1_prefix_size], uint32_t count, bc1_cluster_t &best) {
+            for (uint32_t i = 0; i <= count; ++i) {
+                for (uint32_t j = i; j <= count; ++j) {
+                    auto error = bc1_split3(prefix, count, i, j);
+                    if (error < best.error) {
+                        best = {error, i, j, count};
+                    }
+                }
+            }
+        }
+
+#ifdef ASTRA_X86
+        ASTRA_TARGET("avx2") inline __m256 bc1_quantize_avx2(__m256 value, size_t channel) {
+            auto scale = _mm256_set1_ps(channel == 1 ? 63.f / 255.f : 31.f / 255.f);
+            auto q     = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(255.f)), scale));
+            auto wide  = channel == 1 ? _mm256_or_si256(_mm256_slli_epi32(q, 2), _mm256_srli_epi32(q, 4)) : _mm256_or_si256(_mm256_slli_epi32(q, 3), _mm256_srli_epi32(q, 2));
+            return _mm256_cvtepi32_ps(wide);
+        }
+
+        // bc1_cluster_error for eight splits at once.
+        ASTRA_TARGET("avx2") inline __m256 bc1_cluster_error_avx2(__m256 alpha2, __m256 beta2, __m256 alphabeta, const __m256 alphax[3], const __m256 betax[3]) {
+            auto det     = _mm256_sub_ps(_mm256_mul_ps(alpha2, beta2), _mm256_mul_ps(alphabeta, alphabeta));
+            auto valid   = _mm256_cmp_ps(det, _mm256_set1_ps(bc1_min_det), _CMP_GE_OQ);
+            auto inverse = _mm256_div_ps(_mm256_set1_ps(1.f), det);
+            auto error   = _mm256_setzero_ps();
+            for (size_t c = 0; c < 3; ++c) {
+                auto a = bc1_quantize_avx2(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(alphax[c], beta2), _mm256_mul_ps(betax[c], alphabeta)), inverse), c);
+                auto b = bc1_quantize_avx2(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(betax[c], alpha2), _mm256_mul_ps(alphax[c], alphabeta)), inverse), c);
+                auto s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(a, a), alpha2), _mm256_mul_ps(_mm256_mul_ps(b, b), beta2));
+                auto u = _mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(a, b), alphabeta), _mm256_mul_ps(a, alphax[c])), _mm256_mul_ps(b, betax[c]));
+                error  = _mm256_add_ps(error, _mm256_add_ps(s, _mm256_mul_ps(_mm256_set1_ps(2.f), u)));
+            }
+            return _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::infinity()), error, valid);
+        }
+
+        // lanes past the last split are masked out, the first lane with a new minimum wins like in the scalar loop.
+        ASTRA_TARGET("avx2") inline int bc1_keep_best_avx2(__m256 error, __m256 position, float last, float &best) {
+            auto valid = _mm256_and_ps(_mm256_cmp_ps(position, _mm256_set1_ps(last), _CMP_LE_OQ), _mm256_cmp_ps(error, _mm256_set1_ps(best), _CMP_LT_OQ));
+            if (_mm256_movemask_ps(valid) == 0) {
+                return -1;
+            }
+
+            error = _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::infinity()), error, valid);
+            alignas(32) float errors[8];
+            _mm256_store_ps(errors, error);
+            int lane = -1;
+            for (int l = 0; l < 8; ++l) {
+                if (errors[l] < best) {
+                    best = errors[l];
+                    lane = l;
+                }
+            }
+            return lane;
+        }
+
+        ASTRA_TARGET("avx2") inline void bc1_search4_avx2(const float prefix[3][bc1_prefix_size], uint32_t count, bc1_cluster_t &best) {
+            using w    = bc1_weights;
+            auto lanes = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+            auto total = static_cast<float>(count);
+            for (uint32_t i = 0; i <= count; ++i) {
+                for (uint32_t j = i; j <= count; ++j) {
+                    auto n0   = static_cast<float>(i);
+                    auto n1   = static_cast<float>(j) - static_cast<float>(i);
+                    auto head = n0 + w::w49 * n1;
+
+                    float x0[3], x1[3], alpha_head[3], beta_tail[3];
+                    for (size_t c = 0; c < 3; ++c) {
+                        x0[c]         = prefix[c][i];
+                        x1[c]         = prefix[c][j] - prefix[c][i];
+                        alpha_head[c] = x0[c] + w::w23 * x1[c];
+                        beta_tail[c]  = w::w13 * x1[c];
+                    }
+
+                    for (uint32_t k = j; k <= count; k += 8) {
+                        auto position = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(k)), lanes);
+                        auto n2       = _mm256_sub_ps(position, _mm256_set1_ps(static_cast<float>(j)));
+                        auto n3       = _mm256_sub_ps(_mm256_set1_ps(total), position);
+                        auto alpha2   = _mm256_add_ps(_mm256_set1_ps(head), _mm256_mul_ps(_mm256_set1_ps(w::w19), n2));
+                        auto beta2    = _mm256_add_ps(_mm256_add_ps(n3, _mm256_mul_ps(_mm256_set1_ps(w::w49), n2)), _mm256_mul_ps(_mm256_set1_ps(w::w19), _mm256_set1_ps(n1)));
+                        auto ab       = _mm256_mul_ps(_mm256_set1_ps(w::w29), _mm256_add_ps(_mm256_set1_ps(n1), n2));
+
+                        __m256 alphax[3], betax[3];
+                        for (size_t c = 0; c < 3; ++c) {
+                            auto pk   = _mm256_loadu_ps(prefix[c] + k);
+                            auto x2   = _mm256_sub_ps(pk, _mm256_set1_ps(prefix[c][j]));
+                            auto x3   = _mm256_sub_ps(_mm256_set1_ps(prefix[c][count]), pk);
+                            alphax[c] = _mm256_add_ps(_mm256_set1_ps(alpha_head[c]), _mm256_mul_ps(_mm256_set1_ps(w::w13), x2));
+                            betax[c]  = _mm256_add_ps(_mm256_add_ps(x3, _mm256_mul_ps(_mm256_set1_ps(w::w23), x2)), _mm256_set1_ps(beta_tail[c]));
+                        }
+
+                        auto lane = bc1_keep_best_avx2(bc1_cluster_error_avx2(alpha2, beta2, ab, alphax, betax), position, total, best.error);
+                        if (lane >= 0) {
+                            best.i = i;
+                            best.j = j;
+                            best.k = k + static_cast<uint32_t>(lane);
+                        }
+                    }
+                }
+            }
+        }
+
+        ASTRA_TARGET("avx2") inline void bc1_search3_avx2(const float prefix[3][bc1_prefix_size], uint32_t count, bc1_cluster_t &best) {
+            using w    = bc1_weights;
+            auto lanes = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+            auto total = static_cast<float>(count);
+            for (uint32_t i = 0; i <= count; ++i) {
+                auto n0 = _mm256_set1_ps(static_cast<float>(i));
+                for (uint32_t j = i; j <= count; j += 8) {
+                    auto position = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(j)), lanes);
+                    auto n1       = _mm256_sub_ps(position, _mm256_set1_ps(static_cast<float>(i)));
+                    auto n2       = _mm256_sub_ps(_mm256_set1_ps(total), position);
+                    auto quarter  = _mm256_mul_ps(_mm256_set1_ps(w::w14), n1);
+
+                    __m256 alphax[3], betax[3];
+                    for (size_t c = 0; c < 3; ++c) {
+                        auto pj   = _mm256_loadu_ps(prefix[c] + j);
+                        auto half = _mm256_mul_ps(_mm256_set1_ps(w::w12), _mm256_sub_ps(pj, _mm256_set1_ps(prefix[c][i])));
+                        alphax[c] = _mm256_add_ps(_mm256_set1_ps(prefix[c][i]), half);
+                        betax[c]  = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(prefix[c][count]), pj), half);
+                    }
+
+                    auto lane = bc1_keep_best_avx2(bc1_cluster_error_avx2(_mm256_add_ps(n0, quarter), _mm256_add_ps(n2, quarter), quarter, alphax, betax), position, total, best.error);
+                    if (lane >= 0) {
+                        best = {best.error, i, j + static_cast<uint32_t>(lane), count};
+                    }
+                }
+            }
+        }
+#endif
+
+        inline std::pair<bc1_search_fn, bc1_search_fn> bc1_searches() {
+#ifdef ASTRA_X86
+            if (best_bcn_isa() == bcn_isa::avx2) {
+                return {bc1_search4_avx2, bc1_search3_avx2};
+            }
+#endif
+            return {bc1_search4_scalar, bc1_search3_scalar};
+        }
+
+        // orders the points along their principal axis and returns the endpoints of the best split, first the end the
+        // heavy runs lean to. reordering along the axis between the endpoints found and searching again gains next to
+        // nothing for twice the time.
+        inline bool bc1_cluster_fit(const bc1_points_t &points, bool four, std::pair<uint16_t, uint16_t> &endpoints) {
+            static const auto searches = bc1_searches();
+
+            std::pair<float, uint8_t> keys[16];
+            for (uint32_t p = 0; p < points.count; ++p) {
+                keys[p] = {points.rgb[p][0] * points.axis[0] + points.rgb[p][1] * points.axis[1] + points.rgb[p][2] * points.axis[2], static_cast<uint8_t>(p)};
+            }
+            std::sort(keys, keys + points.count);
+
+            float prefix[3][bc1_prefix_size] = {};
+            for (size_t c = 0; c < 3; ++c) {
+                for (uint32_t p = 0; p < points.count; ++p) {
+                    prefix[c][p + 1] = prefix[c][p] + points.rgb[keys[p].second][c];
+                }
+                std::fill(prefix[c] + points.count + 1, prefix[c] + bc1_prefix_size, prefix[c][points.count]);
+            }
+
+            bc1_cluster_t best;
+            (four ? searches.first : searches.second)(prefix, points.count, best);
+            if (!(best.error < std::numeric_limits<float>::infinity())) {
+                return false;
+            }
+
+            uint32_t q[6];
+            if (four) {
+                bc1_split4(prefix, points.count, best.i, best.j, best.k, q);
+            } else {
+                bc1_split3(prefix, points.count, best.i, best.j, q);
+            }
+            endpoints = {bc1_rgb565(q[0], q[1], q[2]), bc1_rgb565(q[3], q[4], q[5])};
+            return true;
+        }
+
+        // one BC1 color block, or the color half of a BC3 block when `bc1` is false.
+        inline void bc1_encode_color(const uint32_t pixels[16], bool bc1, bool high, uint8_t *dst) {
+            uint32_t transparent = 0;
+            bc1_points_t points;
+            for (size_t p = 0; p < 16; ++p) {
+                if (bc1 && (pixels[p] >> 24) < 128) {
+                    transparent |= 1u << p;
+                    continue;
+                }
+                for (size_t c = 0; c < 3; ++c) {
+                    points.rgb[points.count][c] = static_cast<float>((pixels[p] >> (8 * c)) & 0xFF);
+                }
+                points.count++;
+            }
+
+            uint8_t best_block[8] = {0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF}; // all transparent.
+            auto best_error       = std::numeric_limits<uint32_t>::max();
+            if (points.count == 0) {
+                std::memcpy(dst, best_block, 8);
+                return;
+            }
+
+            // 4-color blocks need c0 > c1 and 3-color blocks c0 <= c1, the indices are picked against the decoded
+            // palette afterwards so swapping the endpoints needs no remapping.
+            auto attempt = [&](uint16_t a, uint16_t b, bool three) {
+                auto c0          = three ? std::min(a, b) : std::max(a, b);
+                auto c1          = three ? std::max(a, b) : std::min(a, b);
+                uint8_t block[8] = {static_cast<uint8_t>(c0), static_cast<uint8_t>(c0 >> 8), static_cast<uint8_t>(c1), static_cast<uint8_t>(c1 >> 8)};
+
+                uint32_t palette[4];
+                uint32_t bits = 0;
+                bc1_palette(block, bc1, palette);
+                auto error = bc1_assign(pixels, transparent, palette, bc1 && c0 <= c1, bits);
+                if (error < best_error) {
+                    std::memcpy(block + 4, &bits, 4);
+                    std::memcpy(best_block, block, 8);
+                    best_error = error;
+                }
+            };
+
+            bc1_principal_axis(points);
+            auto need_three = transparent != 0;
+            auto solid      = points.axis[0] == 0.f && points.axis[1] == 0.f && points.axis[2] == 0.f;
+            if (solid && !need_three) {
+                auto &tables = bc1_single_color();
+                auto r       = tables[0][static_cast<uint32_t>(points.rgb[0][0])];
+                auto g       = tables[1][static_cast<uint32_t>(points.rgb[0][1])];
+                auto b       = tables[0][static_cast<uint32_t>(points.rgb[0][2])];
+                attempt(bc1_rgb565(r.e0, g.e0, b.e0), bc1_rgb565(r.e1, g.e1, b.e1), false);
+            }
+
+            auto range = bc1_range_fit(points);
+            attempt(range.first, range.second, need_three);
+
+            if (high && !solid) {
+                std::pair<uint16_t, uint16_t> endpoints;
+                if (!need_three && bc1_cluster_fit(points, true, endpoints)) {
+                    attempt(endpoints.first, endpoints.second, false);
+                }
+                if (bc1 && need_three && bc1_cluster_fit(points, false, endpoints)) {
+                    attempt(endpoints.first, endpoints.second, true);
+                }
+            }
+            std::memcpy(dst, best_block, 8);
+        }
+
+        // the channel `which` of a block, 0 red, 1 green and 3 alpha.
+        ASTRA_INLINE void bcn_channel(const uint32_t pixels[16], size_t which, uint8_t values[16]) {
+            for (size_t p = 0; p < 16; ++p) {
+                values[p] = static_cast<uint8_t>(pixels[p] >> (8 * which));
+            }
+        }
+
+        inline void bc1_block(const uint32_t pixels[16], bool high, uint8_t *dst) { bc1_encode_color(pixels, true, high, dst); }
+
+        inline void bc3_block(const uint32_t pixels[16], bool high, uint8_t *dst) {
+            uint8_t alpha[16];
+            bcn_channel(pixels, 3, alpha);
+            bc4_encode_block<false>(alpha, high, dst);
+            bc1_encode_color(pixels, false, high, dst + 8);
+        }
+
+        template<bool snorm>
+        inline void bc4_block(const uint32_t pixels[16], bool high, uint8_t *dst) {
+            uint8_t red[16];
+            bcn_channel(pixels, 0, red);
+            bc4_encode_block<snorm>(red, high, dst);
+        }
+
+        template<bool snorm>
+        inline void bc5_block(const uint32_t pixels[16], bool high, uint8_t *dst) {
+            uint8_t red[16];
+            uint8_t green[16];
+            bcn_channel(pixels, 0, red);
+            bcn_channel(pixels, 1, green);
+            bc4_encode_block<snorm>(red, high, dst);
+            bc4_encode_block<snorm>(green, high, dst + 8);
+        }
+
+        // returns nullptr for formats other than BC1, BC3, BC4 and BC5.
+        inline bcn_block_fn bcn_encoder(dxgi_format_t format) {
+            using enum dxgi_format_t;
+            switch (format) {
+                case BC1_TYPELESS:
+                case BC1_UNORM:
+                case BC1_UNORM_SRGB: return bc1_block;
+                case BC3_TYPELESS:
+                case BC3_UNORM:
+                case BC3_UNORM_SRGB: return bc3_block;
+                case BC4_TYPELESS:
+                case BC4_UNORM: return bc4_block<false>;
+                case BC4_SNORM: return bc4_block<true>;
+                case BC5_TYPELESS:
+                case BC5_UNORM: return bc5_block<false>;
+                case BC5_SNORM: return bc5_block<true>;
+                default: return nullptr;
+            }
+        }
+
+        // encodes one surface, block rows are split across threads. blocks past the right and bottom edges repeat the
+        // last column and row.
+        inline void encode_surface(bcn_block_fn encoder, size_t block_bytes, const uint8_t *src, uint32_t width, uint32_t height, size_t src_pitch, uint8_t *dst, bool high, size_t workers) {
+            size_t blocks_wide = std::max<size_t>(1, (width + 3) / 4);
+            size_t blocks_high = std::max<size_t>(1, (height + 3) / 4);
+
+            // encoding costs far more than decoding, so roughly 4k blocks per task.
+            auto grain = std::max<size_t>(1, (1 << 12) / blocks_wide);
+            parallel::for_ranges(
+                blocks_high, grain,
+                [&](size_t first, size_t last) {
+                    uint32_t pixels[16];
+                    for (auto by = first; by < last; ++by) {
+                        for (size_t bx = 0; bx < blocks_wide; ++bx) {
+                            for (size_t y = 0; y < 4; ++y) {
+                                auto row = src + std::min<size_t>(by * 4 + y, height - 1) * src_pitch;
+                                for (size_t x = 0; x < 4; ++x) {
+                                    std::memcpy(pixels + y * 4 + x, row + std::min<size_t>(bx * 4 + x, width - 1) * 4, 4);
+                                }
+                            }
+                            encoder(pixels, high, dst + (by * blocks_wide + bx) * block_bytes);
+                        }
+                    }
+                },
+                workers);
+        }
+    } // namespace detail
+
+    [[maybe_unused]] inline bool can_encode_bcn(dxgi_format_t format) { return detail::bcn_encoder(format) != nullptr; }
+
+    // encodes a width x height surface of bcn_decoded_format(format) pixels, rows `src_pitch` bytes apart, into
+    // consecutive blocks at `dst`.
+    [[maybe_unused]] inline void encode_bcn(dxgi_format_t format, const uint8_t *src, uint32_t width, uint32_t height, size_t src_pitch, uint8_t *dst, const bcn_encode_options_t &options = {}) {
+        auto encoder = detail::bcn_encoder(format);
+        if (encoder == nullptr) {
+            throw std::invalid_argument("format is not BC1, BC3, BC4 or BC5");
+        }
+
+        detail::encode_surface(encoder, format_info(format).bytes_per_block, src, width, height, src_pitch, dst, options.quality == bcn_quality::high, options.workers);
+    }
+
+    // encodes every subresource of an uncompressed dds payload to `format` and returns a complete dds file: the header
+    // of the new layout, made by dds_layout::header(), followed by the payload. sources in another format than
+    // bcn_decoded_format(format) are converted first, one subresource at a time.
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> encode_bcn_dds(const dds_layout &source, const astra::mem::runtime_array<uint8_t> &payload, dxgi_format_t format, const bcn_encode_options_t &options = {}) {
+        if (!can_encode_bcn(format)) {
+            throw std::invalid_argument("format is not BC1, BC3, BC4 or BC5");
+        }
+
+        auto pixels  = bcn_decoded_format(format);
+        auto convert = source.format != pixels;
+        if (convert && !can_convert(source.format, pixels)) {
+            throw std::invalid_argument("source format can't be converted to RGBA8");
+        }
+
+        if (payload.size() < source.payload_size) {
+            throw std::out_of_range("dds payload is smaller than its header describes");
+        }
+
+        auto target   = source; // only the format changes, partial legacy cubemaps keep their faces.
+        target.format = format;
+        target.build();
+        astra::mem::runtime_array<uint8_t> result(nullptr, sizeof(dds10_t) + target.payload_size);
+        auto header = target.header();
+        std::memcpy(result.data(), &header, sizeof(header));
+
+        std::vector<uint8_t> scratch;
+        for (size_t i = 0; i < source.subresource_count(); ++i) {
+            auto &from = source[i];
+            auto &to   = target[i];
+            for (uint32_t z = 0; z < from.depth; ++z) {
+                auto src   = payload.data() + from.offset + z * from.slice_pitch;
+                auto pitch = static_cast<size_t>(from.row_pitch);
+                if (convert) {
+                    size_t count = static_cast<size_t>(from.width) * from.height;
+                    scratch.resize(count * 4);
+                    gdx::convert(source.format, pixels, src, scratch.data(), count, options.workers);
+                    src   = scratch.data();
+                    pitch = static_cast<size_t>(from.width) * 4;
+                }
+                encode_bcn(format, src, from.width, from.height, pitch, result.data() + sizeof(dds10_t) + to.offset + z * to.slice_pitch, options);
+            }
+        }
+        return result;
+    }
+
+    // the same for a payload described by a dds header.
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> encode_bcn_dds(const dds10_t &header, const astra::mem::runtime_array<uint8_t> &payload, dxgi_format_t format, const bcn_encode_options_t &options = {}) { return encode_bcn_dds(dds_layout(header), payload, format, options); }
+} // namespace astra::gdx
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "byteswap.hpp"
+#include "runtime_array.hpp"
+
+// bounds-checked cursors over a runtime_array<uint8_t>, which may be a heap buffer, a read_file slab view or a map_file
+// mapping. every call checks its whole range once, values are loaded and stored with memcpy so nothing has to be
+// aligned, and the data can be in either byte order: scalars and structs with a mem::byte_layout are swapped in bulk by
+// byteswap.hpp. read_array hands out views of the buffer itself when the data is aligned for the type and already in
+// host order, so bulk reads of native tables cost nothing.
+
+namespace astra::io {
+    namespace detail {
+        // copies `count` values from unaligned bytes, swapping each one when `swap` is set. large arrays are swapped on
+        // the worker pool.
+        template<typename U>
+        inline void load_values(const uint8_t *src, U *dst, size_t count, bool swap) {
+            if constexpr (astra::mem::byte_swappable<U> && sizeof(U) > 1) {
+                if (swap) {
+                    if (count == 1) {
+                        U value;
+                        std::memcpy(&value, src, sizeof(U));
+                        *dst = astra::mem::byteswap_value(value);
+                    } else {
+                        astra::mem::byteswap_copy<U>(src, dst, count);
+                    }
+                    return;
+                }
+            }
+            std::memcpy(dst, src, count * sizeof(U));
+        }
+
+        template<typename U>
+        inline void store_values(const U *src, uint8_t *dst, size_t count, bool swap) {
+            if constexpr (astra::mem::byte_swappable<U> && sizeof(U) > 1) {
+                if (swap) {
+                    if (count == 1) {
+                        auto value = astra::mem::byteswap_value(*src);
+                        std::memcpy(dst, &value, sizeof(U));
+                    } else {
+                        astra::mem::byteswap_copy<U>(src, dst, count);
+                    }
+                    return;
+                }
+            }
+            std::memcpy(dst, src, count * sizeof(U));
+        }
+
+        // types without a byte_layout only move in host order.
+        template<typename U>
+        inline void check_order(bool swap) {
+            if constexpr (!astra::mem::byte_swappable<U> && sizeof(U) > 1) {
+                if (swap) {
+                    throw std::invalid_argument("type has no byte_layout for byte order conversion");
+                }
+            }
+        }
+    } // namespace detail
+
+    class binary_reader {
+    private:
+        astra::mem::runtime_array<uint8_t> buffer;
+        size_t position = 0;
+        bool swap       = false;
+
+        // the one range check per call, returns where the range starts.
+        const uint8_t *take(size_t bytes) {
+            if (bytes > buffer.size() - position) {
+                throw std::out_of_range("binary_reader: read past the end of the buffer");
+            }
+            auto start = buffer.data() + position;
+            position += bytes;
+            return start;
+        }
+
+        static size_t bytes_of(size_t count, size_t size) {
+            if (size != 0 && count > SIZE_MAX / size) {
+                throw std::out_of_range("binary_reader: element count overflows");
+            }
+            return count * size;
+        }
+
+    public:
+        binary_reader() = default;
+
+        // `order` is the byte order of the data, little endian for almost every file format.
+        explicit binary_reader(astra::mem::runtime_array<uint8_t> bytes, std::endian order = std::endian::little) : buffer(std::move(bytes)), swap(order != std::endian::native) { }
+
+        explicit binary_reader(const std::shared_ptr<astra::mem::runtime_array<uint8_t>> &bytes, std::endian order = std::endian::little) : binary_reader(*bytes, order) { }
+
+        [[nodiscard]] size_t tell() const { return position; }
+
+        [[nodiscard]] size_t size() const { return buffer.size(); }
+
+        [[nodiscard]] size_t remaining() const { return buffer.size() - position; }
+
+        [[nodiscard]] bool eof() const { return position >= buffer.size(); }
+
+        [[nodiscard]] std::endian order() const { return swap ? (std::endian::native == std::endian::little ? std::endian::big : std::endian::little) : std::endian::native; }
+
+        void seek(size_t offset) {
+            if (offset > buffer.size()) {
+                throw std::out_of_range("binary_reader: seek past the end of the buffer");
+            }
+            position = offset;
+        }
+
+        void skip(size_t bytes) { take(bytes); }
+
+        // moves forward to the next multiple of `alignment` from the start of the buffer.
+        void align(size_t alignment) {
+            if (auto rest = position % alignment; rest != 0) {
+                skip(alignment - rest);
+            }
+        }
+
+        template<typename U>
+        [[nodiscard]] U read() {
+            static_assert(std::is_trivially_copyable_v<U>);
+            detail::check_order<U>(swap);
+            U value;
+            detail::load_values(take(sizeof(U)), &value, 1, swap);
+            return value;
+        }
+
+        template<typename U>
+        [[nodiscard]] U peek() const {
+            auto copy = *this;
+            return copy.read<U>();
+        }
+
+        // `count` values as an array. it is a view of the buffer, sharing its storage, when the data is aligned for U
+        // and needs no swapping, otherwise the values are copied out.
+        template<typename U>
+        [[nodiscard]] astra::mem::runtime_array<U> read_array(size_t count) {
+            static_assert(std::is_trivially_copyable_v<U>);
+            detail::check_order<U>(swap);
+            auto start = position;
+            auto src   = take(bytes_of(count, sizeof(U)));
+            if ((!swap || sizeof(U) == 1) && reinterpret_cast<uintptr_t>(src) % alignof(U) == 0) {
+                return buffer.view<U>(start, count);
+            }
+
+            astra::mem::runtime_array<U> values(nullptr, count);
+            detail::load_values(src, values.data(), count, swap);
+            return values;
+        }
+
+        // the same without ever copying, but only for aligned host order data. anything else throws.
+        template<typename U>
+        [[nodiscard]] std::span<const U> read_span(size_t count) {
+            static_assert(std::is_trivially_copyable_v<U>);
+            auto start = buffer.data() + position;
+            if ((swap && sizeof(U) > 1) || reinterpret_cast<uintptr_t>(start) % alignof(U) != 0) {
+                throw std::invalid_argument("binary_reader: data can't be viewed as this type");
+            }
+            return {reinterpret_cast<const U *>(take(bytes_of(count, sizeof(U)))), count};
+        }
+
+        // fills `dst` with consecutive values.
+        template<typename U>
+        void read_into(std::span<U> dst) {
+            static_assert(std::is_trivially_copyable_v<U>);
+            detail::check_order<U>(swap);
+            detail::load_values(take(bytes_of(dst.size(), sizeof(U))), dst.data(), dst.size(), swap);
+        }
+
+        [[nodiscard]] std::span<const uint8_t> read_bytes(size_t count) { return {take(count), count}; }
+
+        // a view of the next `count` bytes that shares the buffer, like runtime_array::rslice.
+        [[nodiscard]] astra::mem::runtime_array<uint8_t> read_view(size_t count) {
+            auto start = position;
+            take(count);
+            return buffer.view(start, count);
+        }
+    };
+
+    class binary_writer {
+    private:
+        astra::mem::runtime_array<uint8_t> buffer;
+        size_t position = 0;
+        bool swap       = false;
+
+        uint8_t *take(size_t bytes) {
+            if (bytes > buffer.size() - position) {
+                throw std::out_of_range("binary_writer: write past the end of the buffer");
+            }
+            auto start = buffer.data() + position;
+            position += bytes;
+            return start;
+        }
+
+    public:
+        binary_writer() = default;
+
+        // writes into `bytes`, which has to be large enough up front. `order` is the byte order the data is stored in.
+        explicit binary_writer(astra::mem::runtime_array<uint8_t> bytes, std::endian order = std::endian::little) : buffer(std::move(bytes)), swap(order != std::endian::native) { }
+
+        explicit binary_writer(const std::shared_ptr<astra::mem::runtime_array<uint8_t>> &bytes, std::endian order = std::endian::little) : binary_writer(*bytes, order) { }
+
+        [[nodiscard]] size_t tell() const { return position; }
+
+        [[nodiscard]] size_t size() const { return buffer.size(); }
+
+        [[nodiscard]] size_t remaining() const { return buffer.size() - position; }
+
+        void seek(size_t offset) {
+            if (offset > buffer.size()) {
+                throw std::out_of_range("binary_writer: seek past the end of the buffer");
+            }
+            position = offset;
+        }
+
+        // skips forward to the next multiple of `alignment`, the padding is zeroed.
+        void align(size_t alignment) {
+            if (auto rest = position % alignment; rest != 0) {
+                std::memset(take(alignment - rest), 0, alignment - rest);
+            }
+        }
+
+        template<typename U>
+        void write(const U &value) {
+            static_assert(std::is_trivially_copyable_v<U>);
+            detail::check_order<U>(swap);
+            detail::store_values(&value, take(sizeof(U)), 1, swap);
+        }
+
+        template<typename U>
+        void write_array(std::span<const U> values) {
+            static_assert(std::is_trivially_copyable_v<U>);
+            detail::check_order<U>(swap);
+            if (values.size() > SIZE_MAX / sizeof(U)) {
+                throw std::out_of_range("binary_writer: element count overflows");
+            }
+            detail::store_values(values.data(), take(values.size() * sizeof(U)), values.size(), swap);
+        }
+
+        template<typename U>
+        void write_array(const astra::mem::runtime_array<U> &values) { write_array(std::span<const U>(values.data(), values.size())); }
+
+        void write_bytes(std::span<const uint8_t> bytes) {
+            if (!bytes.empty()) {
+                std::memcpy(take(bytes.size()), bytes.data(), bytes.size());
+            }
+        }
+
+        // the bytes written so far, as a view of the buffer.
+        [[nodiscard]] astra::mem::runtime_array<uint8_t> written() const { return buffer.view(0, position); }
+    };
+} // namespace astra::io
@@ -0,0 +1,766 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "macros.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// BC6H and BC7 (BPTC) block decoding. BC7 decodes to RGBA8, BC6H to RGBA16F with an alpha of 1.0.
+// blocks are first unpacked by table-driven mode parsing, the scalar path then interpolates every pixel like the d3d11
+// reference decoder does. the avx2 path interpolates each block's whole palette with vector math and looks the pixels up
+// in it, which produces the same bytes. invalid blocks decode to zero.
+
+namespace astra::gdx::detail {
+    // the 128 bits of a block, read lsb first. the unpackers are instantiated per mode, so positions are compile-time
+    // constants and every read folds to a shift and a mask.
+    struct bptc_bits {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+
+        explicit bptc_bits(const uint8_t *block) {
+            std::memcpy(&lo, block, 8);
+            std::memcpy(&hi, block + 8, 8);
+        }
+
+        // up to 64 bits starting at `pos`.
+        [[nodiscard]] ASTRA_INLINE uint64_t read(size_t pos, size_t count) const {
+            uint64_t value = pos >= 64 ? hi >> (pos - 64) : pos == 0 ? lo : lo >> pos | hi << (64 - pos);
+            return count >= 64 ? value : value & ((uint64_t { 1 } << count) - 1);
+        }
+    };
+
+    // indices are packed with the top bit of every anchor pixel dropped. putting those bits back as zeros gives every
+    // pixel the same width, so pixel p is simply bits [p * width, p * width + width). anchors must be ascending.
+    ASTRA_INLINE uint64_t bptc_insert_anchor(uint64_t indices, size_t pixel, size_t width) {
+        auto top = pixel * width + width - 1;
+        auto low = indices & ((uint64_t { 1 } << top) - 1);
+        return low | (indices >> top) << (top + 1);
+    }
+
+    template<size_t width>
+    ASTRA_INLINE void bptc_split_indices(uint64_t indices, uint8_t *out) {
+        for (size_t p = 0; p < 16; ++p) {
+            out[p] = static_cast<uint8_t>((indices >> (p * width)) & ((1u << width) - 1));
+        }
+    }
+
+    // bit i is the subset of pixel i.
+    inline constexpr uint16_t bptc_partition2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    inline constexpr uint8_t bptc_partition3[64][16] = {
+        {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1}, {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+        {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+        {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+        {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0}, {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+        {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1}, {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+        {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+        {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2}, {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+        {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+        {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0}, {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+        {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+        {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1}, {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+        {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1}, {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+        {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2}, {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+        {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2}, {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+    };
+
+    // the pixel whose index drops its top bit, for the second subset of 2-subset partitions and the second and third
+    // subsets of 3-subset partitions. the first subset's anchor is always pixel 0.
+    inline constexpr uint8_t bptc_anchor2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+
+    inline constexpr uint8_t bptc_anchor3_second[64] = {
+        3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+        8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+    };
+
+    inline constexpr uint8_t bptc_anchor3_third[64] = {
+        15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+        15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+    };
+
+    inline constexpr uint8_t bptc_weights2[4]  = {0, 21, 43, 64};
+    inline constexpr uint8_t bptc_weights3[8]  = {0, 9, 18, 27, 37, 46, 55, 64};
+    inline constexpr uint8_t bptc_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    constexpr const uint8_t *bptc_weights(size_t bits) { return bits == 2 ? bptc_weights2 : bits == 3 ? bptc_weights3 : bptc_weights4; }
+
+    // every anchor must sit in the subset it anchors, this catches most transcription errors in the tables above.
+    constexpr bool bptc_tables_valid() {
+        for (size_t i = 0; i < 64; ++i) {
+            if (((bptc_partition2[i] >> bptc_anchor2[i]) & 1) != 1 || (bptc_partition2[i] & 1) != 0) {
+                return false;
+            }
+            if (bptc_partition3[i][0] != 0 || bptc_partition3[i][bptc_anchor3_second[i]] != 1 || bptc_partition3[i][bptc_anchor3_third[i]] != 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(bptc_tables_valid(), "bptc partition and anchor tables disagree");
+
+    struct bc7_mode_t {
+        uint8_t subsets;
+        uint8_t partition_bits;
+        uint8_t rotation_bits;
+        uint8_t selector_bits;
+        uint8_t color_bits;
+        uint8_t alpha_bits;
+        uint8_t endpoint_pbits; // one p-bit per endpoint
+        uint8_t shared_pbits;   // one p-bit per subset
+        uint8_t index_bits;
+        uint8_t index2_bits;    // a second index set for alpha (modes 4 and 5)
+    };
+
+    inline constexpr bc7_mode_t bc7_modes[8] = {
+        {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+        {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+        {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+        {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+        {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+        {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+        {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+        {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+    };
+
+    constexpr bool bc7_modes_valid() {
+        for (size_t i = 0; i < 8; ++i) {
+            auto &mode    = bc7_modes[i];
+            size_t bits   = i + 1 + mode.partition_bits + mode.rotation_bits + mode.selector_bits;
+            bits         += mode.subsets * 2 * (3 * mode.color_bits + mode.alpha_bits);
+            bits         += mode.subsets * 2 * mode.endpoint_pbits + mode.subsets * mode.shared_pbits;
+            bits         += 16 * mode.index_bits - mode.subsets;
+            bits         += mode.index2_bits == 0 ? 0 : 16 * mode.index2_bits - 1;
+            if (bits != 128) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(bc7_modes_valid(), "bc7 mode table does not add up to 128 bits");
+
+    struct bc7_block_t {
+        uint8_t subsets    = 1;
+        uint8_t rotation   = 0;
+        uint8_t color_bits = 0; // index precision of the rgb weights
+        uint8_t alpha_bits = 0; // index precision of the alpha weight, equal to color_bits without a second index set
+        bool split         = false;
+        uint8_t endpoints[3][2][4] = {};
+        uint8_t subset[16]         = {};
+        uint8_t color_index[16]    = {};
+        uint8_t alpha_index[16]    = {};
+    };
+
+    ASTRA_INLINE uint8_t bptc_subset(size_t subsets, size_t partition, size_t pixel) {
+        if (subsets == 2) {
+            return static_cast<uint8_t>((bptc_partition2[partition] >> pixel) & 1);
+        }
+        return subsets == 3 ? bptc_partition3[partition][pixel] : 0;
+    }
+
+    template<size_t mode_id>
+    inline void bc7_unpack_mode(const bptc_bits &bits, bc7_block_t &out) {
+        constexpr auto mode           = bc7_modes[mode_id];
+        constexpr size_t subsets      = mode.subsets;
+        constexpr size_t rotation_pos = mode_id + 1 + mode.partition_bits;
+        constexpr size_t selector_pos = rotation_pos + mode.rotation_bits;
+        constexpr size_t color_pos    = selector_pos + mode.selector_bits;
+        constexpr size_t alpha_pos    = color_pos + 3 * subsets * 2 * mode.color_bits;
+        constexpr size_t pbit_pos     = alpha_pos + subsets * 2 * mode.alpha_bits;
+        constexpr size_t index_pos    = pbit_pos + subsets * (2 * mode.endpoint_pbits + mode.shared_pbits);
+        constexpr size_t index_count  = 16 * mode.index_bits - subsets;
+        constexpr uint32_t has_pbit   = mode.endpoint_pbits | mode.shared_pbits;
+
+        auto partition = static_cast<size_t>(bits.read(mode_id + 1, mode.partition_bits));
+        out.subsets    = mode.subsets;
+        out.rotation   = static_cast<uint8_t>(bits.read(rotation_pos, mode.rotation_bits));
+
+        for (size_t s = 0; s < subsets; ++s) {
+            for (size_t e = 0; e < 2; ++e) {
+                uint32_t pbit = 0;
+                if constexpr (mode.endpoint_pbits != 0) {
+                    pbit = static_cast<uint32_t>(bits.read(pbit_pos + s * 2 + e, 1));
+                } else if constexpr (mode.shared_pbits != 0) {
+                    pbit = static_cast<uint32_t>(bits.read(pbit_pos + s, 1));
+                }
+
+                for (size_t c = 0; c < 4; ++c) {
+                    if (c == 3 && mode.alpha_bits == 0) {
+                        out.endpoints[s][e][c] = 255;
+                        continue;
+                    }
+
+                    // append the p-bit and replicate the top bits down to 8 bits.
+                    auto width = (c < 3 ? mode.color_bits : mode.alpha_bits) + has_pbit;
+                    auto raw   = c < 3 ? bits.read(color_pos + ((c * subsets + s) * 2 + e) * mode.color_bits, mode.color_bits) : bits.read(alpha_pos + (s * 2 + e) * mode.alpha_bits, mode.alpha_bits);
+                    auto value = static_cast<uint32_t>(raw) << has_pbit | pbit;
+                    value    <<= 8 - width;
+                    value     |= value >> width;
+                    out.endpoints[s][e][c] = static_cast<uint8_t>(value);
+                }
+            }
+        }
+
+        auto indices = bptc_insert_anchor(bits.read(index_pos, index_count), 0, mode.index_bits);
+        if constexpr (subsets == 2) {
+            indices = bptc_insert_anchor(indices, bptc_anchor2[partition], mode.index_bits);
+            for (size_t p = 0; p < 16; ++p) {
+                out.subset[p] = static_cast<uint8_t>((bptc_partition2[partition] >> p) & 1);
+            }
+        } else if constexpr (subsets == 3) {
+            size_t second = bptc_anchor3_second[partition];
+            size_t third  = bptc_anchor3_third[partition];
+            indices       = bptc_insert_anchor(indices, std::min(second, third), mode.index_bits);
+            indices       = bptc_insert_anchor(indices, std::max(second, third), mode.index_bits);
+            std::memcpy(out.subset, bptc_partition3[partition], 16);
+        } else {
+            std::memset(out.subset, 0, 16);
+        }
+
+        bptc_split_indices<mode.index_bits>(indices, out.color_index);
+        out.color_bits = mode.index_bits;
+        out.alpha_bits = mode.index_bits;
+        out.split      = mode.index2_bits != 0;
+
+        if constexpr (mode.index2_bits == 0) {
+            std::memcpy(out.alpha_index, out.color_index, 16);
+        } else {
+            auto second = bptc_insert_anchor(bits.read(index_pos + index_count, 16 * mode.index2_bits - 1), 0, mode.index2_bits);
+            bptc_split_indices<mode.index2_bits>(second, out.alpha_index);
+            out.alpha_bits = mode.index2_bits;
+
+            if (bits.read(selector_pos, mode.selector_bits) != 0) {
+                uint8_t swap[16];
+                std::memcpy(swap, out.color_index, 16);
+                std::memcpy(out.color_index, out.alpha_index, 16);
+                std::memcpy(out.alpha_index, swap, 16);
+                out.color_bits = mode.index2_bits;
+                out.alpha_bits = mode.index_bits;
+            }
+        }
+    }
+
+    // returns false for the reserved mode (a zero first byte).
+    inline bool bc7_unpack(const uint8_t *block, bc7_block_t &out) {
+        bptc_bits bits(block);
+        switch (block[0] == 0 ? 8 : std::countr_zero(block[0])) {
+            case 0: bc7_unpack_mode<0>(bits, out); return true;
+            case 1: bc7_unpack_mode<1>(bits, out); return true;
+            case 2: bc7_unpack_mode<2>(bits, out); return true;
+            case 3: bc7_unpack_mode<3>(bits, out); return true;
+            case 4: bc7_unpack_mode<4>(bits, out); return true;
+            case 5: bc7_unpack_mode<5>(bits, out); return true;
+            case 6: bc7_unpack_mode<6>(bits, out); return true;
+            case 7: bc7_unpack_mode<7>(bits, out); return true;
+            default: return false;
+        }
+    }
+
+    ASTRA_INLINE uint32_t bptc_lerp(uint32_t a, uint32_t b, uint32_t weight) { return (a * (64 - weight) + b * weight + 32) >> 6; }
+
+    inline void bc7_block_scalar(const uint8_t *block, uint8_t *dst, size_t pitch) {
+        bc7_block_t unpacked;
+        if (!bc7_unpack(block, unpacked)) {
+            for (size_t y = 0; y < 4; ++y) {
+                std::memset(dst + y * pitch, 0, 16);
+            }
+            return;
+        }
+
+        auto color_weights = bptc_weights(unpacked.color_bits);
+        auto alpha_weights = bptc_weights(unpacked.alpha_bits);
+        for (size_t p = 0; p < 16; ++p) {
+            auto &e = unpacked.endpoints[unpacked.subset[p]];
+            auto wc = color_weights[unpacked.color_index[p]];
+            auto wa = alpha_weights[unpacked.alpha_index[p]];
+
+            uint8_t pixel[4];
+            for (size_t c = 0; c < 3; ++c) {
+                pixel[c] = static_cast<uint8_t>(bptc_lerp(e[0][c], e[1][c], wc));
+            }
+            pixel[3] = static_cast<uint8_t>(bptc_lerp(e[0][3], e[1][3], wa));
+
+            if (unpacked.rotation != 0) {
+                std::swap(pixel[3], pixel[unpacked.rotation - 1]);
+            }
+
+            std::memcpy(dst + (p / 4) * pitch + (p % 4) * 4, pixel, 4);
+        }
+    }
+
+    inline void bc7_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+        for (size_t i = 0; i < blocks; ++i) {
+            bc7_block_scalar(src + i * 16, dst + i * 16, pitch);
+        }
+    }
+
+    namespace bc6h_field {
+        enum : uint8_t { rw, gw, bw, rx, gx, bx, ry, gy, by, rz, gz, bz, d };
+    }
+
+    // `count` bits of the block go to bits [low, low + count) of `field`, reversed ones are stored msb first.
+    struct bc6h_segment_t {
+        uint8_t field    = 0;
+        uint8_t low      = 0;
+        uint8_t count    = 0;
+        bool reversed    = false;
+    };
+
+    struct bc6h_mode_t {
+        uint8_t code        = 0; // the 2 or 5 mode bits
+        bool transformed    = false; // endpoints other than the first are stored as deltas
+        uint8_t subsets     = 1;
+        uint8_t precision   = 0;
+        uint8_t delta[3]    = {};
+        bc6h_segment_t segments[24] = {};
+    };
+
+    // the header layouts of the 14 bc6h modes, in stream order after the mode bits.
+    constexpr std::array<bc6h_mode_t, 14> make_bc6h_modes() {
+        using namespace bc6h_field;
+        return {{
+            {0x00, true, 2, 10, {5, 5, 5}, {{gy, 4, 1}, {by, 4, 1}, {bz, 4, 1}, {rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 5}, {gz, 4, 1}, {gy, 0, 4}, {gx, 0, 5}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 5}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 5}, {bz, 2, 1}, {rz, 0, 5}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x01, true, 2, 7, {6, 6, 6}, {{gy, 5, 1}, {gz, 4, 1}, {gz, 5, 1}, {rw, 0, 7}, {bz, 0, 1}, {bz, 1, 1}, {by, 4, 1}, {gw, 0, 7}, {by, 5, 1}, {bz, 2, 1}, {gy, 4, 1}, {bw, 0, 7}, {bz, 3, 1}, {bz, 5, 1}, {bz, 4, 1}, {rx, 0, 6}, {gy, 0, 4}, {gx, 0, 6}, {gz, 0, 4}, {bx, 0, 6}, {by, 0, 4}, {ry, 0, 6}, {rz, 0, 6}, {d, 0, 5}}},
+            {0x02, true, 2, 11, {5, 4, 4}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 5}, {rw, 10, 1}, {gy, 0, 4}, {gx, 0, 4}, {gw, 10, 1}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 4}, {bw, 10, 1}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 5}, {bz, 2, 1}, {rz, 0, 5}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x06, true, 2, 11, {4, 5, 4}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 4}, {rw, 10, 1}, {gz, 4, 1}, {gy, 0, 4}, {gx, 0, 5}, {gw, 10, 1}, {gz, 0, 4}, {bx, 0, 4}, {bw, 10, 1}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 4}, {bz, 0, 1}, {bz, 2, 1}, {rz, 0, 4}, {gy, 4, 1}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x0A, true, 2, 11, {4, 4, 5}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 4}, {rw, 10, 1}, {by, 4, 1}, {gy, 0, 4}, {gx, 0, 4}, {gw, 10, 1}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 5}, {bw, 10, 1}, {by, 0, 4}, {ry, 0, 4}, {bz, 1, 1}, {bz, 2, 1}, {rz, 0, 4}, {bz, 4, 1}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x0E, true, 2, 9, {5, 5, 5}, {{rw, 0, 9}, {by, 4, 1}, {gw, 0, 9}, {gy, 4, 1}, {bw, 0, 9}, {bz, 4, 1}, {rx, 0, 5}, {gz, 4, 1}, {gy, 0, 4}, {gx, 0, 5}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 5}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 5}, {bz, 2, 1}, {rz, 0, 5}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x12, true, 2, 8, {6, 5, 5}, {{rw, 0, 8}, {gz, 4, 1}, {by, 4, 1}, {gw, 0, 8}, {bz, 2, 1}, {gy, 4, 1}, {bw, 0, 8}, {bz, 3, 1}, {bz, 4, 1}, {rx, 0, 6}, {gy, 0, 4}, {gx, 0, 5}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 5}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 6}, {rz, 0, 6}, {d, 0, 5}}},
+            {0x16, true, 2, 8, {5, 6, 5}, {{rw, 0, 8}, {bz, 0, 1}, {by, 4, 1}, {gw, 0, 8}, {gy, 5, 1}, {gy, 4, 1}, {bw, 0, 8}, {gz, 5, 1}, {bz, 4, 1}, {rx, 0, 5}, {gz, 4, 1}, {gy, 0, 4}, {gx, 0, 6}, {gz, 0, 4}, {bx, 0, 5}, {bz, 1, 1}, {by, 0, 4}, {ry, 0, 5}, {bz, 2, 1}, {rz, 0, 5}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x1A, true, 2, 8, {5, 5, 6}, {{rw, 0, 8}, {bz, 1, 1}, {by, 4, 1}, {gw, 0, 8}, {by, 5, 1}, {gy, 4, 1}, {bw, 0, 8}, {bz, 5, 1}, {bz, 4, 1}, {rx, 0, 5}, {gz, 4, 1}, {gy, 0, 4}, {gx, 0, 5}, {bz, 0, 1}, {gz, 0, 4}, {bx, 0, 6}, {by, 0, 4}, {ry, 0, 5}, {bz, 2, 1}, {rz, 0, 5}, {bz, 3, 1}, {d, 0, 5}}},
+            {0x1E, false, 2, 6, {6, 6, 6}, {{rw, 0, 6}, {gz, 4, 1}, {bz, 0, 1}, {bz, 1, 1}, {by, 4, 1}, {gw, 0, 6}, {gy, 5, 1}, {by, 5, 1}, {bz, 2, 1}, {gy, 4, 1}, {bw, 0, 6}, {gz, 5, 1}, {bz, 3, 1}, {bz, 5, 1}, {bz, 4, 1}, {rx, 0, 6}, {gy, 0, 4}, {gx, 0, 6}, {gz, 0, 4}, {bx, 0, 6}, {by, 0, 4}, {ry, 0, 6}, {rz, 0, 6}, {d, 0, 5}}},
+            {0x03, false, 1, 10, {10, 10, 10}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 10}, {gx, 0, 10}, {bx, 0, 10}}},
+            {0x07, true, 1, 11, {9, 9, 9}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 9}, {rw, 10, 1}, {gx, 0, 9}, {gw, 10, 1}, {bx, 0, 9}, {bw, 10, 1}}},
+            {0x0B, true, 1, 12, {8, 8, 8}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 8}, {rw, 10, 2, true}, {gx, 0, 8}, {gw, 10, 2, true}, {bx, 0, 8}, {bw, 10, 2, true}}},
+            {0x0F, true, 1, 16, {4, 4, 4}, {{rw, 0, 10}, {gw, 0, 10}, {bw, 0, 10}, {rx, 0, 4}, {rw, 10, 6, true}, {gx, 0, 4}, {gw, 10, 6, true}, {bx, 0, 4}, {bw, 10, 6, true}}},
+        }};
+    }
+
+    inline constexpr std::array<bc6h_mode_t, 14> bc6h_modes = make_bc6h_modes();
+
+    // maps the 5 mode bits (or 2 for the first two modes) to a bc6h_modes index, -1 for reserved modes.
+    constexpr std::array<int8_t, 32> make_bc6h_lookup() {
+        std::array<int8_t, 32> lookup = {};
+        for (auto &entry : lookup) {
+            entry = -1;
+        }
+        for (size_t i = 0; i < bc6h_modes.size(); ++i) {
+            lookup[bc6h_modes[i].code] = static_cast<int8_t>(i);
+        }
+        return lookup;
+    }
+
+    inline constexpr std::array<int8_t, 32> bc6h_lookup = make_bc6h_lookup();
+
+    // every field must be covered exactly once with the width its mode declares, and every header must be 82 bits
+    // (two subsets) or 65 bits (one subset).
+    constexpr bool bc6h_modes_valid() {
+        for (auto &mode : bc6h_modes) {
+            uint32_t covered[13] = {};
+            size_t bits          = mode.code < 2 ? 2 : 5;
+            for (auto &segment : mode.segments) {
+                if (segment.count == 0) {
+                    break;
+                }
+                auto mask = ((1u << segment.count) - 1) << segment.low;
+                if ((covered[segment.field] & mask) != 0) {
+                    return false;
+                }
+                covered[segment.field] |= mask;
+                bits += segment.count;
+            }
+
+            for (size_t c = 0; c < 3; ++c) {
+                if (covered[c] != (1u << mode.precision) - 1 || covered[3 + c] != (1u << mode.delta[c]) - 1) {
+                    return false;
+                }
+                auto other = mode.subsets == 2 ? (1u << mode.delta[c]) - 1 : 0;
+                if (covered[6 + c] != other || covered[9 + c] != other) {
+                    return false;
+                }
+            }
+
+            if (covered[bc6h_field::d] != (mode.subsets == 2 ? 31u : 0u) || bits != (mode.subsets == 2 ? 82u : 65u)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(bc6h_modes_valid(), "bc6h mode table is inconsistent");
+
+    struct bc6h_block_t {
+        uint8_t subsets    = 1;
+        uint8_t index_bits = 4;
+        int32_t endpoints[2][2][3] = {}; // unquantized, ready for interpolation
+        uint8_t subset[16]         = {};
+        uint8_t index[16]          = {};
+    };
+
+    ASTRA_INLINE int32_t sign_extend(int32_t value, uint32_t bits) {
+        auto shift = 32 - bits;
+        return static_cast<int32_t>(static_cast<uint32_t>(value) << shift) >> shift;
+    }
+
+    template<bool is_signed>
+    ASTRA_INLINE int32_t bc6h_unquantize(int32_t value, uint32_t bits) {
+        if constexpr (is_signed) {
+            if (bits >= 16) {
+                return value;
+            }
+
+            auto negative = value < 0;
+            value         = negative ? -value : value;
+            int32_t result;
+            if (value == 0) {
+                result = 0;
+            } else if (value >= (1 << (bits - 1)) - 1) {
+                result = 0x7FFF;
+            } else {
+                result = ((value << 15) + 0x4000) >> (bits - 1);
+            }
+            return negative ? -result : result;
+        } else {
+            if (bits >= 15) {
+                return value;
+            }
+            if (value == 0) {
+                return 0;
+            }
+            if (value == (1 << bits) - 1) {
+                return 0xFFFF;
+            }
+            return ((value << 16) + 0x8000) >> bits;
+        }
+    }
+
+    // scales an interpolated value to the half float range and returns its bits.
+    template<bool is_signed>
+    ASTRA_INLINE uint16_t bc6h_finish(int32_t value) {
+        if constexpr (is_signed) {
+            return static_cast<uint16_t>(value < 0 ? 0x8000 | (((-value) * 31) >> 5) : (value * 31) >> 5);
+        } else {
+            return static_cast<uint16_t>((value * 31) >> 6);
+        }
+    }
+
+    // where segment `index` of a mode starts in the block.
+    constexpr size_t bc6h_segment_pos(const bc6h_mode_t &mode, size_t index) {
+        size_t pos = mode.code < 2 ? 2 : 5;
+        for (size_t i = 0; i < index; ++i) {
+            pos += mode.segments[i].count;
+        }
+        return pos;
+    }
+
+    template<size_t mode_id, size_t segment>
+    ASTRA_INLINE void bc6h_read_segment(const bptc_bits &bits, int32_t *fields) {
+        constexpr auto info = bc6h_modes[mode_id].segments[segment];
+        if constexpr (info.count != 0) {
+            auto value = static_cast<uint32_t>(bits.read(bc6h_segment_pos(bc6h_modes[mode_id], segment), info.count));
+            if constexpr (info.reversed) {
+                uint32_t flipped = 0;
+                for (size_t i = 0; i < info.count; ++i) {
+                    flipped |= ((value >> i) & 1) << (info.count - 1 - i);
+                }
+                value = flipped;
+            }
+            fields[info.field] |= static_cast<int32_t>(value << info.low);
+        }
+    }
+
+    template<size_t mode_id, bool is_signed, size_t... segment>
+    inline void bc6h_unpack_mode(const bptc_bits &bits, bc6h_block_t &out, std::index_sequence<segment...>) {
+        constexpr auto mode = bc6h_modes[mode_id];
+
+        int32_t fields[13] = {};
+        (bc6h_read_segment<mode_id, segment>(bits, fields), ...);
+
+        constexpr uint32_t precision = mode.precision;
+        constexpr int32_t mask       = static_cast<int32_t>((1u << precision) - 1);
+        for (size_t c = 0; c < 3; ++c) {
+            auto base = fields[c];
+            if constexpr (is_signed) {
+                base = sign_extend(base, precision);
+            }
+
+            int32_t others[3] = {fields[3 + c], fields[6 + c], fields[9 + c]};
+            for (size_t k = 0; k < mode.subsets * 2u - 1; ++k) {
+                if (is_signed || mode.transformed) {
+                    others[k] = sign_extend(others[k], mode.delta[c]);
+                }
+                if constexpr (mode.transformed) {
+                    others[k] = (base + others[k]) & mask;
+                    if constexpr (is_signed) {
+                        others[k] = sign_extend(others[k], precision);
+                    }
+                }
+            }
+
+            out.endpoints[0][0][c] = bc6h_unquantize<is_signed>(base, precision);
+            out.endpoints[0][1][c] = bc6h_unquantize<is_signed>(others[0], precision);
+            out.endpoints[1][0][c] = bc6h_unquantize<is_signed>(others[1], precision);
+            out.endpoints[1][1][c] = bc6h_unquantize<is_signed>(others[2], precision);
+        }
+
+        out.subsets = mode.subsets;
+        if constexpr (mode.subsets == 2) {
+            auto partition = static_cast<size_t>(fields[bc6h_field::d]);
+            auto indices   = bptc_insert_anchor(bits.read(82, 46), 0, 3);
+            indices        = bptc_insert_anchor(indices, bptc_anchor2[partition], 3);
+            out.index_bits = 3;
+            bptc_split_indices<3>(indices, out.index);
+            for (size_t p = 0; p < 16; ++p) {
+                out.subset[p] = static_cast<uint8_t>((bptc_partition2[partition] >> p) & 1);
+            }
+        } else {
+            out.index_bits = 4;
+            bptc_split_indices<4>(bptc_insert_anchor(bits.read(65, 63), 0, 4), out.index);
+            std::memset(out.subset, 0, 16);
+        }
+    }
+
+    template<bool is_signed, size_t... mode_id>
+    inline bool bc6h_unpack_dispatch(const bptc_bits &bits, int mode, bc6h_block_t &out, std::index_sequence<mode_id...>) {
+        return ((mode == static_cast<int>(mode_id) ? (bc6h_unpack_mode<mode_id, is_signed>(bits, out, std::make_index_sequence<24> {}), true) : false) || ...);
+    }
+
+    // returns false for the reserved modes.
+    template<bool is_signed>
+    inline bool bc6h_unpack(const uint8_t *block, bc6h_block_t &out) {
+        bptc_bits bits(block);
+        auto code = static_cast<size_t>(bits.read(0, 2));
+        if (code > 1) {
+            code = static_cast<size_t>(bits.read(0, 5));
+        }
+
+        auto mode = bc6h_lookup[code];
+        return mode >= 0 && bc6h_unpack_dispatch<is_signed>(bits, mode, out, std::make_index_sequence<14> {});
+    }
+
+    ASTRA_INLINE void bc6h_store_invalid(uint8_t *dst, size_t pitch) {
+        constexpr uint64_t black = uint64_t { 0x3C00 } << 48;
+        for (size_t y = 0; y < 4; ++y) {
+            for (size_t x = 0; x < 4; ++x) {
+                std::memcpy(dst + y * pitch + x * 8, &black, 8);
+            }
+        }
+    }
+
+    template<bool is_signed>
+    inline void bc6h_block_scalar(const uint8_t *block, uint8_t *dst, size_t pitch) {
+        bc6h_block_t unpacked;
+        if (!bc6h_unpack<is_signed>(block, unpacked)) {
+            bc6h_store_invalid(dst, pitch);
+            return;
+        }
+
+        auto weights = bptc_weights(unpacked.index_bits);
+        for (size_t p = 0; p < 16; ++p) {
+            auto &e     = unpacked.endpoints[unpacked.subset[p]];
+            auto weight = weights[unpacked.index[p]];
+
+            uint16_t pixel[4] = {0, 0, 0, 0x3C00};
+            for (size_t c = 0; c < 3; ++c) {
+                pixel[c] = bc6h_finish<is_signed>((e[0][c] * (64 - weight) + e[1][c] * weight + 32) >> 6);
+            }
+            std::memcpy(dst + (p / 4) * pitch + (p % 4) * 8, pixel, 8);
+        }
+    }
+
+    template<bool is_signed>
+    inline void bc6h_row_scalar(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+        for (size_t i = 0; i < blocks; ++i) {
+            bc6h_block_scalar<is_signed>(src + i * 16, dst + i * 32, pitch);
+        }
+    }
+
+#ifdef ASTRA_X86
+    // the weight of every palette entry repeated for the four channels, for 2, 3 and 4 bit indices.
+    struct alignas(32) bptc_weight_lanes_t {
+        int16_t lanes[3][64];
+    };
+
+    constexpr bptc_weight_lanes_t make_bptc_weight_lanes() {
+        bptc_weight_lanes_t table = {};
+        for (size_t bits = 2; bits <= 4; ++bits) {
+            for (size_t entry = 0; entry < (size_t { 1 } << bits); ++entry) {
+                for (size_t c = 0; c < 4; ++c) {
+                    table.lanes[bits - 2][entry * 4 + c] = bptc_weights(bits)[entry];
+                }
+            }
+        }
+        return table;
+    }
+
+    inline constexpr bptc_weight_lanes_t bptc_weight_lanes = make_bptc_weight_lanes();
+
+    ASTRA_TARGET("avx2") inline __m256i bptc_endpoint_lanes(const uint8_t *e) { return _mm256_set1_epi64x(static_cast<int64_t>(e[0] | uint64_t { e[1] } << 16 | uint64_t { e[2] } << 32 | uint64_t { e[3] } << 48)); }
+
+    // interpolates the 4, 8 or 16 rgba8 palette entries between two endpoints, four entries per instruction.
+    ASTRA_TARGET("avx2") inline void bptc_palette_avx2(const uint8_t *e0, const uint8_t *e1, size_t bits, uint32_t *out) {
+        auto a     = bptc_endpoint_lanes(e0);
+        auto b     = bptc_endpoint_lanes(e1);
+        auto full  = _mm256_set1_epi16(64);
+        auto round = _mm256_set1_epi16(32);
+        auto lanes = bptc_weight_lanes.lanes[bits - 2];
+
+        __m256i chunks[4];
+        auto count = (size_t { 1 } << bits) / 4;
+        for (size_t k = 0; k < count; ++k) {
+            auto w    = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes + k * 16));
+            auto sum  = _mm256_add_epi16(_mm256_mullo_epi16(a, _mm256_sub_epi16(full, w)), _mm256_mullo_epi16(b, w));
+            chunks[k] = _mm256_srli_epi16(_mm256_add_epi16(sum, round), 6);
+        }
+
+        if (count == 1) {
+            auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(chunks[0], chunks[0]), 0xD8);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(packed));
+            return;
+        }
+
+        for (size_t k = 0; k < count; k += 2) {
+            auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(chunks[k], chunks[k + 1]), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k * 4), packed);
+        }
+    }
+
+    ASTRA_TARGET("avx2") inline __m256i bptc_gather8(const uint32_t *palette, const uint8_t *index) { return _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(index))), 4); }
+
+    ASTRA_TARGET("avx2") inline void bc7_block_avx2(const uint8_t *block, uint8_t *dst, size_t pitch) {
+        bc7_block_t unpacked;
+        if (!bc7_unpack(block, unpacked)) {
+            for (size_t y = 0; y < 4; ++y) {
+                std::memset(dst + y * pitch, 0, 16);
+            }
+            return;
+        }
+
+        alignas(32) uint32_t palette[48];
+        __m256i pixels[2];
+        if (!unpacked.split) {
+            // every subset gets its own run of entries, pixels look up subset * entries + index.
+            auto shift = unpacked.color_bits;
+            for (size_t s = 0; s < unpacked.subsets; ++s) {
+                bptc_palette_avx2(unpacked.endpoints[s][0], unpacked.endpoints[s][1], unpacked.color_bits, palette + (s << shift));
+            }
+
+            alignas(16) uint8_t combined[16];
+            for (size_t p = 0; p < 16; ++p) {
+                combined[p] = static_cast<uint8_t>(unpacked.subset[p] << shift | unpacked.color_index[p]);
+            }
+
+            pixels[0] = bptc_gather8(palette, combined);
+            pixels[1] = bptc_gather8(palette, combined + 8);
+        } else {
+            // modes 4 and 5 index color and alpha separately, alpha lives in the top byte of the second palette.
+            bptc_palette_avx2(unpacked.endpoints[0][0], unpacked.endpoints[0][1], unpacked.color_bits, palette);
+            bptc_palette_avx2(unpacked.endpoints[0][0], unpacked.endpoints[0][1], unpacked.alpha_bits, palette + 16);
+
+            auto rgb = _mm256_set1_epi32(0x00FFFFFF);
+            for (size_t half = 0; half < 2; ++half) {
+                auto color   = bptc_gather8(palette, unpacked.color_index + half * 8);
+                auto alpha   = bptc_gather8(palette + 16, unpacked.alpha_index + half * 8);
+                pixels[half] = _mm256_blendv_epi8(alpha, color, rgb);
+            }
+
+            if (unpacked.rotation != 0) {
+                // swaps alpha with red, green or blue inside every pixel.
+                alignas(16) uint8_t mask[16];
+                for (size_t i = 0; i < 16; ++i) {
+                    auto c  = i % 4;
+                    auto to = c == 3 ? unpacked.rotation - 1u : c == unpacked.rotation - 1u ? 3 : c;
+                    mask[i] = static_cast<uint8_t>(i - c + to);
+                }
+                auto shuffle = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(mask)));
+                pixels[0]    = _mm256_shuffle_epi8(pixels[0], shuffle);
+                pixels[1]    = _mm256_shuffle_epi8(pixels[1], shuffle);
+            }
+        }
+
+        for (size_t half = 0; half < 2; ++half) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (half * 2) * pitch), _mm256_castsi256_si128(pixels[half]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + (half * 2 + 1) * pitch), _mm256_extracti128_si256(pixels[half], 1));
+        }
+    }
+
+    ASTRA_TARGET("avx2") inline void bc7_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+        for (size_t i = 0; i < blocks; ++i) {
+            bc7_block_avx2(src + i * 16, dst + i * 16, pitch);
+        }
+    }
+
+    // interpolates and finishes 8 palette entries of one channel in 32-bit lanes.
+    template<bool is_signed>
+    ASTRA_TARGET("avx2") inline __m256i bc6h_channel_avx2(int32_t a, int32_t b, __m256i weights) {
+        auto sum   = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(a), _mm256_sub_epi32(_mm256_set1_epi32(64), weights)), _mm256_mullo_epi32(_mm256_set1_epi32(b), weights));
+        auto value = _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(32)), 6);
+        auto scale = _mm256_set1_epi32(31);
+        if constexpr (is_signed) {
+            auto magnitude = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_abs_epi32(value), scale), 5);
+            auto sign      = _mm256_and_si256(_mm256_srai_epi32(value, 31), _mm256_set1_epi32(0x8000));
+            return _mm256_or_si256(magnitude, sign);
+        } else {
+            return _mm256_srli_epi32(_mm256_mullo_epi32(value, scale), 6);
+        }
+    }
+
+    template<bool is_signed>
+    ASTRA_TARGET("avx2") void bc6h_block_avx2(const uint8_t *block, uint8_t *dst, size_t pitch) {
+        bc6h_block_t unpacked;
+        if (!bc6h_unpack<is_signed>(block, unpacked)) {
+            bc6h_store_invalid(dst, pitch);
+            return;
+        }
+
+        // both layouts make a 16 entry palette: one subset with 4-bit indices, or two subsets of 8 with 3-bit indices.
+        alignas(32) uint64_t palette[16];
+        auto two = unpacked.subsets == 2;
+        for (size_t half = 0; half < 2; ++half) {
+            auto &e       = unpacked.endpoints[two ? half : 0];
+            auto weights  = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(two ? bptc_weights3 : bptc_weights4 + half * 8)));
+            auto r        = bc6h_channel_avx2<is_signed>(e[0][0], e[1][0], weights);
+            auto g        = bc6h_channel_avx2<is_signed>(e[0][1], e[1][1], weights);
+            auto b        = bc6h_channel_avx2<is_signed>(e[0][2], e[1][2], weights);
+            auto rg       = _mm256_or_si256(r, _mm256_slli_epi32(g, 16));
+            auto ba       = _mm256_or_si256(b, _mm256_set1_epi32(0x3C000000));
+            auto lo       = _mm256_unpacklo_epi32(rg, ba);
+            auto hi       = _mm256_unpackhi_epi32(rg, ba);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(palette + half * 8), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_store_si256(reinterpret_cast<__m256i *>(palette + half * 8 + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        for (size_t p = 0; p < 16; ++p) {
+            auto entry = two ? unpacked.subset[p] * 8 + unpacked.index[p] : unpacked.index[p];
+            std::memcpy(dst + (p / 4) * pitch + (p % 4) * 8, palette + entry, 8);
+        }
+    }
+
+    template<bool is_signed>
+    ASTRA_TARGET("avx2") void bc6h_row_avx2(const uint8_t *src, size_t blocks, uint8_t *dst, size_t pitch) {
+        for (size_t i = 0; i < blocks; ++i) {
+            bc6h_block_avx2<is_signed>(src + i * 16, dst + i * 32, pitch);
+        }
+    }
+#endif
+} // namespace astra::gdx::detail
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "cpu_features.hpp"
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "runtime_array.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// bulk byte order conversion. every swappable type has a byte_layout, a permutation that says which source byte ends up
+// at each position of a record. scalars get theirs automatically; structs describe their fields with record_layout.
+// records whose size divides 16 repeat the same pattern in every 16-byte block, so they stream through one pshufb (or
+// avx2 vpshufb) mask. larger or odd-sized records are cut into segments of at most 16 bytes that end on field
+// boundaries, one shuffle each. large buffers are split into chunks of whole records and swapped on a worker pool.
+
+namespace astra::mem {
+    // `bytes` bytes that keep their order, for padding and byte arrays inside a record.
+    template<size_t bytes>
+    struct skip { };
+
+    namespace detail {
+        template<typename U>
+        concept swappable_scalar = std::is_trivially_copyable_v<U> && (std::is_arithmetic_v<U> || std::is_enum_v<U>) && (sizeof(U) == 1 || sizeof(U) == 2 || sizeof(U) == 4 || sizeof(U) == 8);
+
+        template<size_t size>
+        using word_t = std::conditional_t<size == 1, uint8_t, std::conditional_t<size == 2, uint16_t, std::conditional_t<size == 4, uint32_t, uint64_t>>>;
+
+        // the bytes a record field takes up, and the width of the units inside it that are swapped.
+        template<typename F>
+        struct layout_field;
+
+        template<swappable_scalar F>
+        struct layout_field<F> {
+            static constexpr size_t size  = sizeof(F);
+            static constexpr size_t width = sizeof(F);
+        };
+
+        template<swappable_scalar F, size_t count>
+        struct layout_field<std::array<F, count>> {
+            static constexpr size_t size  = sizeof(F) * count;
+            static constexpr size_t width = sizeof(F);
+        };
+
+        template<swappable_scalar F, size_t count>
+        struct layout_field<F[count]> : layout_field<std::array<F, count>> { };
+
+        template<size_t bytes>
+        struct layout_field<skip<bytes>> {
+            static constexpr size_t size  = bytes;
+            static constexpr size_t width = 1;
+        };
+    } // namespace detail
+
+    // describes a record as its fields in declaration order, padding included (as skip<n>). fields are scalars, arrays
+    // of scalars or skip<n>. check it with static_assert(record_layout<...>::size == sizeof(record)).
+    template<typename... Fields>
+    struct record_layout {
+        static constexpr size_t size = (detail::layout_field<Fields>::size + ... + 0);
+        static_assert(size > 0, "a record needs at least one byte");
+
+        // permutation[i] is the source byte that lands at byte i.
+        static constexpr std::array<uint32_t, size> permutation = [] {
+            std::array<uint32_t, size> result = {};
+            size_t at                         = 0;
+            auto field                        = [&](size_t bytes, size_t width) {
+                for (size_t end = at + bytes; at < end; at += width) {
+                    for (size_t b = 0; b < width; ++b) {
+                        result[at + b] = static_cast<uint32_t>(at + width - 1 - b);
+                    }
+                }
+            };
+            (field(detail::layout_field<Fields>::size, detail::layout_field<Fields>::width), ...);
+            return result;
+        }();
+    };
+
+    // the byte order layout of T. scalars have one, structs opt in with a specialization:
+    // template<> struct astra::mem::byte_layout<vertex_t> : record_layout<float[3], uint16_t[2], skip<4>> { };
+    template<typename T>
+    struct byte_layout { };
+
+    template<detail::swappable_scalar T>
+    struct byte_layout<T> : record_layout<T> { };
+
+    template<typename T>
+    concept byte_swappable = std::is_trivially_copyable_v<T> && requires {
+        { byte_layout<T>::size } -> std::convertible_to<size_t>;
+        byte_layout<T>::permutation;
+    } && byte_layout<T>::size == sizeof(T);
+
+    namespace detail {
+        // swaps spread over threads in chunks of about this many bytes.
+        inline constexpr size_t swap_grain = 2 << 20;
+
+        struct swap_segment_t {
+            size_t offset    = 0;
+            uint8_t mask[16] = {};
+        };
+
+        // the permutation of a byte_layout turned into shuffle masks, built once per type.
+        struct swap_plan_t {
+            size_t record = 0;
+            std::vector<uint32_t> permutation;
+            bool identity = true;
+            size_t width  = 0; // 2, 4 or 8 when the record is nothing but units of one width, for the scalar loop.
+
+            // records that divide 16 bytes repeat `mask` in every 16-byte block.
+            bool periodic    = false;
+            uint8_t mask[16] = {};
+
+            // other records are handled `group` at a time (as many as fit in 16 bytes, at least one), a segment each.
+            size_t group = 1;
+            std::vector<swap_segment_t> segments;
+
+            explicit swap_plan_t(std::span<const uint32_t> layout) : record(layout.size()), permutation(layout.begin(), layout.end()) {
+                for (size_t i = 0; i < record; ++i) {
+                    identity = identity && permutation[i] == i;
+                }
+
+                for (size_t w : {8u, 4u, 2u}) {
+                    auto uniform = record % w == 0;
+                    for (size_t i = 0; i < record && uniform; ++i) {
+                        uniform = permutation[i] == (i / w) * w + (w - 1 - i % w);
+                    }
+                    if (uniform) {
+                        width = w;
+                        break;
+                    }
+                }
+
+                if (16 % record == 0) {
+                    periodic = true;
+                    for (size_t i = 0; i < 16; ++i) {
+                        mask[i] = static_cast<uint8_t>((i / record) * record + permutation[i % record]);
+                    }
+                    return;
+                }
+
+                group            = std::max<size_t>(16 / record, 1);
+                auto block_bytes = group * record;
+                std::vector<uint32_t> block(block_bytes);
+                for (size_t i = 0; i < block_bytes; ++i) {
+                    block[i] = static_cast<uint32_t>((i / record) * record + permutation[i % record]);
+                }
+
+                // a segment may end at `end` when no byte moves across it, so it never splits a field.
+                std::vector<bool> boundary(block_bytes + 1, false);
+                uint32_t reach = 0;
+                for (size_t i = 0; i < block_bytes; ++i) {
+                    reach           = std::max(reach, block[i]);
+                    boundary[i + 1] = reach <= i;
+                }
+
+                for (size_t start = 0; start < block_bytes;) {
+                    auto end = std::min(start + 16, block_bytes);
+                    while (!boundary[end]) {
+                        --end;
+                    }
+
+                    swap_segment_t segment;
+                    segment.offset = start;
+                    for (size_t i = 0; i < 16; ++i) {
+                        segment.mask[i] = static_cast<uint8_t>(start + i < end ? block[start + i] - start : i);
+                    }
+                    segments.push_back(segment);
+                    start = end;
+                }
+            }
+        };
+
+        template<byte_swappable T>
+        const swap_plan_t &swap_plan() {
+            static const swap_plan_t plan(byte_layout<T>::permutation);
+            return plan;
+        }
+
+        template<swappable_scalar U>
+        ASTRA_INLINE U byteswap_value(U value) {
+            if constexpr (sizeof(U) == 1) {
+                return value;
+            } else {
+                return std::bit_cast<U>(std::byteswap(std::bit_cast<word_t<sizeof(U)>>(value)));
+            }
+        }
+
+        template<size_t width>
+        inline void swap_words_scalar(const uint8_t *src, uint8_t *dst, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                word_t<width> word;
+                std::memcpy(&word, src + i * width, width);
+                word = std::byteswap(word);
+                std::memcpy(dst + i * width, &word, width);
+            }
+        }
+
+        // every kernel takes `count` whole records and stays inside them, so chunks can run side by side.
+        // src and dst are either the same buffer or don't overlap.
+        inline void swap_scalar(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            auto bytes = count * plan.record;
+            switch (plan.width) {
+                case 2: swap_words_scalar<2>(src, dst, bytes / 2); return;
+                case 4: swap_words_scalar<4>(src, dst, bytes / 4); return;
+                case 8: swap_words_scalar<8>(src, dst, bytes / 8); return;
+                default: break;
+            }
+
+            if (src == dst) {
+                std::vector<uint8_t> record(plan.record);
+                for (size_t r = 0; r < count; ++r) {
+                    std::memcpy(record.data(), src + r * plan.record, plan.record);
+                    for (size_t i = 0; i < plan.record; ++i) {
+                        dst[r * plan.record + i] = record[plan.permutation[i]];
+                    }
+                }
+                return;
+            }
+
+            for (size_t r = 0; r < count; ++r) {
+                for (size_t i = 0; i < plan.record; ++i) {
+                    dst[r * plan.record + i] = src[r * plan.record + plan.permutation[i]];
+                }
+            }
+        }
+
+#ifdef ASTRA_X86
+        ASTRA_TARGET("ssse3") inline void swap_periodic_ssse3(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            auto bytes = count * plan.record;
+            auto mask  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plan.mask));
+            size_t i   = 0;
+            for (; i + 64 <= bytes; i += 64) {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 16));
+                auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 32));
+                auto d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 48));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(a, mask));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 16), _mm_shuffle_epi8(b, mask));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 32), _mm_shuffle_epi8(c, mask));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 48), _mm_shuffle_epi8(d, mask));
+            }
+
+            for (; i + 16 <= bytes; i += 16) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), mask));
+            }
+
+            swap_scalar(plan, src + i, dst + i, (bytes - i) / plan.record);
+        }
+
+        ASTRA_TARGET("avx2") inline void swap_periodic_avx2(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            auto bytes = count * plan.record;
+            auto mask  = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(plan.mask)));
+            size_t i   = 0;
+            for (; i + 128 <= bytes; i += 128) {
+                auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 32));
+                auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 64));
+                auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 96));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(a, mask));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32), _mm256_shuffle_epi8(b, mask));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 64), _mm256_shuffle_epi8(c, mask));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 96), _mm256_shuffle_epi8(d, mask));
+            }
+
+            for (; i + 32 <= bytes; i += 32) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)), mask));
+            }
+
+            swap_periodic_ssse3(plan, src + i, dst + i, (bytes - i) / plan.record);
+        }
+
+        // each segment loads and stores a full 16 bytes. the bytes past its end go out unchanged and are rewritten by
+        // the next segment or group, which is also why a group is only taken while its last store stays in bounds.
+        ASTRA_TARGET("ssse3") inline void swap_segments_ssse3(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            auto stride = plan.group * plan.record;
+            auto reach  = plan.segments.back().offset + 16;
+            auto bytes  = count * plan.record;
+            size_t done = 0;
+            for (; done + reach <= bytes; done += stride) {
+                for (auto &segment : plan.segments) {
+                    auto at    = done + segment.offset;
+                    auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + at));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + at), _mm_shuffle_epi8(value, _mm_loadu_si128(reinterpret_cast<const __m128i *>(segment.mask))));
+                }
+            }
+
+            swap_scalar(plan, src + done, dst + done, (bytes - done) / plan.record);
+        }
+#endif
+
+        enum class swap_isa { scalar, ssse3, avx2 };
+
+        inline swap_isa best_swap_isa() {
+#ifdef ASTRA_X86
+            auto &cpu = cpu::current();
+            if (cpu.avx2) {
+                return swap_isa::avx2;
+            }
+
+            if (cpu.ssse3) {
+                return swap_isa::ssse3;
+            }
+#endif
+            return swap_isa::scalar;
+        }
+
+        inline void swap_range(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            if (plan.identity) {
+                if (src != dst && count > 0) {
+                    std::memcpy(dst, src, count * plan.record);
+                }
+                return;
+            }
+
+#ifdef ASTRA_X86
+            static const auto isa = best_swap_isa();
+            if (isa != swap_isa::scalar) {
+                if (!plan.periodic) {
+                    swap_segments_ssse3(plan, src, dst, count);
+                } else if (isa == swap_isa::avx2) {
+                    swap_periodic_avx2(plan, src, dst, count);
+                } else {
+                    swap_periodic_ssse3(plan, src, dst, count);
+                }
+                return;
+            }
+#endif
+            swap_scalar(plan, src, dst, count);
+        }
+
+        inline void swap_records(const swap_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count, size_t workers) {
+            auto grain = std::max<size_t>(swap_grain / plan.record, 1);
+            parallel::for_ranges(count, grain, [&](size_t first, size_t last) { swap_range(plan, src + first * plan.record, dst + first * plan.record, last - first); }, workers);
+        }
+    } // namespace detail
+
+    // copies `count` values of T from `src` to `dst` with the byte order of every field reversed. neither pointer has to
+    // be aligned, and `src` may equal `dst` for an in-place swap, but the buffers must not overlap otherwise.
+    template<byte_swappable T>
+    [[maybe_unused]] inline void byteswap_copy(const void *src, void *dst, size_t count, size_t workers = 0) {
+        detail::swap_records(detail::swap_plan<T>(), static_cast<const uint8_t *>(src), static_cast<uint8_t *>(dst), count, workers);
+    }
+
+    // reverses the byte order of every value in `values` in place.
+    template<byte_swappable T>
+    [[maybe_unused]] inline void byteswap(runtime_array<T> &values, size_t workers = 0) {
+        byteswap_copy<T>(values.data(), values.data(), values.size(), workers);
+    }
+
+    // a byte swapped copy of `values`, which are left alone.
+    template<byte_swappable T>
+    [[maybe_unused]] inline runtime_array<T> byteswap_copy(const runtime_array<T> &values, size_t workers = 0) {
+        runtime_array<T> result(nullptr, values.size());
+        byteswap_copy<T>(values.data(), result.data(), values.size(), workers);
+        return result;
+    }
+
+    // a single value with the byte order of every field reversed.
+    template<byte_swappable T>
+    [[maybe_unused]] inline T byteswap_value(const T &value) {
+        if constexpr (detail::swappable_scalar<T>) {
+            return detail::byteswap_value(value);
+        } else {
+            T result;
+            detail::swap_range(detail::swap_plan<T>(), reinterpret_cast<const uint8_t *>(&value), reinterpret_cast<uint8_t *>(&result), 1);
+            return result;
+        }
+    }
+} // namespace astra::mem
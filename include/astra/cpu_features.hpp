@@ -0,0 +1,63 @@
+#pragma once
+
+#include "macros.hpp"
+
+#if defined(ASTRA_X86) && defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+namespace astra::cpu {
+    // instruction set extensions that have an ASTRA_TARGET kernel somewhere in the library.
+    struct features {
+        bool ssse3   = false;
+        bool sse41   = false;
+        bool avx2    = false;
+        bool bmi2    = false;
+        bool f16c    = false;
+        bool avx512  = false; // F + BW + DQ + VL, the common skylake-x subset.
+    };
+
+    namespace detail {
+        inline features detect() {
+            features result = {};
+#ifdef ASTRA_X86
+#    if defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            result.ssse3  = __builtin_cpu_supports("ssse3");
+            result.sse41  = __builtin_cpu_supports("sse4.1");
+            result.avx2   = __builtin_cpu_supports("avx2");
+            result.bmi2   = __builtin_cpu_supports("bmi2");
+            result.f16c   = __builtin_cpu_supports("f16c");
+            result.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+#    elif defined(_MSC_VER)
+            int info[4] = {};
+            __cpuid(info, 0);
+            auto highest = info[0];
+
+            __cpuid(info, 1);
+            auto ecx = info[2];
+            auto os_avx = (ecx & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+            auto os_zmm = os_avx && (_xgetbv(0) & 0xE6) == 0xE6;
+            result.ssse3 = (ecx & (1 << 9)) != 0;
+            result.sse41 = (ecx & (1 << 19)) != 0;
+            result.f16c  = os_avx && (ecx & (1 << 29)) != 0;
+
+            if (highest >= 7) {
+                __cpuidex(info, 7, 0);
+                auto ebx      = info[1];
+                result.avx2   = os_avx && (ebx & (1 << 5)) != 0;
+                result.bmi2   = (ebx & (1 << 8)) != 0;
+                result.avx512 = os_zmm && (ebx & (1 << 16)) != 0 && (ebx & (1 << 17)) != 0 && (ebx & (1 << 30)) != 0 && (ebx & (1 << 31)) != 0;
+            }
+#    endif
+#endif
+            return result;
+        }
+    } // namespace detail
+
+    // the features of the running cpu, detected once.
+    [[maybe_unused]] inline const features &current() {
+        static const features instance = detail::detect();
+        return instance;
+    }
+} // namespace astra::cpu
@@ -0,0 +1,514 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "dds_support.hpp"
+
+namespace astra::gdx {
+    // what the channels of a format are, in memory order.
+    enum class dxgi_channels_t : uint8_t {
+        none,
+        r,
+        rg,
+        rgb,
+        rgba,
+        bgr,
+        bgra,
+        bgrx,
+        a,
+        depth,
+        depth_stencil,
+        yuv,
+        palette,
+    };
+
+    namespace dxgi_flags {
+        constexpr uint16_t compressed = 1 << 0;  // 4x4 block compressed (BC1-BC7).
+        constexpr uint16_t typeless   = 1 << 1;
+        constexpr uint16_t srgb       = 1 << 2;
+        constexpr uint16_t floating   = 1 << 3;
+        constexpr uint16_t unorm      = 1 << 4;
+        constexpr uint16_t snorm      = 1 << 5;
+        constexpr uint16_t uint       = 1 << 6;
+        constexpr uint16_t sint       = 1 << 7;
+        constexpr uint16_t depth      = 1 << 8;
+        constexpr uint16_t packed     = 1 << 9;  // 2x1 subsampled (R8G8_B8G8, YUY2, Y210 etc).
+        constexpr uint16_t planar     = 1 << 10; // separate luma and chroma planes (NV12, P010 etc).
+        constexpr uint16_t video      = 1 << 11;
+    } // namespace dxgi_flags
+
+    typedef struct DXGI_FORMAT_INFO {
+        uint16_t bits_per_pixel  = 0; // average for block and planar formats.
+        uint8_t block_width      = 1; // pixels covered by one block, 1x1 for plain formats.
+        uint8_t block_height     = 1;
+        uint8_t bytes_per_block  = 0;
+        dxgi_channels_t channels = dxgi_channels_t::none;
+        uint16_t flags           = 0;
+        dxgi_format_t typeless   = dxgi_format_t::UNKNOWN; // the typeless format of the same family, UNKNOWN if there is none.
+        dxgi_format_t linear     = dxgi_format_t::UNKNOWN; // the non-srgb twin, or the format itself.
+        dxgi_format_t srgb       = dxgi_format_t::UNKNOWN; // the srgb twin, UNKNOWN if there is none.
+    } dxgi_format_info_t;
+
+    constexpr size_t dxgi_format_count = static_cast<size_t>(dxgi_format_t::A4B4G4R4_UNORM) + 1;
+
+    namespace detail {
+        constexpr std::array<dxgi_format_info_t, dxgi_format_count> make_format_table() {
+            using enum dxgi_format_t;
+            using enum dxgi_channels_t;
+            namespace f = dxgi_flags;
+
+            std::array<dxgi_format_info_t, dxgi_format_count> table = {};
+
+            auto plain = [&table](dxgi_format_t format, uint16_t bits, dxgi_channels_t channels, uint16_t flags, dxgi_format_t typeless) {
+                auto &info           = table[static_cast<size_t>(format)];
+                info.bits_per_pixel  = bits;
+                info.bytes_per_block = static_cast<uint8_t>(bits / 8);
+                info.channels        = channels;
+                info.flags           = flags;
+                info.typeless        = typeless;
+            };
+
+            auto block = [&table](dxgi_format_t format, uint8_t bytes, dxgi_channels_t channels, uint16_t flags, dxgi_format_t typeless) {
+                auto &info           = table[static_cast<size_t>(format)];
+                info.bits_per_pixel  = static_cast<uint16_t>(bytes * 8 / 16);
+                info.block_width     = 4;
+                info.block_height    = 4;
+                info.bytes_per_block = bytes;
+                info.channels        = channels;
+                info.flags           = static_cast<uint16_t>(flags | f::compressed);
+                info.typeless        = typeless;
+            };
+
+            auto packed = [&table](dxgi_format_t format, uint8_t bytes, dxgi_channels_t channels, uint16_t flags) {
+                auto &info           = table[static_cast<size_t>(format)];
+                info.bits_per_pixel  = static_cast<uint16_t>(bytes * 4);
+                info.block_width     = 2;
+                info.bytes_per_block = bytes;
+                info.channels        = channels;
+                info.flags           = static_cast<uint16_t>(flags | f::packed);
+            };
+
+            auto planar = [&table](dxgi_format_t format, uint16_t bits) {
+                auto &info          = table[static_cast<size_t>(format)];
+                info.bits_per_pixel = bits;
+                info.channels       = yuv;
+                info.flags          = f::planar | f::video;
+            };
+
+            plain(R32G32B32A32_TYPELESS, 128, rgba, f::typeless, R32G32B32A32_TYPELESS);
+            plain(R32G32B32A32_FLOAT, 128, rgba, f::floating, R32G32B32A32_TYPELESS);
+            plain(R32G32B32A32_UINT, 128, rgba, f::uint, R32G32B32A32_TYPELESS);
+            plain(R32G32B32A32_SINT, 128, rgba, f::sint, R32G32B32A32_TYPELESS);
+            plain(R32G32B32_TYPELESS, 96, rgb, f::typeless, R32G32B32_TYPELESS);
+            plain(R32G32B32_FLOAT, 96, rgb, f::floating, R32G32B32_TYPELESS);
+            plain(R32G32B32_UINT, 96, rgb, f::uint, R32G32B32_TYPELESS);
+            plain(R32G32B32_SINT, 96, rgb, f::sint, R32G32B32_TYPELESS);
+            plain(R16G16B16A16_TYPELESS, 64, rgba, f::typeless, R16G16B16A16_TYPELESS);
+            plain(R16G16B16A16_FLOAT, 64, rgba, f::floating, R16G16B16A16_TYPELESS);
+            plain(R16G16B16A16_UNORM, 64, rgba, f::unorm, R16G16B16A16_TYPELESS);
+            plain(R16G16B16A16_UINT, 64, rgba, f::uint, R16G16B16A16_TYPELESS);
+            plain(R16G16B16A16_SNORM, 64, rgba, f::snorm, R16G16B16A16_TYPELESS);
+            plain(R16G16B16A16_SINT, 64, rgba, f::sint, R16G16B16A16_TYPELESS);
+            plain(R32G32_TYPELESS, 64, rg, f::typeless, R32G32_TYPELESS);
+            plain(R32G32_FLOAT, 64, rg, f::floating, R32G32_TYPELESS);
+            plain(R32G32_UINT, 64, rg, f::uint, R32G32_TYPELESS);
+            plain(R32G32_SINT, 64, rg, f::sint, R32G32_TYPELESS);
+            plain(R32G8X24_TYPELESS, 64, depth_stencil, f::typeless, R32G8X24_TYPELESS);
+            plain(D32_FLOAT_S8X24_UINT, 64, depth_stencil, f::depth | f::floating, R32G8X24_TYPELESS);
+            plain(R32_FLOAT_X8X24_TYPELESS, 64, r, f::floating, R32G8X24_TYPELESS);
+            plain(X32_TYPELESS_G8X24_UINT, 64, r, f::uint, R32G8X24_TYPELESS);
+            plain(R10G10B10A2_TYPELESS, 32, rgba, f::typeless, R10G10B10A2_TYPELESS);
+            plain(R10G10B10A2_UNORM, 32, rgba, f::unorm, R10G10B10A2_TYPELESS);
+            plain(R10G10B10A2_UINT, 32, rgba, f::uint, R10G10B10A2_TYPELESS);
+            plain(R11G11B10_FLOAT, 32, rgb, f::floating, UNKNOWN);
+            plain(R8G8B8A8_TYPELESS, 32, rgba, f::typeless, R8G8B8A8_TYPELESS);
+            plain(R8G8B8A8_UNORM, 32, rgba, f::unorm, R8G8B8A8_TYPELESS);
+            plain(R8G8B8A8_UNORM_SRGB, 32, rgba, f::unorm | f::srgb, R8G8B8A8_TYPELESS);
+            plain(R8G8B8A8_UINT, 32, rgba, f::uint, R8G8B8A8_TYPELESS);
+            plain(R8G8B8A8_SNORM, 32, rgba, f::snorm, R8G8B8A8_TYPELESS);
+            plain(R8G8B8A8_SINT, 32, rgba, f::sint, R8G8B8A8_TYPELESS);
+            plain(R16G16_TYPELESS, 32, rg, f::typeless, R16G16_TYPELESS);
+            plain(R16G16_FLOAT, 32, rg, f::floating, R16G16_TYPELESS);
+            plain(R16G16_UNORM, 32, rg, f::unorm, R16G16_TYPELESS);
+            plain(R16G16_UINT, 32, rg, f::uint, R16G16_TYPELESS);
+            plain(R16G16_SNORM, 32, rg, f::snorm, R16G16_TYPELESS);
+            plain(R16G16_SINT, 32, rg, f::sint, R16G16_TYPELESS);
+            plain(R32_TYPELESS, 32, r, f::typeless, R32_TYPELESS);
+            plain(D32_FLOAT, 32, depth, f::depth | f::floating, R32_TYPELESS);
+            plain(R32_FLOAT, 32, r, f::floating, R32_TYPELESS);
+            plain(R32_UINT, 32, r, f::uint, R32_TYPELESS);
+            plain(R32_SINT, 32, r, f::sint, R32_TYPELESS);
+            plain(R24G8_TYPELESS, 32, depth_stencil, f::typeless, R24G8_TYPELESS);
+            plain(D24_UNORM_S8_UINT, 32, depth_stencil, f::depth | f::unorm, R24G8_TYPELESS);
+            plain(R24_UNORM_X8_TYPELESS, 32, r, f::unorm, R24G8_TYPELESS);
+            plain(X24_TYPELESS_G8_UINT, 32, r, f::uint, R24G8_TYPELESS);
+            plain(R8G8_TYPELESS, 16, rg, f::typeless, R8G8_TYPELESS);
+            plain(R8G8_UNORM, 16, rg, f::unorm, R8G8_TYPELESS);
+            plain(R8G8_UINT, 16, rg, f::uint, R8G8_TYPELESS);
+            plain(R8G8_SNORM, 16, rg, f::snorm, R8G8_TYPELESS);
+            plain(R8G8_SINT, 16, rg, f::sint, R8G8_TYPELESS);
+            plain(R16_TYPELESS, 16, r, f::typeless, R16_TYPELESS);
+            plain(R16_FLOAT, 16, r, f::floating, R16_TYPELESS);
+            plain(D16_UNORM, 16, depth, f::depth | f::unorm, R16_TYPELESS);
+            plain(R16_UNORM, 16, r, f::unorm, R16_TYPELESS);
+            plain(R16_UINT, 16, r, f::uint, R16_TYPELESS);
+            plain(R16_SNORM, 16, r, f::snorm, R16_TYPELESS);
+            plain(R16_SINT, 16, r, f::sint, R16_TYPELESS);
+            plain(R8_TYPELESS, 8, r, f::typeless, R8_TYPELESS);
+            plain(R8_UNORM, 8, r, f::unorm, R8_TYPELESS);
+            plain(R8_UINT, 8, r, f::uint, R8_TYPELESS);
+            plain(R8_SNORM, 8, r, f::snorm, R8_TYPELESS);
+            plain(R8_SINT, 8, r, f::sint, R8_TYPELESS);
+            plain(A8_UNORM, 8, a, f::unorm, UNKNOWN);
+            plain(R9G9B9E5_SHAREDEXP, 32, rgb, f::floating, UNKNOWN);
+            plain(B5G6R5_UNORM, 16, bgr, f::unorm, UNKNOWN);
+            plain(B5G5R5A1_UNORM, 16, bgra, f::unorm, UNKNOWN);
+            plain(B8G8R8A8_UNORM, 32, bgra, f::unorm, B8G8R8A8_TYPELESS);
+            plain(B8G8R8X8_UNORM, 32, bgrx, f::unorm, B8G8R8X8_TYPELESS);
+            plain(R10G10B10_XR_BIAS_A2_UNORM, 32, rgba, f::unorm, R10G10B10A2_TYPELESS);
+            plain(B8G8R8A8_TYPELESS, 32, bgra, f::typeless, B8G8R8A8_TYPELESS);
+            plain(B8G8R8A8_UNORM_SRGB, 32, bgra, f::unorm | f::srgb, B8G8R8A8_TYPELESS);
+            plain(B8G8R8X8_TYPELESS, 32, bgrx, f::typeless, B8G8R8X8_TYPELESS);
+            plain(B8G8R8X8_UNORM_SRGB, 32, bgrx, f::unorm | f::srgb, B8G8R8X8_TYPELESS);
+            plain(AYUV, 32, yuv, f::video, UNKNOWN);
+            plain(Y410, 32, yuv, f::video, UNKNOWN);
+            plain(Y416, 64, yuv, f::video, UNKNOWN);
+            plain(AI44, 8, palette, f::video, UNKNOWN);
+            plain(IA44, 8, palette, f::video, UNKNOWN);
+            plain(P8, 8, palette, f::video, UNKNOWN);
+            plain(A8P8, 16, palette, f::video, UNKNOWN);
+            plain(B4G4R4A4_UNORM, 16, bgra, f::unorm, UNKNOWN);
+            plain(A4B4G4R4_UNORM, 16, rgba, f::unorm, UNKNOWN);
+
+            // one byte covers 8 pixels.
+            table[static_cast<size_t>(R1_UNORM)] = {1, 8, 1, 1, r, f::unorm, UNKNOWN, UNKNOWN, UNKNOWN};
+
+            block(BC1_TYPELESS, 8, rgba, f::typeless, BC1_TYPELESS);
+            block(BC1_UNORM, 8, rgba, f::unorm, BC1_TYPELESS);
+            block(BC1_UNORM_SRGB, 8, rgba, f::unorm | f::srgb, BC1_TYPELESS);
+            block(BC2_TYPELESS, 16, rgba, f::typeless, BC2_TYPELESS);
+            block(BC2_UNORM, 16, rgba, f::unorm, BC2_TYPELESS);
+            block(BC2_UNORM_SRGB, 16, rgba, f::unorm | f::srgb, BC2_TYPELESS);
+            block(BC3_TYPELESS, 16, rgba, f::typeless, BC3_TYPELESS);
+            block(BC3_UNORM, 16, rgba, f::unorm, BC3_TYPELESS);
+            block(BC3_UNORM_SRGB, 16, rgba, f::unorm | f::srgb, BC3_TYPELESS);
+            block(BC4_TYPELESS, 8, r, f::typeless, BC4_TYPELESS);
+            block(BC4_UNORM, 8, r, f::unorm, BC4_TYPELESS);
+            block(BC4_SNORM, 8, r, f::snorm, BC4_TYPELESS);
+            block(BC5_TYPELESS, 16, rg, f::typeless, BC5_TYPELESS);
+            block(BC5_UNORM, 16, rg, f::unorm, BC5_TYPELESS);
+            block(BC5_SNORM, 16, rg, f::snorm, BC5_TYPELESS);
+            block(BC6H_TYPELESS, 16, rgb, f::typeless, BC6H_TYPELESS);
+            block(BC6H_UF16, 16, rgb, f::floating, BC6H_TYPELESS);
+            block(BC6H_SF16, 16, rgb, f::floating, BC6H_TYPELESS);
+            block(BC7_TYPELESS, 16, rgba, f::typeless, BC7_TYPELESS);
+            block(BC7_UNORM, 16, rgba, f::unorm, BC7_TYPELESS);
+            block(BC7_UNORM_SRGB, 16, rgba, f::unorm | f::srgb, BC7_TYPELESS);
+
+            packed(R8G8_B8G8_UNORM, 4, rgb, f::unorm);
+            packed(G8R8_G8B8_UNORM, 4, rgb, f::unorm);
+            packed(YUY2, 4, yuv, f::video);
+            packed(Y210, 8, yuv, f::video);
+            packed(Y216, 8, yuv, f::video);
+
+            planar(NV12, 12);
+            planar(P010, 24);
+            planar(P016, 24);
+            planar(OPAQUE420, 12);
+            planar(NV11, 12);
+            planar(P208, 16);
+            planar(V208, 16);
+            planar(V408, 24);
+
+            for (size_t i = 0; i < table.size(); ++i) {
+                table[i].linear = static_cast<dxgi_format_t>(i);
+            }
+
+            auto twins = [&table](dxgi_format_t linear, dxgi_format_t srgb) {
+                table[static_cast<size_t>(linear)].srgb = srgb;
+                table[static_cast<size_t>(srgb)].srgb   = srgb;
+                table[static_cast<size_t>(srgb)].linear = linear;
+            };
+
+            twins(R8G8B8A8_UNORM, R8G8B8A8_UNORM_SRGB);
+            twins(B8G8R8A8_UNORM, B8G8R8A8_UNORM_SRGB);
+            twins(B8G8R8X8_UNORM, B8G8R8X8_UNORM_SRGB);
+            twins(BC1_UNORM, BC1_UNORM_SRGB);
+            twins(BC2_UNORM, BC2_UNORM_SRGB);
+            twins(BC3_UNORM, BC3_UNORM_SRGB);
+            twins(BC7_UNORM, BC7_UNORM_SRGB);
+
+            return table;
+        }
+    } // namespace detail
+
+    constexpr std::array<dxgi_format_info_t, dxgi_format_count> dxgi_format_table = detail::make_format_table();
+
+    [[maybe_unused]] constexpr const dxgi_format_info_t &format_info(dxgi_format_t format) {
+        auto index = static_cast<size_t>(format);
+        return dxgi_format_table[index < dxgi_format_count ? index : 0];
+    }
+
+    [[maybe_unused]] constexpr bool is_compressed(dxgi_format_t format) { return (format_info(format).flags & dxgi_flags::compressed) != 0; }
+
+    [[maybe_unused]] constexpr bool is_srgb(dxgi_format_t format) { return (format_info(format).flags & dxgi_flags::srgb) != 0; }
+
+    [[maybe_unused]] constexpr bool is_typeless(dxgi_format_t format) { return (format_info(format).flags & dxgi_flags::typeless) != 0; }
+
+    typedef struct DXGI_PITCH {
+        uint64_t row = 0;   // bytes per row of pixels, or per row of blocks for compressed formats.
+        uint64_t slice = 0; // bytes per 2d image.
+    } dxgi_pitch_t;
+
+    // the row and slice pitch of a tightly packed width x height image, following the d3d rules.
+    [[maybe_unused]] constexpr dxgi_pitch_t compute_pitch(dxgi_format_t format, uint32_t width, uint32_t height) {
+        using enum dxgi_format_t;
+
+        uint64_t w = width;
+        uint64_t h = height;
+        switch (format) {
+            case NV12:
+            case OPAQUE420: {
+                auto row = ((w + 1) >> 1) * 2;
+                return {row, row * (h + ((h + 1) >> 1))};
+            }
+            case P010:
+            case P016: {
+                auto row = ((w + 1) >> 1) * 4;
+                return {row, row * (h + ((h + 1) >> 1))};
+            }
+            case NV11: {
+                auto row = ((w + 3) >> 2) * 4;
+                return {row, row * h * 2};
+            }
+            case P208: {
+                auto row = ((w + 1) >> 1) * 2;
+                return {row, row * h * 2};
+            }
+            case V208: return {w, w * (h + (((h + 1) >> 1) * 2))};
+            case V408: return {w, w * (h + ((h >> 1) * 4))};
+            default: break;
+        }
+
+        auto &info = format_info(format);
+        if (info.block_width > 1 || info.block_height > 1) {
+            auto blocks_wide = std::max<uint64_t>(1, (w + info.block_width - 1) / info.block_width);
+            auto blocks_high = std::max<uint64_t>(1, (h + info.block_height - 1) / info.block_height);
+            auto row         = blocks_wide * info.bytes_per_block;
+            return {row, row * blocks_high};
+        }
+
+        auto row = (w * info.bits_per_pixel + 7) / 8;
+        return {row, row * h};
+    }
+
+    // resolves the dxgi format of a header, including legacy (pre-DX10) four character codes and bit masks.
+    [[maybe_unused]] constexpr dxgi_format_t dds_format(const dds10_t &header) {
+        using enum dxgi_format_t;
+
+        constexpr auto code = [](const char(&text)[5]) { return static_cast<uint32_t>(text[0]) | static_cast<uint32_t>(text[1]) << 8 | static_cast<uint32_t>(text[2]) << 16 | static_cast<uint32_t>(text[3]) << 24; };
+
+        auto &pf = header.dx9.pixel_format;
+        if ((pf.flags & 0x4) != 0) { // DDPF_FOURCC
+            switch (pf.fourCC) {
+                case code("DX10"): return header.dx10.format;
+                case code("DXT1"): return BC1_UNORM;
+                case code("DXT2"):
+                case code("DXT3"): return BC2_UNORM;
+                case code("DXT4"):
+                case code("DXT5"): return BC3_UNORM;
+                case code("ATI1"):
+                case code("BC4U"): return BC4_UNORM;
+                case code("BC4S"): return BC4_SNORM;
+                case code("ATI2"):
+                case code("BC5U"): return BC5_UNORM;
+                case code("BC5S"): return BC5_SNORM;
+                case code("RGBG"): return R8G8_B8G8_UNORM;
+                case code("GRGB"): return G8R8_G8B8_UNORM;
+                case code("YUY2"): return YUY2;
+                // D3DFORMAT values.
+                case 36: return R16G16B16A16_UNORM;
+                case 110: return R16G16B16A16_SNORM;
+                case 111: return R16_FLOAT;
+                case 112: return R16G16_FLOAT;
+                case 113: return R16G16B16A16_FLOAT;
+                case 114: return R32_FLOAT;
+                case 115: return R32G32_FLOAT;
+                case 116: return R32G32B32A32_FLOAT;
+                default: return UNKNOWN;
+            }
+        }
+
+        auto masks = [&pf](uint32_t r, uint32_t g, uint32_t b, uint32_t a) { return pf.RBitMask == r && pf.GBitMask == g && pf.BBitMask == b && pf.ABitMask == a; };
+        switch (pf.RGBBitCount) {
+            case 32:
+                if (masks(0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000)) return R8G8B8A8_UNORM;
+                if (masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000)) return B8G8R8A8_UNORM;
+                if (masks(0x00FF0000, 0x0000FF00, 0x000000FF, 0)) return B8G8R8X8_UNORM;
+                // d3dx writes 10:10:10:2 with the red and blue masks swapped, both mean the same thing.
+                if (masks(0x3FF00000, 0x000FFC00, 0x000003FF, 0xC0000000) || masks(0x000003FF, 0x000FFC00, 0x3FF00000, 0xC0000000)) return R10G10B10A2_UNORM;
+                if (masks(0x0000FFFF, 0xFFFF0000, 0, 0)) return R16G16_UNORM;
+                if (masks(0xFFFFFFFF, 0, 0, 0)) return R32_FLOAT;
+                break;
+            case 16:
+                if (masks(0xF800, 0x07E0, 0x001F, 0)) return B5G6R5_UNORM;
+                if (masks(0x7C00, 0x03E0, 0x001F, 0x8000)) return B5G5R5A1_UNORM;
+                if (masks(0x0F00, 0x00F0, 0x000F, 0xF000)) return B4G4R4A4_UNORM;
+                if (masks(0x00FF, 0, 0, 0xFF00)) return R8G8_UNORM;
+                if (masks(0xFFFF, 0, 0, 0)) return R16_UNORM;
+                break;
+            case 8:
+                if (masks(0xFF, 0, 0, 0)) return R8_UNORM;
+                if (masks(0, 0, 0, 0xFF)) return A8_UNORM;
+                break;
+            default: break;
+        }
+
+        return UNKNOWN;
+    }
+
+    // one mip level of one face of one array slice.
+    typedef struct DDS_SUBRESOURCE {
+        uint64_t offset      = 0; // from the start of the payload, right after the header.
+        uint64_t size        = 0;
+        uint64_t row_pitch   = 0;
+        uint64_t slice_pitch = 0;
+        uint32_t width       = 0;
+        uint32_t height      = 0;
+        uint32_t depth       = 0;
+        uint32_t mip         = 0;
+        uint32_t slice       = 0;
+        uint32_t face        = 0;
+    } dds_subresource_t;
+
+    // the caps2 bits of the cube faces a header stores, 0 if it isn't a cubemap. legacy cubemaps can omit faces, DX10
+    // cubemaps hold all six unless caps2 flags fewer, which is how dds_layout::header() writes a partial cubemap.
+    [[maybe_unused]] constexpr uint32_t dds_cube_faces(const dds10_t &header) {
+        auto dx10    = header.dx9.pixel_format.fourCC == 0x30315844 && (header.dx9.pixel_format.flags & 0x4) != 0;
+        auto flagged = (header.dx9.caps2 & 0x200) != 0 ? header.dx9.caps2 & 0xFC00 : 0;
+        if (!dx10) {
+            return flagged;
+        }
+        return (header.dx10.flags & 0x4) == 0 ? 0 : flagged != 0 ? flagged : 0xFC00;
+    }
+
+    // precomputes where every subresource of a dds payload lives, so any of them can be found in O(1).
+    // the payload stores every array slice, then every face, then every mip in that order.
+    class dds_layout {
+    private:
+        std::vector<dds_subresource_t> subresources;
+
+    public:
+        dxgi_format_t format = dxgi_format_t::UNKNOWN;
+        uint32_t width       = 0;
+        uint32_t height      = 0;
+        uint32_t depth       = 1;
+        uint32_t mip_count   = 1;
+        uint32_t array_size  = 1;
+        uint32_t face_count  = 1;
+        uint32_t cube_faces  = 0; // the caps2 bits of the stored faces, 0 if this isn't a cubemap.
+        uint64_t payload_size = 0;
+
+        dds_layout() = default;
+
+        explicit dds_layout(const dds10_t &header) {
+            auto dx10 = header.dx9.pixel_format.fourCC == 0x30315844 && (header.dx9.pixel_format.flags & 0x4) != 0;
+
+            format    = dds_format(header);
+            width     = std::max<uint32_t>(header.dx9.width, 1);
+            height    = std::max<uint32_t>(header.dx9.height, 1);
+            mip_count = std::max<uint32_t>(header.dx9.mip_count, 1);
+
+            auto volume = dx10 ? header.dx10.resource_dimension == 4 : (header.dx9.caps2 & 0x200000) != 0;
+            depth       = volume ? std::max<uint32_t>(header.dx9.depth, 1) : 1;
+
+            if (dx10) {
+                array_size = std::max<uint32_t>(header.dx10.array_size, 1);
+            }
+
+            cube_faces = dds_cube_faces(header);
+            if (!dx10 && (header.dx9.caps2 & 0x200) != 0 && cube_faces == 0) {
+                throw std::invalid_argument("dds cubemap has no faces");
+            }
+            face_count = cube_faces != 0 ? static_cast<uint32_t>(std::popcount(cube_faces)) : 1;
+
+            build();
+        }
+
+        dds_layout(dxgi_format_t format, uint32_t width, uint32_t height, uint32_t mip_count = 1, uint32_t array_size = 1, bool cubemap = false, uint32_t depth = 1) : format(format), width(std::max<uint32_t>(width, 1)), height(std::max<uint32_t>(height, 1)), depth(std::max<uint32_t>(depth, 1)), mip_count(std::max<uint32_t>(mip_count, 1)), array_size(std::max<uint32_t>(array_size, 1)), face_count(cubemap ? 6 : 1), cube_faces(cubemap ? 0xFC00 : 0) { build(); }
+
+        void build() {
+            subresources.clear();
+            subresources.reserve(static_cast<size_t>(array_size) * face_count * mip_count);
+
+            uint64_t offset = 0;
+            for (uint32_t slice = 0; slice < array_size; ++slice) {
+                for (uint32_t face = 0; face < face_count; ++face) {
+                    for (uint32_t mip = 0; mip < mip_count; ++mip) {
+                        dds_subresource_t entry = {};
+                        entry.width             = std::max<uint32_t>(width >> mip, 1);
+                        entry.height            = std::max<uint32_t>(height >> mip, 1);
+                        entry.depth             = std::max<uint32_t>(depth >> mip, 1);
+                        auto pitch              = compute_pitch(format, entry.width, entry.height);
+                        entry.row_pitch         = pitch.row;
+                        entry.slice_pitch       = pitch.slice;
+                        entry.size              = pitch.slice * entry.depth;
+                        entry.offset            = offset;
+                        entry.mip               = mip;
+                        entry.slice             = slice;
+                        entry.face              = face;
+                        offset += entry.size;
+                        subresources.push_back(entry);
+                    }
+                }
+            }
+
+            payload_size = offset;
+        }
+
+        [[nodiscard]] size_t subresource_count() const { return subresources.size(); }
+
+        [[nodiscard]] size_t index(uint32_t mip, uint32_t slice = 0, uint32_t face = 0) const {
+            assert(mip < mip_count && slice < array_size && face < face_count);
+            return (static_cast<size_t>(slice) * face_count + face) * mip_count + mip;
+        }
+
+        [[nodiscard]] const dds_subresource_t &subresource(uint32_t mip, uint32_t slice = 0, uint32_t face = 0) const { return subresources[index(mip, slice, face)]; }
+
+        [[nodiscard]] const dds_subresource_t &operator[](size_t index) const { return subresources[index]; }
+
+        [[nodiscard]] auto begin() const { return subresources.begin(); }
+
+        [[nodiscard]] auto end() const { return subresources.end(); }
+
+        // a header that describes exactly this layout, always in the DX10 form. a partial cubemap keeps its face bits in
+        // caps2, which dds_cube_faces reads back.
+        [[nodiscard]] dds10_t header() const {
+            dds10_t result     = {};
+            auto &info         = format_info(format);
+            auto pitch         = compute_pitch(format, width, height);
+            auto compressed    = (info.flags & dxgi_flags::compressed) != 0;
+
+            result.dx9.width        = width;
+            result.dx9.height       = height;
+            result.dx9.depth        = depth;
+            result.dx9.mip_count    = mip_count;
+            result.dx9.linear_size  = static_cast<uint32_t>(compressed ? pitch.slice : pitch.row);
+            result.dx9.flags        = 0x1007 | (compressed ? 0x80000 : 0x8) | (mip_count > 1 ? 0x20000 : 0) | (depth > 1 ? 0x800000 : 0);
+            result.dx9.caps         = 0x1000 | (mip_count > 1 ? 0x400008 : 0) | (cube_faces != 0 || depth > 1 || array_size > 1 ? 0x8 : 0);
+            result.dx9.caps2        = (cube_faces != 0 ? 0x200 | cube_faces : 0) | (depth > 1 ? 0x200000 : 0);
+            result.dx10.format      = format;
+            result.dx10.resource_dimension = depth > 1 ? 4 : 3;
+            result.dx10.flags       = cube_faces != 0 ? 0x4 : 0;
+            result.dx10.array_size  = array_size;
+            return result;
+        }
+    };
+} // namespace astra::gdx
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "dds_layout.hpp"
+#include "dds_support.hpp"
+#include "file_helper.hpp"
+#include "runtime_array.hpp"
+
+// reads single subresources of a dds file without loading the rest of it. the constructor reads and validates nothing
+// but the header, straight into the packed dds10_t, every subresource() call then reads or maps exactly the bytes of
+// that subresource. positioned reads share no file cursor, so one reader can serve many threads at once.
+
+namespace astra::gdx {
+    enum class dds_access {
+        read, // positioned reads into a fresh buffer.
+        map,  // a view of the pages covering the subresource, nothing is read until it is touched.
+    };
+
+    struct dds_reader_options_t {
+        dds_access access   = dds_access::read;
+        uint32_t read_ahead = 0; // how many of the following mips subresource() asks the os to start loading.
+    };
+
+    namespace detail {
+        inline constexpr uint32_t dds_magic       = 0x20534444; // "DDS "
+        inline constexpr uint32_t dds_fourcc_dx10 = 0x30315844; // "DX10"
+        inline constexpr uint32_t dds_max_mips    = 32;
+        // generous next to d3d's own limits (16384 texels, 2048 slices), they only keep a forged header from sizing a
+        // layout that cannot exist.
+        inline constexpr uint32_t dds_max_dimension  = 1 << 16;
+        inline constexpr uint32_t dds_max_array_size = 1 << 12;
+
+        // dds files are little endian. both header structs are nothing but 32-bit words, so on big endian hosts they
+        // are swapped in place.
+        template<typename T>
+        inline void dds_to_native([[maybe_unused]] T &header) {
+            static_assert(sizeof(T) % 4 == 0);
+            if constexpr (std::endian::native == std::endian::big) {
+                uint32_t words[sizeof(T) / 4];
+                std::memcpy(words, &header, sizeof(T));
+                for (auto &word : words) {
+                    word = std::byteswap(word);
+                }
+                std::memcpy(&header, words, sizeof(T));
+            }
+        }
+
+        // a read-only file handle for positioned reads and ranged mappings.
+        class dds_file_t {
+        private:
+#ifndef WIN32
+            int fd = -1;
+#else
+            HANDLE handle = INVALID_HANDLE_VALUE;
+#endif
+            std::filesystem::path path;
+
+            [[noreturn]] void fail(int error) const { throw std::system_error(error, std::generic_category(), path.string()); }
+
+            void reset() {
+#ifndef WIN32
+                if (fd >= 0) {
+                    close(fd);
+                    fd = -1;
+                }
+#else
+                if (handle != INVALID_HANDLE_VALUE) {
+                    CloseHandle(handle);
+                    handle = INVALID_HANDLE_VALUE;
+                }
+#endif
+            }
+
+        public:
+            uint64_t size = 0;
+
+            dds_file_t() = default;
+
+            explicit dds_file_t(std::filesystem::path file_path) : path(std::move(file_path)) {
+#ifndef WIN32
+                fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    fail(errno);
+                }
+
+                struct stat info = {};
+                if (fstat(fd, &info) != 0) {
+                    auto error = errno;
+                    close(fd);
+                    fd = -1;
+                    fail(error);
+                }
+                size = static_cast<uint64_t>(info.st_size);
+#else
+                handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (handle == INVALID_HANDLE_VALUE) {
+                    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+                }
+
+                LARGE_INTEGER file_size = {};
+                GetFileSizeEx(handle, &file_size);
+                size = static_cast<uint64_t>(file_size.QuadPart);
+#endif
+            }
+
+            dds_file_t(const dds_file_t &) = delete;
+            dds_file_t &operator=(const dds_file_t &) = delete;
+
+            dds_file_t(dds_file_t &&other) noexcept { *this = std::move(other); }
+
+            dds_file_t &operator=(dds_file_t &&other) noexcept {
+                if (this != &other) {
+                    reset();
+#ifndef WIN32
+                    fd = std::exchange(other.fd, -1);
+#else
+                    handle = std::exchange(other.handle, INVALID_HANDLE_VALUE);
+#endif
+                    path = std::move(other.path);
+                    size = std::exchange(other.size, 0);
+                }
+                return *this;
+            }
+
+            ~dds_file_t() { reset(); }
+
+            // reads up to `count` bytes at `offset`, returns how many were read before the end of the file.
+            size_t read_at(uint64_t offset, void *buffer, size_t count) const {
+                auto bytes   = static_cast<uint8_t *>(buffer);
+                size_t total = 0;
+                while (total < count) {
+#ifndef WIN32
+                    auto result = ::pread(fd, bytes + total, count - total, static_cast<off_t>(offset + total));
+                    if (result < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (result < 0) {
+                        fail(errno);
+                    }
+#else
+                    OVERLAPPED position = {};
+                    position.Offset     = static_cast<DWORD>(offset + total);
+                    position.OffsetHigh = static_cast<DWORD>((offset + total) >> 32);
+                    DWORD result        = 0;
+                    auto chunk          = static_cast<DWORD>(std::min<size_t>(count - total, 1u << 30));
+                    if (!ReadFile(handle, bytes + total, chunk, &result, &position) && GetLastError() != ERROR_HANDLE_EOF) {
+                        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+                    }
+#endif
+                    if (result == 0) {
+                        break;
+                    }
+                    total += static_cast<size_t>(result);
+                }
+                return total;
+            }
+
+            // maps the pages covering [offset, offset + count), the view is released with the last array sharing it.
+            astra::mem::runtime_array<uint8_t> map(uint64_t offset, size_t count) const {
+#ifndef WIN32
+                auto granularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+                auto base        = offset - offset % granularity;
+                auto length      = static_cast<size_t>(offset - base) + count;
+                auto address     = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(base));
+                if (address == MAP_FAILED) {
+                    fail(errno);
+                }
+
+                auto storage = std::shared_ptr<uint8_t[]>(static_cast<uint8_t *>(address), [length](uint8_t *p) { munmap(p, length); });
+#else
+                SYSTEM_INFO system = {};
+                GetSystemInfo(&system);
+                auto granularity = static_cast<uint64_t>(system.dwAllocationGranularity);
+                auto base        = offset - offset % granularity;
+                auto length      = static_cast<size_t>(offset - base) + count;
+
+                auto mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping == nullptr) {
+                    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+                }
+
+                auto address = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(base >> 32), static_cast<DWORD>(base), length);
+                auto error   = GetLastError();
+                CloseHandle(mapping); // the view holds its own reference to the mapping.
+                if (address == nullptr) {
+                    throw std::system_error(static_cast<int>(error), std::system_category(), path.string());
+                }
+
+                auto storage = std::shared_ptr<uint8_t[]>(static_cast<uint8_t *>(address), [](uint8_t *p) { UnmapViewOfFile(p); });
+#endif
+                return {std::move(storage), static_cast<size_t>(offset - base), count};
+            }
+
+            // asks the os to start reading a range into the page cache, reads and mappings of it then find it there.
+            void will_need([[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t count) const {
+#if !defined(WIN32) && defined(POSIX_FADV_WILLNEED)
+                posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(count), POSIX_FADV_WILLNEED);
+#endif
+            }
+        };
+    } // namespace detail
+
+    class dds_reader {
+    private:
+        detail::dds_file_t file;
+        dds10_t parsed = {};
+        dds_layout shape;
+        uint64_t payload_start = 0;
+        dds_reader_options_t settings;
+
+        // checks the raw header before a dds_layout is built from it: every field that sizes the layout is held to a
+        // fixed limit, and the payload it describes, summed without building anything, has to fit in the file.
+        void validate(bool dx10) const {
+            auto &dx9 = parsed.dx9;
+            if (dx9.size != sizeof(dds_t) - sizeof(dx9.magic) || dx9.pixel_format.size != sizeof(dds_pixel_format_t)) {
+                throw std::invalid_argument("dds header has the wrong size");
+            }
+
+            if (dx9.mip_count > detail::dds_max_mips) {
+                throw std::invalid_argument("dds header has too many mips");
+            }
+
+            if (dx9.width > detail::dds_max_dimension || dx9.height > detail::dds_max_dimension) {
+                throw std::invalid_argument("dds header is too large");
+            }
+
+            auto volume    = (dx9.caps2 & 0x200000) != 0;
+            uint32_t array = 1;
+            auto cube      = dds_cube_faces(parsed);
+            uint32_t faces = cube != 0 ? static_cast<uint32_t>(std::popcount(cube)) : 1;
+            if (dx10) {
+                auto &ext = parsed.dx10;
+                if (ext.resource_dimension < 2 || ext.resource_dimension > 4) {
+                    throw std::invalid_argument("dds header has an unknown resource dimension");
+                }
+
+                if (ext.array_size == 0 || ext.array_size > detail::dds_max_array_size || (ext.resource_dimension == 4 && ext.array_size != 1)) {
+                    throw std::invalid_argument("dds header has an invalid array size");
+                }
+
+                if (static_cast<size_t>(ext.format) >= dxgi_format_count) {
+                    throw std::invalid_argument("dds header has an unknown dxgi format");
+                }
+
+                volume = ext.resource_dimension == 4;
+                array  = ext.array_size;
+            }
+
+            if (volume && dx9.depth > detail::dds_max_dimension) {
+                throw std::invalid_argument("dds header is too large");
+            }
+
+            auto format = dds_format(parsed);
+            if (format == dxgi_format_t::UNKNOWN || format_info(format).bits_per_pixel == 0) {
+                throw std::invalid_argument("dds header has an unsupported pixel format");
+            }
+
+            if (!dx10 && (dx9.caps2 & 0x200) != 0 && cube == 0) {
+                throw std::invalid_argument("dds cubemap has no faces");
+            }
+
+            // a mip chain is below 2^16 * 2^16 * 2^16 texels of 16 bytes, so chain fits, the product with the slices may not.
+            auto width     = std::max<uint32_t>(dx9.width, 1);
+            auto height    = std::max<uint32_t>(dx9.height, 1);
+            auto depth     = volume ? std::max<uint32_t>(dx9.depth, 1) : 1;
+            uint64_t chain = 0;
+            for (uint32_t mip = 0; mip < std::max<uint32_t>(dx9.mip_count, 1); ++mip) {
+                chain += compute_pitch(format, std::max<uint32_t>(width >> mip, 1), std::max<uint32_t>(height >> mip, 1)).slice * std::max<uint32_t>(depth >> mip, 1);
+            }
+
+            if ((file.size - payload_start) / (static_cast<uint64_t>(array) * faces) < chain) {
+                throw std::out_of_range("dds file is smaller than its header describes");
+            }
+        }
+
+        [[nodiscard]] const dds_subresource_t &locate(uint32_t mip, uint32_t slice, uint32_t face) const {
+            if (mip >= shape.mip_count || slice >= shape.array_size || face >= shape.face_count) {
+                throw std::out_of_range("dds subresource does not exist");
+            }
+            return shape.subresource(mip, slice, face);
+        }
+
+    public:
+        dds_reader() = default;
+
+        // opens a dds file and reads its header, throws if the header is malformed or the file is too short for it.
+        explicit dds_reader(const std::filesystem::path &path, const dds_reader_options_t &options = {}) : file(path), settings(options) {
+            if (file.size < sizeof(dds_t)) {
+                throw std::invalid_argument("file is too small to be a dds file");
+            }
+
+            if (file.read_at(0, &parsed.dx9, sizeof(dds_t)) != sizeof(dds_t)) {
+                throw std::out_of_range("dds file ended inside its header");
+            }
+            detail::dds_to_native(parsed.dx9);
+
+            if (parsed.dx9.magic != detail::dds_magic) {
+                throw std::invalid_argument(std::byteswap(parsed.dx9.magic) == detail::dds_magic ? "dds header has the wrong byte order" : "not a dds file");
+            }
+
+            auto dx10     = (parsed.dx9.pixel_format.flags & 0x4) != 0 && parsed.dx9.pixel_format.fourCC == detail::dds_fourcc_dx10;
+            payload_start = sizeof(dds_t);
+            if (dx10) {
+                if (file.read_at(sizeof(dds_t), &parsed.dx10, sizeof(dx10_t)) != sizeof(dx10_t)) {
+                    throw std::out_of_range("dds file ended inside its header");
+                }
+                detail::dds_to_native(parsed.dx10);
+                payload_start += sizeof(dx10_t);
+            }
+
+            validate(dx10);
+            shape = dds_layout(parsed);
+        }
+
+        [[nodiscard]] const dds10_t &header() const { return parsed; }
+
+        [[nodiscard]] const dds_layout &layout() const { return shape; }
+
+        // where the payload starts in the file, right after the 128 or 148 byte header.
+        [[nodiscard]] uint64_t payload_offset() const { return payload_start; }
+
+        // the bytes of one subresource, read or mapped depending on the reader's access mode. mapped views stay valid
+        // after the reader is gone.
+        [[nodiscard]] astra::mem::runtime_array<uint8_t> subresource(uint32_t mip, uint32_t slice = 0, uint32_t face = 0) const {
+            auto &entry = locate(mip, slice, face);
+            if (settings.read_ahead > 0 && mip + 1 < shape.mip_count) {
+                prefetch(mip + 1, slice, face, settings.read_ahead);
+            }
+
+            if (settings.access == dds_access::map) {
+                return file.map(payload_start + entry.offset, static_cast<size_t>(entry.size));
+            }
+
+            astra::mem::runtime_array<uint8_t> bytes(nullptr, static_cast<size_t>(entry.size));
+            read(mip, slice, face, bytes.data());
+            return bytes;
+        }
+
+        // reads one subresource into caller memory, which must hold layout().subresource(mip, slice, face).size bytes.
+        void read(uint32_t mip, uint32_t slice, uint32_t face, uint8_t *dst) const {
+            auto &entry = locate(mip, slice, face);
+            if (file.read_at(payload_start + entry.offset, dst, static_cast<size_t>(entry.size)) != entry.size) {
+                throw std::out_of_range("dds file ended inside a subresource");
+            }
+        }
+
+        // hints that mips [mip, mip + count) of a slice and face are needed soon, they are contiguous in the file so
+        // this is a single request.
+        void prefetch(uint32_t mip, uint32_t slice = 0, uint32_t face = 0, uint32_t count = 1) const {
+            auto &first = locate(mip, slice, face);
+            auto &last  = locate(std::min(mip + std::max<uint32_t>(count, 1), shape.mip_count) - 1, slice, face);
+            file.will_need(payload_start + first.offset, last.offset + last.size - first.offset);
+        }
+    };
+} // namespace astra::gdx
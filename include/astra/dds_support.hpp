@@ -152,12 +152,13 @@ namespace astra::gdx {
         P8,
         A8P8,
         B4G4R4A4_UNORM,
-        P208,
+        P208 = 130,
         V208,
         V408,
-        SAMPLER_FEEDBACK_MIN_MIP_OPAQUE,
+        SAMPLER_FEEDBACK_MIN_MIP_OPAQUE = 189,
         SAMPLER_FEEDBACK_MIP_REGION_USED_OPAQUE,
-        FORCE_UINT
+        A4B4G4R4_UNORM,
+        FORCE_UINT = 0xFFFFFFFF
     } dxgi_format_t;
 
     typedef struct DDS_HEADER_DXT10 {
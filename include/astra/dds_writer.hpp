@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "dds_layout.hpp"
+#include "dds_support.hpp"
+#include "file_helper.hpp"
+#include "parallel.hpp"
+#include "runtime_array.hpp"
+
+#ifndef WIN32
+#    include <sys/uio.h>
+#endif
+
+// writes dds files straight from per-subresource buffers, the header and payload are never concatenated. buffers go
+// out in dds order with vectored writes (pwritev), as many per call as the os allows. producer callbacks fill a
+// bounded staging batch instead, the next batch is produced while the previous one is being written.
+
+namespace astra::gdx {
+    // fills `dst` with the subresource.size bytes of one subresource. called once per subresource, in file order.
+    using dds_producer = std::function<void(const dds_subresource_t &subresource, uint8_t *dst)>;
+
+    struct dds_write_options_t {
+        bool preallocate   = false;   // reserve the whole file up front so the filesystem can lay it out in one piece.
+        size_t batch_bytes = 8 << 20; // producer output staged per write, two batches are alive at a time.
+    };
+
+    // one file for write_dds_files, either `subresources` (in dds_layout order) or `producer` is used.
+    struct dds_write_job_t {
+        std::filesystem::path path;
+        dds10_t header = {};
+        std::vector<astra::mem::runtime_array<uint8_t>> subresources;
+        dds_producer producer;
+    };
+
+    namespace detail {
+        // one contiguous piece of output, an iovec on posix systems.
+        struct dds_chunk_t {
+            const uint8_t *data = nullptr;
+            size_t size         = 0;
+        };
+
+        // a write-only file handle for positioned, vectored writes.
+        class dds_sink_t {
+        private:
+#ifndef WIN32
+            int fd = -1;
+#else
+            HANDLE handle = INVALID_HANDLE_VALUE;
+#endif
+            std::filesystem::path path;
+
+            [[noreturn]] void fail(int error) const { throw std::system_error(error, std::generic_category(), path.string()); }
+
+        public:
+            explicit dds_sink_t(std::filesystem::path file_path) : path(std::move(file_path)) {
+#ifndef WIN32
+                fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0) {
+                    fail(errno);
+                }
+#else
+                handle = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (handle == INVALID_HANDLE_VALUE) {
+                    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+                }
+#endif
+            }
+
+            dds_sink_t(const dds_sink_t &) = delete;
+            dds_sink_t &operator=(const dds_sink_t &) = delete;
+
+            ~dds_sink_t() {
+#ifndef WIN32
+                close(fd);
+#else
+                CloseHandle(handle);
+#endif
+            }
+
+            // reserves `size` bytes for the file. this is only a hint, filesystems that can't do it are left alone.
+            void preallocate([[maybe_unused]] uint64_t size) const {
+#if defined(__linux__)
+                while (fallocate(fd, 0, 0, static_cast<off_t>(size)) != 0 && errno == EINTR) { }
+#elif defined(WIN32)
+                FILE_ALLOCATION_INFO info = {};
+                info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+                SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info));
+#endif
+            }
+
+            // writes every chunk back to back starting at `offset`, partial writes are resumed where they stopped.
+            void write(std::vector<dds_chunk_t> &chunks, uint64_t offset) const {
+#ifndef WIN32
+                static const auto iov_max = static_cast<size_t>(std::max<long>(sysconf(_SC_IOV_MAX), 16));
+
+                std::vector<iovec> vectors;
+                vectors.reserve(chunks.size());
+                for (auto &chunk : chunks) {
+                    if (chunk.size > 0) {
+                        vectors.push_back({const_cast<uint8_t *>(chunk.data), chunk.size});
+                    }
+                }
+
+                size_t first = 0;
+                while (first < vectors.size()) {
+                    auto count   = static_cast<int>(std::min(vectors.size() - first, iov_max));
+                    auto written = ::pwritev(fd, vectors.data() + first, count, static_cast<off_t>(offset));
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (written < 0) {
+                        fail(errno);
+                    }
+
+                    offset += static_cast<uint64_t>(written);
+                    auto left = static_cast<size_t>(written);
+                    while (left > 0 && left >= vectors[first].iov_len) {
+                        left -= vectors[first++].iov_len;
+                    }
+                    if (left > 0) {
+                        vectors[first].iov_base = static_cast<uint8_t *>(vectors[first].iov_base) + left;
+                        vectors[first].iov_len -= left;
+                    }
+                }
+#else
+                // windows only gathers page aligned, unbuffered writes, so the chunks go out one by one.
+                for (auto &chunk : chunks) {
+                    size_t total = 0;
+                    while (total < chunk.size) {
+                        OVERLAPPED position = {};
+                        position.Offset     = static_cast<DWORD>(offset);
+                        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+                        DWORD written       = 0;
+                        auto count          = static_cast<DWORD>(std::min<size_t>(chunk.size - total, 1u << 30));
+                        if (!WriteFile(handle, chunk.data + total, count, &written, &position)) {
+                            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+                        }
+                        total += written;
+                        offset += written;
+                    }
+                }
+#endif
+            }
+        };
+
+        // the header as it is stored: 128 bytes, or 148 with the DX10 extension, little endian.
+        inline std::pair<dds10_t, size_t> dds_file_header(const dds10_t &header) {
+            auto stored = header;
+            auto dx10   = (header.dx9.pixel_format.flags & 0x4) != 0 && header.dx9.pixel_format.fourCC == 0x30315844;
+            if constexpr (std::endian::native == std::endian::big) {
+                uint32_t words[sizeof(dds10_t) / 4];
+                std::memcpy(words, &stored, sizeof(stored));
+                for (auto &word : words) {
+                    word = std::byteswap(word);
+                }
+                std::memcpy(&stored, words, sizeof(stored));
+            }
+            return {stored, dx10 ? sizeof(dds10_t) : sizeof(dds_t)};
+        }
+
+        inline void write_dds_buffers(const std::filesystem::path &path, const dds10_t &header, const std::vector<astra::mem::runtime_array<uint8_t>> &subresources, const dds_write_options_t &options) {
+            dds_layout layout(header);
+            if (subresources.size() != layout.subresource_count()) {
+                throw std::invalid_argument("expected one buffer per dds subresource");
+            }
+
+            for (size_t i = 0; i < subresources.size(); ++i) {
+                if (subresources[i].byte_size() < layout[i].size) {
+                    throw std::out_of_range("buffer is smaller than its dds subresource");
+                }
+            }
+
+            auto [stored, header_size] = dds_file_header(header);
+            std::vector<dds_chunk_t> chunks;
+            chunks.reserve(subresources.size() + 1);
+            chunks.push_back({reinterpret_cast<const uint8_t *>(&stored), header_size});
+            for (size_t i = 0; i < subresources.size(); ++i) {
+                chunks.push_back({subresources[i].data(), static_cast<size_t>(layout[i].size)});
+            }
+
+            dds_sink_t sink(path);
+            if (options.preallocate) {
+                sink.preallocate(header_size + layout.payload_size);
+            }
+            sink.write(chunks, 0);
+        }
+
+        inline void write_dds_produced(const std::filesystem::path &path, const dds10_t &header, const dds_producer &producer, const dds_write_options_t &options) {
+            dds_layout layout(header);
+            auto [stored, header_size] = dds_file_header(header);
+
+            dds_sink_t sink(path);
+            if (options.preallocate) {
+                sink.preallocate(header_size + layout.payload_size);
+            }
+
+            // a batch is a run of consecutive subresources that fits batch_bytes, or a single larger one.
+            size_t capacity = options.batch_bytes;
+            for (auto &entry : layout) {
+                capacity = std::max(capacity, static_cast<size_t>(entry.size));
+            }
+            capacity = std::min<size_t>(capacity, std::max<uint64_t>(layout.payload_size, 1));
+
+            std::unique_ptr<uint8_t[]> staging[2] = {std::make_unique_for_overwrite<uint8_t[]>(capacity), std::make_unique_for_overwrite<uint8_t[]>(capacity)};
+            std::vector<dds_chunk_t> chunks[2];
+            std::future<void> pending;
+
+            uint64_t offset = 0;
+            size_t next     = 0;
+            for (size_t batch = 0; next < layout.subresource_count() || batch == 0; ++batch) {
+                auto buffer = staging[batch & 1].get();
+                auto &list  = chunks[batch & 1];
+                list.clear();
+                if (batch == 0) {
+                    list.push_back({reinterpret_cast<const uint8_t *>(&stored), header_size});
+                }
+
+                size_t used = 0;
+                while (next < layout.subresource_count() && (used == 0 || used + layout[next].size <= capacity)) {
+                    producer(layout[next], buffer + used);
+                    used += static_cast<size_t>(layout[next++].size);
+                }
+                list.push_back({buffer, used});
+
+                // the batch before this one was written from the other buffer, it has to land before that buffer is reused.
+                if (pending.valid()) {
+                    pending.get();
+                }
+
+                size_t bytes = 0;
+                for (auto &chunk : list) {
+                    bytes += chunk.size;
+                }
+                pending = std::async(std::launch::async, [&sink, &list, offset] { sink.write(list, offset); });
+                offset += bytes;
+            }
+
+            if (pending.valid()) {
+                pending.get();
+            }
+        }
+    } // namespace detail
+
+    // writes a dds file from one buffer per subresource, in dds_layout(header) order. buffers longer than their
+    // subresource are cut to size.
+    [[maybe_unused]] inline void write_dds(const std::filesystem::path &path, const dds10_t &header, const std::vector<astra::mem::runtime_array<uint8_t>> &subresources, const dds_write_options_t &options = {}) { detail::write_dds_buffers(path, header, subresources, options); }
+
+    // writes a dds file whose subresources are filled in by `producer`, at most two staging batches are in memory.
+    [[maybe_unused]] inline void write_dds(const std::filesystem::path &path, const dds10_t &header, const dds_producer &producer, const dds_write_options_t &options = {}) { detail::write_dds_produced(path, header, producer, options); }
+
+    // writes many dds files at once on up to `workers` threads.
+    [[maybe_unused]] inline void write_dds_files(const std::vector<dds_write_job_t> &jobs, const dds_write_options_t &options = {}, size_t workers = 0) {
+        parallel::for_each(
+            jobs.size(),
+            [&](size_t i) {
+                auto &job = jobs[i];
+                if (job.producer) {
+                    detail::write_dds_produced(job.path, job.header, job.producer, options);
+                } else {
+                    detail::write_dds_buffers(job.path, job.header, job.subresources, options);
+                }
+            },
+            workers);
+    }
+} // namespace astra::gdx
@@ -2,12 +2,52 @@
 
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
 
+#ifdef WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "fnv.hpp"
+#include "parallel.hpp"
 #include "runtime_array.hpp"
 
 namespace astra::io {
-    std::shared_ptr<astra::mem::runtime_array<uint8_t>> read_file(const std::filesystem::path &path) {
+    enum class map_mode {
+        read_only,     // pages are shared with the page cache, writing to them is a fault.
+        copy_on_write, // pages are private, writes are never carried back to the file.
+    };
+
+    enum class map_hint {
+        normal,
+        sequential, // aggressive read-ahead, pages behind the cursor can be dropped early.
+        random,     // no read-ahead.
+        will_need,  // start paging in the range now.
+    };
+
+    inline void align(uintptr_t &value, uintptr_t align) {
+        auto v = value % align;
+        if (v != 0) {
+            value += align - v;
+        }
+    }
+
+    inline std::shared_ptr<astra::mem::runtime_array<uint8_t>> read_file(const std::filesystem::path &path) {
         std::ifstream file(path, std::ios::binary | std::ios::in);
         auto size = static_cast<size_t>(std::filesystem::file_size(path));
         auto bytes = std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, size);
@@ -17,17 +57,271 @@ namespace astra::io {
         return bytes;
     }
 
-    void write_file(const std::filesystem::path &path, std::shared_ptr<astra::mem::runtime_array<uint8_t>> &buffer) {
+    inline void write_file(const std::filesystem::path &path, std::shared_ptr<astra::mem::runtime_array<uint8_t>> &buffer) {
         std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
         file.write(reinterpret_cast<const char *>(buffer->data()), static_cast<std::streamsize>(buffer->size()));
         file.flush();
         file.close();
     }
 
-    inline void align(uintptr_t &value, uintptr_t align) {
-        auto v = value % align;
-        if (v != 0) {
-            value += align - v;
+    // applies an access hint to the pages backing a range of a mapped array, this is a no-op for heap buffers on most systems.
+    inline void advise(const astra::mem::runtime_array<uint8_t> &buffer, map_hint hint) {
+#ifndef WIN32
+        if (buffer.empty()) {
+            return;
+        }
+
+        auto page  = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto start = reinterpret_cast<uintptr_t>(buffer.data());
+        auto base  = start - start % page;
+
+        int advice = MADV_NORMAL;
+        switch (hint) {
+            case map_hint::normal: advice = MADV_NORMAL; break;
+            case map_hint::sequential: advice = MADV_SEQUENTIAL; break;
+            case map_hint::random: advice = MADV_RANDOM; break;
+            case map_hint::will_need: advice = MADV_WILLNEED; break;
+        }
+
+        madvise(reinterpret_cast<void *>(base), start - base + buffer.byte_size(), advice);
+#else
+        if (hint == map_hint::will_need && !buffer.empty()) {
+            WIN32_MEMORY_RANGE_ENTRY range = {buffer.data(), buffer.byte_size()};
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+#endif
+    }
+
+    // maps a file into memory instead of reading it, pages are only faulted in once they are touched.
+    // the mapping is released when the last array (or view of it) is destroyed.
+    inline std::shared_ptr<astra::mem::runtime_array<uint8_t>> map_file(const std::filesystem::path &path, map_mode mode = map_mode::read_only, map_hint hint = map_hint::normal) {
+#ifndef WIN32
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), path.string());
+        }
+
+        struct stat info = {};
+        if (fstat(fd, &info) != 0) {
+            auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path.string());
+        }
+
+        auto size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            close(fd);
+            return std::make_shared<astra::mem::runtime_array<uint8_t>>();
+        }
+
+        auto protection = mode == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        auto address    = mmap(nullptr, size, protection, MAP_PRIVATE, fd, 0);
+        auto error      = errno;
+        close(fd); // the mapping holds its own reference to the file.
+        if (address == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), path.string());
+        }
+
+        auto storage = std::shared_ptr<uint8_t[]>(static_cast<uint8_t *>(address), [size](uint8_t *p) { munmap(p, size); });
+#else
+        auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, hint == map_hint::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
         }
+
+        LARGE_INTEGER file_size = {};
+        GetFileSizeEx(file, &file_size);
+        auto size = static_cast<size_t>(file_size.QuadPart);
+        if (size == 0) {
+            CloseHandle(file);
+            return std::make_shared<astra::mem::runtime_array<uint8_t>>();
+        }
+
+        auto mapping = CreateFileMappingW(file, nullptr, mode == map_mode::read_only ? PAGE_READONLY : PAGE_WRITECOPY, 0, 0, nullptr);
+        auto error   = GetLastError();
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            throw std::system_error(static_cast<int>(error), std::system_category(), path.string());
+        }
+
+        auto address = MapViewOfFile(mapping, mode == map_mode::read_only ? FILE_MAP_READ : FILE_MAP_COPY, 0, 0, 0);
+        error        = GetLastError();
+        CloseHandle(mapping); // the view holds its own reference to the mapping.
+        if (address == nullptr) {
+            throw std::system_error(static_cast<int>(error), std::system_category(), path.string());
+        }
+
+        auto storage = std::shared_ptr<uint8_t[]>(static_cast<uint8_t *>(address), [](uint8_t *p) { UnmapViewOfFile(p); });
+#endif
+
+        auto bytes = std::make_shared<astra::mem::runtime_array<uint8_t>>(std::move(storage), 0, size);
+        if (hint != map_hint::normal) {
+            advise(*bytes, hint);
+        }
+
+        return bytes;
+    }
+
+    namespace detail {
+        // reads up to `size` bytes from the start of a file, returns how many were actually read.
+        inline size_t read_into(const std::filesystem::path &path, uint8_t *buffer, size_t size) {
+#ifndef WIN32
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path.string());
+            }
+
+            size_t total = 0;
+            while (total < size) {
+                auto count = ::read(fd, buffer + total, size - total);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (count <= 0) {
+                    break;
+                }
+
+                total += static_cast<size_t>(count);
+            }
+
+            close(fd);
+            return total;
+#else
+            std::ifstream file(path, std::ios::binary | std::ios::in);
+            file.read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(size));
+            return static_cast<size_t>(file.gcount());
+#endif
+        }
+
+        inline void write_from(const std::filesystem::path &path, const uint8_t *buffer, size_t size) {
+#ifndef WIN32
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path.string());
+            }
+
+            size_t total = 0;
+            while (total < size) {
+                auto count = ::write(fd, buffer + total, size - total);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (count < 0) {
+                    auto error = errno;
+                    close(fd);
+                    throw std::system_error(error, std::generic_category(), path.string());
+                }
+
+                total += static_cast<size_t>(count);
+            }
+
+            close(fd);
+#else
+            std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(buffer), static_cast<std::streamsize>(size));
+#endif
+        }
+    } // namespace detail
+
+    // hashes a file in `chunk_size` pieces, so only one chunk is ever resident. Hasher is one of the astra::hash fnv hashers.
+    template<typename Hasher = astra::hash::fnva64_hasher>
+    auto hash_file(const std::filesystem::path &path, size_t chunk_size = 1 << 20) {
+        Hasher hasher;
+        auto size   = static_cast<size_t>(std::filesystem::file_size(path));
+        auto chunk  = std::max<size_t>(std::min(chunk_size, size), 1);
+        auto buffer = std::make_unique_for_overwrite<uint8_t[]>(chunk);
+#ifndef WIN32
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), path.string());
+        }
+
+#    ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#    endif
+
+        while (true) {
+            auto count = ::read(fd, buffer.get(), chunk);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count < 0) {
+                auto error = errno;
+                close(fd);
+                throw std::system_error(error, std::generic_category(), path.string());
+            }
+
+            if (count == 0) {
+                break;
+            }
+
+            hasher.update(buffer.get(), static_cast<size_t>(count));
+        }
+
+        close(fd);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::in);
+        while (file) {
+            file.read(reinterpret_cast<char *>(buffer.get()), static_cast<std::streamsize>(chunk));
+            hasher.update(buffer.get(), static_cast<size_t>(file.gcount()));
+        }
+#endif
+        return hasher.finalize();
+    }
+
+    // fingerprints many files on up to `workers` threads, at most workers * chunk_size bytes are buffered at any time.
+    template<typename Hasher = astra::hash::fnva64_hasher>
+    auto hash_files(const std::vector<std::filesystem::path> &paths, size_t workers = 0, size_t chunk_size = 1 << 20) {
+        std::vector<decltype(Hasher().finalize())> hashes(paths.size());
+        astra::parallel::for_each(paths.size(), [&](size_t i) { hashes[i] = hash_file<Hasher>(paths[i], chunk_size); }, workers);
+        return hashes;
+    }
+
+    using read_callback = std::function<void(size_t index, std::shared_ptr<astra::mem::runtime_array<uint8_t>> &data)>;
+
+    // loads many files at once on up to `workers` threads.
+    // every size is looked up first so all files land in one aligned slab allocation, each result is a view into that slab.
+    // note that any one view keeps the whole slab alive, clone() results that have to outlive the rest.
+    // `callback` is invoked from the worker threads as soon as each file has been read, in completion order.
+    inline void read_files(const std::vector<std::filesystem::path> &paths, const read_callback &callback, size_t workers = 0) {
+        std::vector<size_t> sizes(paths.size());
+        astra::parallel::for_each(paths.size(), [&](size_t i) { sizes[i] = static_cast<size_t>(std::filesystem::file_size(paths[i])); }, workers);
+
+        std::vector<uintptr_t> offsets(paths.size());
+        uintptr_t total = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            offsets[i] = total;
+            total += sizes[i];
+            align(total, ASTRA_ALIGNMENT);
+        }
+
+        auto slab = astra::mem::runtime_array<uint8_t>(nullptr, total);
+        astra::parallel::for_each(
+            paths.size(),
+            [&](size_t i) {
+                auto count = detail::read_into(paths[i], slab.data() + offsets[i], sizes[i]);
+                auto bytes = slab.slice(offsets[i], count);
+                callback(i, bytes);
+            },
+            workers);
+    }
+
+    // loads many files at once, see the callback overload. results are returned in the same order as `paths`.
+    inline std::vector<std::shared_ptr<astra::mem::runtime_array<uint8_t>>> read_files(const std::vector<std::filesystem::path> &paths, size_t workers = 0) {
+        std::vector<std::shared_ptr<astra::mem::runtime_array<uint8_t>>> results(paths.size());
+        read_files(paths, [&results](size_t index, std::shared_ptr<astra::mem::runtime_array<uint8_t>> &data) { results[index] = std::move(data); }, workers);
+        return results;
+    }
+
+    // writes buffers[i] to paths[i] on up to `workers` threads.
+    inline void write_files(const std::vector<std::filesystem::path> &paths, const std::vector<std::shared_ptr<astra::mem::runtime_array<uint8_t>>> &buffers, size_t workers = 0) {
+        if (paths.size() != buffers.size()) {
+            throw std::invalid_argument("write_files: paths and buffers differ in length");
+        }
+
+        astra::parallel::for_each(paths.size(), [&](size_t i) { detail::write_from(paths[i], buffers[i]->data(), buffers[i]->size()); }, workers);
     }
 } // namespace astra::io
@@ -6,8 +6,13 @@
 
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cstdint>
 #include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string_view>
 #include "macros.hpp"
 
 namespace astra::hash {
@@ -43,8 +48,7 @@ namespace astra::hash {
     // there's some math behind the theory on selecting FNV primes, read more on it on either linked pages.
     // the IETF page also has sample C code for 128 and higher bit spaces.
 
-    [[maybe_unused]] ASTRA_INLINE uint32_t fnv32(const uint8_t *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
-        #pragma omp simd
+    [[maybe_unused]] ASTRA_INLINE constexpr uint32_t fnv32(const uint8_t *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
         for (size_t i = 0; i < size; ++i) {
             basis *= prime;
             basis ^= buf[i];
@@ -53,8 +57,7 @@ namespace astra::hash {
         return basis;
     }
 
-    [[maybe_unused]] ASTRA_INLINE uint32_t fnva32(const uint8_t *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
-        #pragma omp simd
+    [[maybe_unused]] ASTRA_INLINE constexpr uint32_t fnva32(const uint8_t *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
         for (size_t i = 0; i < size; ++i) {
             basis ^= buf[i];
             basis *= prime;
@@ -63,8 +66,7 @@ namespace astra::hash {
         return basis;
     }
 
-    [[maybe_unused]] ASTRA_INLINE uint64_t fnv64(const uint8_t *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
-        #pragma omp simd
+    [[maybe_unused]] ASTRA_INLINE constexpr uint64_t fnv64(const uint8_t *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
         for (size_t i = 0; i < size; ++i) {
             basis *= prime;
             basis ^= buf[i];
@@ -73,8 +75,7 @@ namespace astra::hash {
         return basis;
     }
 
-    [[maybe_unused]] ASTRA_INLINE uint64_t fnva64(const uint8_t *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
-        #pragma omp simd
+    [[maybe_unused]] ASTRA_INLINE constexpr uint64_t fnva64(const uint8_t *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
         for (size_t i = 0; i < size; ++i) {
             basis ^= buf[i];
             basis *= prime;
@@ -82,4 +83,147 @@ namespace astra::hash {
 
         return basis;
     }
+
+    // byte-like overloads, these are constexpr so hashes of known names fold to constants.
+
+    namespace detail {
+        template<typename H, bool alternate, typename C>
+        constexpr H fnv(const C *buf, size_t size, H basis, H prime) {
+            for (size_t i = 0; i < size; ++i) {
+                if constexpr (alternate) {
+                    basis ^= static_cast<uint8_t>(buf[i]);
+                    basis *= prime;
+                } else {
+                    basis *= prime;
+                    basis ^= static_cast<uint8_t>(buf[i]);
+                }
+            }
+
+            return basis;
+        }
+    } // namespace detail
+
+    [[maybe_unused]] constexpr uint32_t fnv32(const char *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, false>(buf, size, basis, prime); }
+    [[maybe_unused]] constexpr uint32_t fnv32(std::string_view text, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, false>(text.data(), text.size(), basis, prime); }
+    [[maybe_unused]] constexpr uint32_t fnv32(std::span<const std::byte> bytes, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, false>(bytes.data(), bytes.size(), basis, prime); }
+
+    [[maybe_unused]] constexpr uint32_t fnva32(const char *buf, size_t size, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, true>(buf, size, basis, prime); }
+    [[maybe_unused]] constexpr uint32_t fnva32(std::string_view text, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, true>(text.data(), text.size(), basis, prime); }
+    [[maybe_unused]] constexpr uint32_t fnva32(std::span<const std::byte> bytes, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) { return detail::fnv<uint32_t, true>(bytes.data(), bytes.size(), basis, prime); }
+
+    [[maybe_unused]] constexpr uint64_t fnv64(const char *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, false>(buf, size, basis, prime); }
+    [[maybe_unused]] constexpr uint64_t fnv64(std::string_view text, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, false>(text.data(), text.size(), basis, prime); }
+    [[maybe_unused]] constexpr uint64_t fnv64(std::span<const std::byte> bytes, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, false>(bytes.data(), bytes.size(), basis, prime); }
+
+    [[maybe_unused]] constexpr uint64_t fnva64(const char *buf, size_t size, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, true>(buf, size, basis, prime); }
+    [[maybe_unused]] constexpr uint64_t fnva64(std::string_view text, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, true>(text.data(), text.size(), basis, prime); }
+    [[maybe_unused]] constexpr uint64_t fnva64(std::span<const std::byte> bytes, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) { return detail::fnv<uint64_t, true>(bytes.data(), bytes.size(), basis, prime); }
+
+    // incremental hashing, feeding bytes in any number of pieces gives the same result as hashing them in one go.
+    // useful for chunked reads or walking the pages of a mapped file without keeping it all resident.
+    template<typename H, bool alternate>
+    class basic_fnv_hasher {
+    private:
+        H state;
+        H basis;
+        H prime;
+
+    public:
+        static constexpr H default_basis = sizeof(H) == 4 ? static_cast<H>(FNV1_BASIS_32) : static_cast<H>(FNV1_BASIS_64);
+        static constexpr H default_prime = sizeof(H) == 4 ? static_cast<H>(FNV_PRIME_32) : static_cast<H>(FNV_PRIME_64);
+
+        constexpr explicit basic_fnv_hasher(H basis = default_basis, H prime = default_prime) : state(basis), basis(basis), prime(prime) { }
+
+        constexpr basic_fnv_hasher &update(const uint8_t *buf, size_t size) {
+            state = detail::fnv<H, alternate>(buf, size, state, prime);
+            return *this;
+        }
+
+        constexpr basic_fnv_hasher &update(std::span<const uint8_t> bytes) { return update(bytes.data(), bytes.size()); }
+
+        constexpr basic_fnv_hasher &update(std::span<const std::byte> bytes) {
+            state = detail::fnv<H, alternate>(bytes.data(), bytes.size(), state, prime);
+            return *this;
+        }
+
+        constexpr basic_fnv_hasher &update(std::string_view text) {
+            state = detail::fnv<H, alternate>(text.data(), text.size(), state, prime);
+            return *this;
+        }
+
+        [[nodiscard]] constexpr H finalize() const { return state; }
+
+        constexpr void reset() { state = basis; }
+    };
+
+    using fnv32_hasher  = basic_fnv_hasher<uint32_t, false>;
+    using fnva32_hasher = basic_fnv_hasher<uint32_t, true>;
+    using fnv64_hasher  = basic_fnv_hasher<uint64_t, false>;
+    using fnva64_hasher = basic_fnv_hasher<uint64_t, true>;
+
+    // "texture"_fnva64 is a compile time constant, use with `using namespace astra::hash::literals;`
+    namespace literals {
+        [[maybe_unused]] consteval uint32_t operator""_fnv32(const char *text, size_t size) { return detail::fnv<uint32_t, false>(text, size, FNV1_BASIS_32, FNV_PRIME_32); }
+        [[maybe_unused]] consteval uint32_t operator""_fnva32(const char *text, size_t size) { return detail::fnv<uint32_t, true>(text, size, FNV1_BASIS_32, FNV_PRIME_32); }
+        [[maybe_unused]] consteval uint64_t operator""_fnv64(const char *text, size_t size) { return detail::fnv<uint64_t, false>(text, size, FNV1_BASIS_64, FNV_PRIME_64); }
+        [[maybe_unused]] consteval uint64_t operator""_fnva64(const char *text, size_t size) { return detail::fnv<uint64_t, true>(text, size, FNV1_BASIS_64, FNV_PRIME_64); }
+    } // namespace literals
+
+    // maps a fixed set of hashes to their position in the list with one multiply, one shift and one compare.
+    // the multiplier is searched for at compile time, so a lookup never probes and a duplicate hash is a compile error.
+    // find() returns N for unknown hashes, and being constexpr it can be used for case labels:
+    //   constexpr perfect_hash_table tags({"texture"_fnva64, "mesh"_fnva64});
+    //   switch (tags.find(hash)) { case tags.find("texture"_fnva64): ...; case tags.find("mesh"_fnva64): ...; }
+    template<typename H, size_t N>
+    class perfect_hash_table {
+    private:
+        static constexpr size_t capacity = std::bit_ceil(N * 4);
+        static constexpr size_t shift    = sizeof(uint64_t) * 8 - std::countr_zero(capacity);
+
+        std::array<H, capacity> keys         = {};
+        std::array<uint32_t, capacity> index = {};
+        uint64_t multiplier                  = 0;
+
+        [[nodiscard]] constexpr size_t slot(H hash) const { return capacity == 1 ? 0 : static_cast<size_t>((static_cast<uint64_t>(hash) * multiplier) >> shift); }
+
+    public:
+        consteval explicit perfect_hash_table(const H (&hashes)[N]) {
+            uint64_t state = 0x9E3779B97F4A7C15;
+            for (size_t attempt = 0; attempt < 100000; ++attempt) {
+                // splitmix64, any odd multiplier works as long as it separates the keys.
+                state += 0x9E3779B97F4A7C15;
+                auto z     = state;
+                z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+                z          = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+                multiplier = (z ^ (z >> 31)) | 1;
+
+                index.fill(static_cast<uint32_t>(N));
+                auto placed = true;
+                for (size_t i = 0; i < N && placed; ++i) {
+                    auto position = slot(hashes[i]);
+                    if (index[position] != N) {
+                        placed = false;
+                    } else {
+                        keys[position]  = hashes[i];
+                        index[position] = static_cast<uint32_t>(i);
+                    }
+                }
+
+                if (placed) {
+                    return;
+                }
+            }
+
+            throw std::logic_error("perfect_hash_table: duplicate hashes");
+        }
+
+        [[nodiscard]] static constexpr size_t size() { return N; }
+
+        [[nodiscard]] constexpr size_t find(H hash) const {
+            auto position = slot(hash);
+            return keys[position] == hash ? index[position] : N;
+        }
+
+        [[nodiscard]] constexpr bool contains(H hash) const { return find(hash) != N; }
+    };
 } // namespace astra::hash
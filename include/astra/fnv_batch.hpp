@@ -0,0 +1,343 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cpu_features.hpp"
+#include "fnv.hpp"
+#include "macros.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// batch hashing runs one buffer per simd lane, the fnv loop itself can't be vectorized since every byte depends on the previous one.
+// results are identical to calling the scalar function on every buffer.
+
+namespace astra::hash {
+    namespace detail {
+        template<typename H, bool alternate>
+        ASTRA_INLINE H fnv_scalar(const uint8_t *buf, size_t size, H basis, H prime) {
+            if constexpr (sizeof(H) == 4) {
+                return alternate ? fnva32(buf, size, basis, prime) : fnv32(buf, size, basis, prime);
+            } else {
+                return alternate ? fnva64(buf, size, basis, prime) : fnv64(buf, size, basis, prime);
+            }
+        }
+
+        template<typename H, bool alternate>
+        void fnv_batch_scalar(const uint8_t *const *buffers, const size_t *sizes, H *hashes, size_t count, H basis, H prime) {
+            for (size_t i = 0; i < count; ++i) {
+                hashes[i] = fnv_scalar<H, alternate>(buffers[i], sizes[i], basis, prime);
+            }
+        }
+
+#ifdef ASTRA_X86
+        ASTRA_TARGET("avx2") inline __m256i mullo64_avx2(__m256i a, __m256i b) {
+            auto lo    = _mm256_mul_epu32(a, b);
+            auto cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+            return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+        }
+
+        // keeps every simd lane busy, a lane that finishes its buffer stores the hash and immediately picks up the next buffer.
+        // this avoids idling lanes when buffer lengths are ragged. lanes are always 64 bits wide (they hold a pointer each),
+        // 32-bit hashes live in the low half and the upper half stays zero since the prime is zero extended.
+        template<typename H, size_t group>
+        struct lane_feed {
+            const uint8_t *const *buffers;
+            const size_t *sizes;
+            H *hashes;
+            size_t count;
+            H basis;
+
+            size_t next = 0;
+            size_t live = 0;
+            size_t slot[group] = {};
+
+            alignas(64) uint64_t cursor[group] = {};
+            alignas(64) uint64_t left[group]   = {};
+            alignas(64) uint64_t words[group]  = {};
+            alignas(64) uint64_t state[group]  = {};
+
+            lane_feed(const uint8_t *const *buffers, const size_t *sizes, H *hashes, size_t count, H basis) : buffers(buffers), sizes(sizes), hashes(hashes), count(count), basis(basis) {
+                for (size_t lane = 0; lane < group; ++lane) {
+                    state[lane] = basis;
+                    assign(lane);
+                }
+            }
+
+            void assign(size_t lane) {
+                while (next < count && sizes[next] == 0) {
+                    hashes[next++] = basis;
+                }
+
+                if (next < count) {
+                    cursor[lane] = reinterpret_cast<uintptr_t>(buffers[next]);
+                    left[lane]   = sizes[next];
+                    slot[lane]   = next++;
+                    live++;
+                }
+            }
+
+            // builds the final partial word of lanes with fewer than 8 bytes left, the gather skips them so it never reads past a buffer.
+            void patch(uint32_t lanes) {
+                for (; lanes != 0; lanes &= lanes - 1) {
+                    auto lane   = static_cast<size_t>(std::countr_zero(lanes));
+                    auto source = reinterpret_cast<const uint8_t *>(cursor[lane]);
+                    words[lane] = 0;
+                    for (size_t k = 0; k < left[lane]; ++k) {
+                        words[lane] |= static_cast<uint64_t>(source[k]) << (k * 8);
+                    }
+                }
+            }
+
+            // stores the hashes of lanes that just consumed their last byte and hands them new buffers.
+            void retire(uint32_t lanes) {
+                for (; lanes != 0; lanes &= lanes - 1) {
+                    auto lane          = static_cast<size_t>(std::countr_zero(lanes));
+                    hashes[slot[lane]] = static_cast<H>(state[lane]);
+                    state[lane]        = basis;
+                    live--;
+                    assign(lane);
+                }
+            }
+        };
+
+        template<typename H, bool alternate>
+        ASTRA_TARGET("avx2") inline __m256i fnv_round_avx2(__m256i hash, __m256i byte, __m256i prime) {
+            if constexpr (sizeof(H) == 4) {
+                return alternate ? _mm256_mullo_epi32(_mm256_xor_si256(hash, byte), prime) : _mm256_xor_si256(_mm256_mullo_epi32(hash, prime), byte);
+            } else {
+                return alternate ? mullo64_avx2(_mm256_xor_si256(hash, byte), prime) : _mm256_xor_si256(mullo64_avx2(hash, prime), byte);
+            }
+        }
+
+        ASTRA_TARGET("avx2") inline __m256i lanes_load(const uint64_t *source, size_t v) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(source + v * 4)); }
+
+        ASTRA_TARGET("avx2") inline void lanes_store(uint64_t *target, size_t v, __m256i value) { _mm256_store_si256(reinterpret_cast<__m256i *>(target + v * 4), value); }
+
+        ASTRA_TARGET("avx2") inline uint32_t lanes_mask(__m256i mask, size_t v) { return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(mask))) << (v * 4); }
+
+        // every lane eats 8 bytes per step, several vectors are in flight so the multiply latency of one hides behind the others.
+        template<typename H, bool alternate>
+        ASTRA_TARGET("avx2") void fnv_batch_avx2(const uint8_t *const *buffers, const size_t *sizes, H *hashes, size_t count, H basis, H prime) {
+            constexpr size_t lanes   = 4;
+            constexpr size_t vectors = 4;
+            constexpr size_t group   = lanes * vectors;
+
+            if (count < group) {
+                return fnv_batch_scalar<H, alternate>(buffers, sizes, hashes, count, basis, prime);
+            }
+
+            const auto vprime = _mm256_set1_epi64x(static_cast<long long>(prime));
+            const auto vbyte  = _mm256_set1_epi64x(0xFF);
+            const auto zero   = _mm256_setzero_si256();
+            const auto seven  = _mm256_set1_epi64x(7);
+            const auto eight  = _mm256_set1_epi64x(8);
+
+            lane_feed<H, group> feed(buffers, sizes, hashes, count, basis);
+
+            __m256i hash[vectors], cursor[vectors], left[vectors];
+            for (size_t v = 0; v < vectors; ++v) {
+                hash[v]   = lanes_load(feed.state, v);
+                cursor[v] = lanes_load(feed.cursor, v);
+                left[v]   = lanes_load(feed.left, v);
+            }
+
+            while (feed.live > 0) {
+                __m256i word[vectors], step[vectors];
+                uint32_t partial = 0;
+                uint32_t ragged  = 0;
+                for (size_t v = 0; v < vectors; ++v) {
+                    auto full = _mm256_cmpgt_epi64(left[v], seven);
+                    word[v]   = _mm256_mask_i64gather_epi64(zero, static_cast<const long long *>(nullptr), cursor[v], full, 1);
+                    step[v]   = _mm256_blendv_epi8(left[v], eight, full);
+                    partial |= lanes_mask(_mm256_andnot_si256(full, _mm256_cmpgt_epi64(left[v], zero)), v);
+                    ragged |= lanes_mask(_mm256_cmpgt_epi64(eight, step[v]), v);
+                }
+
+                if (partial != 0) {
+                    for (size_t v = 0; v < vectors; ++v) {
+                        lanes_store(feed.words, v, word[v]);
+                        lanes_store(feed.cursor, v, cursor[v]);
+                        lanes_store(feed.left, v, left[v]);
+                    }
+                    feed.patch(partial);
+                    for (size_t v = 0; v < vectors; ++v) {
+                        word[v] = lanes_load(feed.words, v);
+                    }
+                }
+
+                for (size_t k = 0; k < 8; ++k) {
+                    auto position = _mm256_set1_epi64x(static_cast<long long>(k));
+                    for (size_t v = 0; v < vectors; ++v) {
+                        auto next = fnv_round_avx2<H, alternate>(hash[v], _mm256_and_si256(word[v], vbyte), vprime);
+                        hash[v]   = ragged == 0 ? next : _mm256_blendv_epi8(hash[v], next, _mm256_cmpgt_epi64(step[v], position));
+                        word[v]   = _mm256_srli_epi64(word[v], 8);
+                    }
+                }
+
+                uint32_t finished = 0;
+                for (size_t v = 0; v < vectors; ++v) {
+                    cursor[v] = _mm256_add_epi64(cursor[v], step[v]);
+                    left[v]   = _mm256_sub_epi64(left[v], step[v]);
+                    finished |= lanes_mask(_mm256_andnot_si256(_mm256_cmpeq_epi64(step[v], zero), _mm256_cmpeq_epi64(left[v], zero)), v);
+                }
+
+                if (finished != 0) {
+                    for (size_t v = 0; v < vectors; ++v) {
+                        lanes_store(feed.state, v, hash[v]);
+                        lanes_store(feed.cursor, v, cursor[v]);
+                        lanes_store(feed.left, v, left[v]);
+                    }
+                    feed.retire(finished);
+                    for (size_t v = 0; v < vectors; ++v) {
+                        hash[v]   = lanes_load(feed.state, v);
+                        cursor[v] = lanes_load(feed.cursor, v);
+                        left[v]   = lanes_load(feed.left, v);
+                    }
+                }
+            }
+        }
+
+        template<typename H, bool alternate>
+        ASTRA_TARGET("avx512f,avx512dq") inline __m512i fnv_round_avx512(__m512i hash, __m512i byte, __m512i prime) {
+            if constexpr (sizeof(H) == 4) {
+                return alternate ? _mm512_mullo_epi32(_mm512_xor_si512(hash, byte), prime) : _mm512_xor_si512(_mm512_mullo_epi32(hash, prime), byte);
+            } else {
+                return alternate ? _mm512_mullo_epi64(_mm512_xor_si512(hash, byte), prime) : _mm512_xor_si512(_mm512_mullo_epi64(hash, prime), byte);
+            }
+        }
+
+        template<typename H, bool alternate>
+        ASTRA_TARGET("avx512f,avx512dq") void fnv_batch_avx512(const uint8_t *const *buffers, const size_t *sizes, H *hashes, size_t count, H basis, H prime) {
+            constexpr size_t lanes   = 8;
+            constexpr size_t vectors = 4;
+            constexpr size_t group   = lanes * vectors;
+
+            if (count < group) {
+                return fnv_batch_scalar<H, alternate>(buffers, sizes, hashes, count, basis, prime);
+            }
+
+            const auto vprime = _mm512_set1_epi64(static_cast<long long>(prime));
+            const auto vbyte  = _mm512_set1_epi64(0xFF);
+            const auto zero   = _mm512_setzero_si512();
+            const auto eight  = _mm512_set1_epi64(8);
+            // gcc 12 implements the unmasked min and shift with an _mm512_undefined source and warns about it
+            // (-Wmaybe-uninitialized), the zero-masked forms with every lane enabled are the same instructions.
+            const __mmask8 all = 0xFF;
+
+            lane_feed<H, group> feed(buffers, sizes, hashes, count, basis);
+
+            __m512i hash[vectors], cursor[vectors], left[vectors];
+            for (size_t v = 0; v < vectors; ++v) {
+                hash[v]   = _mm512_load_si512(feed.state + v * lanes);
+                cursor[v] = _mm512_load_si512(feed.cursor + v * lanes);
+                left[v]   = _mm512_load_si512(feed.left + v * lanes);
+            }
+
+            while (feed.live > 0) {
+                __m512i word[vectors], step[vectors];
+                uint32_t partial = 0;
+                uint32_t ragged  = 0;
+                for (size_t v = 0; v < vectors; ++v) {
+                    auto full = _mm512_cmpge_epu64_mask(left[v], eight);
+                    word[v]   = _mm512_mask_i64gather_epi64(zero, full, cursor[v], nullptr, 1);
+                    step[v]   = _mm512_maskz_min_epu64(all, left[v], eight);
+                    partial |= static_cast<uint32_t>(_mm512_cmpgt_epu64_mask(left[v], zero) & ~full) << (v * lanes);
+                    ragged |= static_cast<uint32_t>(_mm512_cmplt_epu64_mask(step[v], eight)) << (v * lanes);
+                }
+
+                if (partial != 0) {
+                    for (size_t v = 0; v < vectors; ++v) {
+                        _mm512_store_si512(feed.words + v * lanes, word[v]);
+                        _mm512_store_si512(feed.cursor + v * lanes, cursor[v]);
+                        _mm512_store_si512(feed.left + v * lanes, left[v]);
+                    }
+                    feed.patch(partial);
+                    for (size_t v = 0; v < vectors; ++v) {
+                        word[v] = _mm512_load_si512(feed.words + v * lanes);
+                    }
+                }
+
+                for (size_t k = 0; k < 8; ++k) {
+                    auto position = _mm512_set1_epi64(static_cast<long long>(k));
+                    for (size_t v = 0; v < vectors; ++v) {
+                        auto next = fnv_round_avx512<H, alternate>(hash[v], _mm512_and_si512(word[v], vbyte), vprime);
+                        hash[v]   = ragged == 0 ? next : _mm512_mask_mov_epi64(hash[v], _mm512_cmpgt_epu64_mask(step[v], position), next);
+                        word[v]   = _mm512_maskz_srli_epi64(all, word[v], 8);
+                    }
+                }
+
+                uint32_t finished = 0;
+                for (size_t v = 0; v < vectors; ++v) {
+                    cursor[v] = _mm512_add_epi64(cursor[v], step[v]);
+                    left[v]   = _mm512_sub_epi64(left[v], step[v]);
+                    finished |= static_cast<uint32_t>(_mm512_cmpneq_epu64_mask(step[v], zero) & _mm512_cmpeq_epu64_mask(left[v], zero)) << (v * lanes);
+                }
+
+                if (finished != 0) {
+                    for (size_t v = 0; v < vectors; ++v) {
+                        _mm512_store_si512(feed.state + v * lanes, hash[v]);
+                        _mm512_store_si512(feed.cursor + v * lanes, cursor[v]);
+                        _mm512_store_si512(feed.left + v * lanes, left[v]);
+                    }
+                    feed.retire(finished);
+                    for (size_t v = 0; v < vectors; ++v) {
+                        hash[v]   = _mm512_load_si512(feed.state + v * lanes);
+                        cursor[v] = _mm512_load_si512(feed.cursor + v * lanes);
+                        left[v]   = _mm512_load_si512(feed.left + v * lanes);
+                    }
+                }
+            }
+        }
+#endif
+
+        template<typename H, bool alternate>
+        using fnv_batch_fn = void (*)(const uint8_t *const *, const size_t *, H *, size_t, H, H);
+
+        template<typename H, bool alternate>
+        fnv_batch_fn<H, alternate> select_fnv_batch() {
+#ifdef ASTRA_X86
+            auto &features = astra::cpu::current();
+            if (features.avx512) {
+                return fnv_batch_avx512<H, alternate>;
+            }
+
+            if (features.avx2) {
+                return fnv_batch_avx2<H, alternate>;
+            }
+#endif
+            return fnv_batch_scalar<H, alternate>;
+        }
+
+        template<typename H, bool alternate>
+        void fnv_batch(const uint8_t *const *buffers, const size_t *sizes, H *hashes, size_t count, H basis, H prime) {
+            static const auto kernel = select_fnv_batch<H, alternate>();
+            kernel(buffers, sizes, hashes, count, basis, prime);
+        }
+    } // namespace detail
+
+    // hashes[i] = fnv32(buffers[i], sizes[i]) for every i in [0, count).
+    [[maybe_unused]] inline void fnv32_batch(const uint8_t *const *buffers, const size_t *sizes, uint32_t *hashes, size_t count, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
+        detail::fnv_batch<uint32_t, false>(buffers, sizes, hashes, count, basis, prime);
+    }
+
+    // hashes[i] = fnva32(buffers[i], sizes[i]) for every i in [0, count).
+    [[maybe_unused]] inline void fnva32_batch(const uint8_t *const *buffers, const size_t *sizes, uint32_t *hashes, size_t count, uint32_t basis = FNV1_BASIS_32, uint32_t prime = FNV_PRIME_32) {
+        detail::fnv_batch<uint32_t, true>(buffers, sizes, hashes, count, basis, prime);
+    }
+
+    // hashes[i] = fnv64(buffers[i], sizes[i]) for every i in [0, count).
+    [[maybe_unused]] inline void fnv64_batch(const uint8_t *const *buffers, const size_t *sizes, uint64_t *hashes, size_t count, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
+        detail::fnv_batch<uint64_t, false>(buffers, sizes, hashes, count, basis, prime);
+    }
+
+    // hashes[i] = fnva64(buffers[i], sizes[i]) for every i in [0, count).
+    [[maybe_unused]] inline void fnva64_batch(const uint8_t *const *buffers, const size_t *sizes, uint64_t *hashes, size_t count, uint64_t basis = FNV1_BASIS_64, uint64_t prime = FNV_PRIME_64) {
+        detail::fnv_batch<uint64_t, true>(buffers, sizes, hashes, count, basis, prime);
+    }
+} // namespace astra::hash
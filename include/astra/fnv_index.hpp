@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "file_helper.hpp"
+#include "fnv.hpp"
+#include "fnv_map.hpp"
+#include "macros.hpp"
+#include "runtime_array.hpp"
+
+// an on-disk table from fnv64/fnva64 hashes to fixed size records, meant to be opened with map_file and used as-is.
+//
+//   header      64 bytes, fnv_index_header_t
+//   keys        count uint64_t, sorted
+//   records     count records of the header's record size, in the same order as the keys
+//   strings     u32 length + bytes + nul per string, records refer to them by their offset in the pool
+//   buckets     2^radix_bits + 1 uint32_t, where the keys starting with each top bit prefix begin
+//
+// every section starts on a 64 byte boundary and is stored in host byte order, so opening an index is a map and a
+// header check. pages are only faulted in by the lookups that touch them.
+//
+// fnv hashes are uniformly distributed, so the top bits of a key interpolate its position in the sorted keys almost
+// exactly. the index stores that interpolation as a radix table with about one bucket per 4 keys, a lookup reads one
+// table entry and finishes with a branchless binary search over the few keys of its bucket, usually one cache line.
+// find_many prefetches the buckets and keys of a group of lookups first so their cache misses overlap.
+
+namespace astra::io {
+    // sorted keys with a radix table is the only layout, the header field keeps room for others.
+    enum class fnv_index_layout : uint16_t {
+        sorted = 0,
+    };
+
+    struct fnv_index_header_t {
+        uint32_t magic          = 0;
+        uint16_t version        = 0;
+        fnv_index_layout layout = fnv_index_layout::sorted;
+        uint32_t record_size    = 0;
+        uint32_t radix_bits     = 0;
+        uint64_t count          = 0;
+        uint64_t keys_offset    = 0;
+        uint64_t records_offset = 0;
+        uint64_t strings_offset = 0;
+        uint64_t strings_size   = 0;
+        uint64_t buckets_offset = 0;
+    };
+
+    static_assert(sizeof(fnv_index_header_t) == 64);
+
+    // the default record, where a hashed asset path lives inside an archive.
+    struct fnv_index_entry_t {
+        uint32_t file   = 0; // string pool offset of the archive path.
+        uint32_t flags  = 0;
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    namespace detail {
+        constexpr uint32_t FNV_INDEX_MAGIC   = 0x58444946; // "FIDX"
+        constexpr uint16_t FNV_INDEX_VERSION = 1;
+        constexpr size_t FNV_INDEX_ALIGN     = 64;
+        constexpr size_t FNV_INDEX_GROUP     = 16; // lookups prefetched together in find_many.
+
+        constexpr size_t fnv_index_align(size_t value) { return (value + FNV_INDEX_ALIGN - 1) & ~(FNV_INDEX_ALIGN - 1); }
+
+        // the first index in [first, last) whose key is not less than `key`, without branching on the comparisons.
+        ASTRA_INLINE size_t branchless_lower_bound(const uint64_t *keys, size_t first, size_t last, uint64_t key) {
+            auto base = keys + first;
+            auto n    = last - first;
+            if (n == 0) {
+                return first;
+            }
+
+            while (n > 1) {
+                auto half = n / 2;
+                base      = base[half] < key ? base + half : base;
+                n -= half;
+            }
+            return static_cast<size_t>(base - keys) + (*base < key);
+        }
+
+        // the radix table gets about one bucket per 4 keys.
+        ASTRA_INLINE uint32_t fnv_index_radix_bits(size_t count) { return static_cast<uint32_t>(std::max<int>(0, std::bit_width(count) - 2)); }
+
+        ASTRA_INLINE size_t fnv_index_bucket(uint64_t key, uint32_t bits) { return bits == 0 ? 0 : static_cast<size_t>(key >> (64 - bits)); }
+    } // namespace detail
+
+    template<typename R = fnv_index_entry_t>
+    class fnv_index {
+        static_assert(std::is_trivially_copyable_v<R> && alignof(R) <= detail::FNV_INDEX_ALIGN, "records are read straight from the mapping");
+
+    private:
+        astra::mem::runtime_array<uint8_t> buffer;
+        const uint64_t *keys_data = nullptr;
+        const R *records_data     = nullptr;
+        const uint8_t *strings    = nullptr;
+        const uint32_t *buckets   = nullptr;
+        size_t strings_size       = 0;
+        size_t count              = 0;
+        uint32_t radix_bits       = 0;
+
+        [[nodiscard]] size_t index_of(uint64_t key) const {
+            // clamped so a damaged table can't send the search outside the keys.
+            auto bucket = buckets + detail::fnv_index_bucket(key, radix_bits);
+            auto last   = std::min<size_t>(bucket[1], count);
+            auto slot   = detail::branchless_lower_bound(keys_data, std::min<size_t>(bucket[0], last), last, key);
+            return slot < count && keys_data[slot] == key ? slot : SIZE_MAX;
+        }
+
+    public:
+        fnv_index() = default;
+
+        // takes a complete index file, usually a map_file mapping, and keeps it alive. only the header is read.
+        explicit fnv_index(astra::mem::runtime_array<uint8_t> bytes) : buffer(std::move(bytes)) {
+            fnv_index_header_t header;
+            if (buffer.size() < sizeof(header)) {
+                throw std::invalid_argument("fnv_index: file is too small for the header");
+            }
+
+            std::memcpy(&header, buffer.data(), sizeof(header));
+            if (header.magic == std::byteswap(detail::FNV_INDEX_MAGIC)) {
+                throw std::invalid_argument("fnv_index: index was written in the other byte order");
+            }
+            if (header.magic != detail::FNV_INDEX_MAGIC) {
+                throw std::invalid_argument("fnv_index: not an fnv index");
+            }
+            if (header.version != detail::FNV_INDEX_VERSION) {
+                throw std::invalid_argument("fnv_index: unsupported version");
+            }
+            if (header.record_size != sizeof(R)) {
+                throw std::invalid_argument("fnv_index: record size doesn't match the record type");
+            }
+            if (header.layout != fnv_index_layout::sorted) {
+                throw std::invalid_argument("fnv_index: unknown key layout");
+            }
+
+            auto size   = static_cast<uint64_t>(buffer.size());
+            auto inside = [size](uint64_t offset, uint64_t bytes) { return offset % detail::FNV_INDEX_ALIGN == 0 && offset <= size && bytes <= size - offset; };
+            if (header.count > size / sizeof(uint64_t) || !inside(header.keys_offset, header.count * sizeof(uint64_t)) || !inside(header.records_offset, header.count * sizeof(R)) ||
+                !inside(header.strings_offset, header.strings_size) || header.radix_bits > 32 || !inside(header.buckets_offset, ((uint64_t{1} << header.radix_bits) + 1) * sizeof(uint32_t))) {
+                throw std::out_of_range("fnv_index: section runs past the end of the file");
+            }
+            if (reinterpret_cast<uintptr_t>(buffer.data()) % alignof(R) != 0 || reinterpret_cast<uintptr_t>(buffer.data()) % alignof(uint64_t) != 0) {
+                throw std::invalid_argument("fnv_index: buffer is not aligned for its records");
+            }
+
+            keys_data    = reinterpret_cast<const uint64_t *>(buffer.data() + header.keys_offset);
+            records_data = reinterpret_cast<const R *>(buffer.data() + header.records_offset);
+            strings      = buffer.data() + header.strings_offset;
+            strings_size = static_cast<size_t>(header.strings_size);
+            count        = static_cast<size_t>(header.count);
+            buckets      = reinterpret_cast<const uint32_t *>(buffer.data() + header.buckets_offset);
+            radix_bits   = header.radix_bits;
+            if (buckets[size_t{1} << radix_bits] != count) {
+                throw std::invalid_argument("fnv_index: radix table doesn't cover the keys");
+            }
+        }
+
+        [[maybe_unused]] static fnv_index open(const std::filesystem::path &path, map_hint hint = map_hint::random) { return fnv_index(*map_file(path, map_mode::read_only, hint)); }
+
+        [[nodiscard]] size_t size() const { return count; }
+
+        [[maybe_unused]] [[nodiscard]] bool empty() const { return count == 0; }
+
+        // keys and records in file order, record i belongs to key i.
+        [[maybe_unused]] [[nodiscard]] std::span<const uint64_t> keys() const { return {keys_data, count}; }
+
+        [[maybe_unused]] [[nodiscard]] std::span<const R> records() const { return {records_data, count}; }
+
+        // returns nullptr if the key is not present.
+        [[nodiscard]] const R *find(uint64_t key) const {
+            auto slot = index_of(key);
+            return slot == SIZE_MAX ? nullptr : records_data + slot;
+        }
+
+        [[maybe_unused]] [[nodiscard]] const R *find(std::string_view path) const { return find(hash::fnva64(path)); }
+
+        [[maybe_unused]] [[nodiscard]] bool contains(uint64_t key) const { return index_of(key) != SIZE_MAX; }
+
+        // looks up many keys at once, the buckets and then the keys of a group are prefetched before any of them is searched.
+        [[maybe_unused]] void find_many(const uint64_t *lookup, size_t lookup_count, const R **results) const {
+            constexpr size_t group = detail::FNV_INDEX_GROUP;
+            if (count == 0) {
+                std::fill_n(results, lookup_count, nullptr);
+                return;
+            }
+
+            for (size_t first = 0; first < lookup_count; first += group) {
+                auto n = std::min(group, lookup_count - first);
+#if defined(__GNUC__) || defined(__clang__)
+                for (size_t j = 0; j < n; ++j) {
+                    __builtin_prefetch(buckets + detail::fnv_index_bucket(lookup[first + j], radix_bits));
+                }
+                for (size_t j = 0; j < n; ++j) {
+                    __builtin_prefetch(keys_data + std::min<size_t>(buckets[detail::fnv_index_bucket(lookup[first + j], radix_bits)], count - 1));
+                }
+#endif
+                for (size_t j = 0; j < n; ++j) {
+                    results[first + j] = find(lookup[first + j]);
+                }
+            }
+        }
+
+        // a string from the pool, records refer to them by the offset add_string returned.
+        [[nodiscard]] std::string_view string(uint32_t offset) const {
+            if (offset > strings_size || strings_size - offset < sizeof(uint32_t)) {
+                throw std::out_of_range("fnv_index: string offset is outside the string pool");
+            }
+
+            uint32_t length;
+            std::memcpy(&length, strings + offset, sizeof(length));
+            if (length > strings_size - offset - sizeof(uint32_t)) {
+                throw std::out_of_range("fnv_index: string runs past the end of the string pool");
+            }
+            return {reinterpret_cast<const char *>(strings) + offset + sizeof(uint32_t), length};
+        }
+    };
+
+    // collects keys, records and strings in any order and writes them out as an fnv_index.
+    template<typename R = fnv_index_entry_t>
+    class fnv_index_builder {
+        static_assert(std::is_trivially_copyable_v<R> && alignof(R) <= detail::FNV_INDEX_ALIGN, "records are read straight from the mapping");
+
+    private:
+        std::vector<uint64_t> keys;
+        std::vector<R> records;
+        std::vector<uint8_t> strings;
+        astra::mem::fnv_map<uint32_t> interned;
+
+    public:
+        [[maybe_unused]] void reserve(size_t entries) {
+            keys.reserve(entries);
+            records.reserve(entries);
+        }
+
+        [[nodiscard]] size_t size() const { return keys.size(); }
+
+        void add(uint64_t key, const R &record) {
+            keys.push_back(key);
+            records.push_back(record);
+        }
+
+        [[maybe_unused]] void add(std::string_view path, const R &record) { add(hash::fnva64(path), record); }
+
+        // adds a string to the pool and returns its offset. equal strings are stored once.
+        uint32_t add_string(std::string_view text) {
+            auto hash = hash::fnva64(text);
+            if (auto existing = interned.find(hash); existing != nullptr) {
+                uint32_t length;
+                std::memcpy(&length, strings.data() + *existing, sizeof(length));
+                if (std::string_view(reinterpret_cast<const char *>(strings.data()) + *existing + sizeof(length), length) == text) {
+                    return *existing;
+                }
+            }
+
+            if (strings.size() + sizeof(uint32_t) + text.size() + 1 > UINT32_MAX) {
+                throw std::out_of_range("fnv_index_builder: string pool is larger than 4 GiB");
+            }
+
+            auto offset = static_cast<uint32_t>(strings.size());
+            auto length = static_cast<uint32_t>(text.size());
+            strings.resize(strings.size() + sizeof(length) + text.size() + 1);
+            std::memcpy(strings.data() + offset, &length, sizeof(length));
+            std::memcpy(strings.data() + offset + sizeof(length), text.data(), text.size());
+            interned.emplace(hash, offset);
+            return offset;
+        }
+
+        // the finished index file. duplicate keys throw std::invalid_argument.
+        [[nodiscard]] astra::mem::runtime_array<uint8_t> build() const {
+            if (keys.size() > UINT32_MAX) {
+                throw std::out_of_range("fnv_index_builder: too many entries");
+            }
+
+            std::vector<uint32_t> order(keys.size());
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+            if (std::adjacent_find(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return keys[a] == keys[b]; }) != order.end()) {
+                throw std::invalid_argument("fnv_index_builder: duplicate key");
+            }
+
+            fnv_index_header_t header;
+            header.magic          = detail::FNV_INDEX_MAGIC;
+            header.version        = detail::FNV_INDEX_VERSION;
+            header.layout         = fnv_index_layout::sorted;
+            header.record_size    = sizeof(R);
+            header.count          = keys.size();
+            header.keys_offset    = detail::fnv_index_align(sizeof(header));
+            header.records_offset = detail::fnv_index_align(header.keys_offset + keys.size() * sizeof(uint64_t));
+            header.strings_offset = detail::fnv_index_align(header.records_offset + records.size() * sizeof(R));
+            header.strings_size   = strings.size();
+            header.radix_bits     = detail::fnv_index_radix_bits(keys.size());
+            header.buckets_offset = detail::fnv_index_align(header.strings_offset + header.strings_size);
+
+            auto end  = header.buckets_offset + ((uint64_t{1} << header.radix_bits) + 1) * sizeof(uint32_t);
+            auto file = astra::mem::runtime_array<uint8_t>(nullptr, static_cast<size_t>(end), uint8_t{0});
+            std::memcpy(file.data(), &header, sizeof(header));
+            auto key_out    = reinterpret_cast<uint64_t *>(file.data() + header.keys_offset);
+            auto record_out = reinterpret_cast<R *>(file.data() + header.records_offset);
+            auto bucket_out = reinterpret_cast<uint32_t *>(file.data() + header.buckets_offset);
+            size_t bucket   = 0;
+            for (size_t i = 0; i < order.size(); ++i) {
+                key_out[i]    = keys[order[i]];
+                record_out[i] = records[order[i]];
+                for (auto last = detail::fnv_index_bucket(key_out[i], header.radix_bits); bucket <= last; ++bucket) {
+                    bucket_out[bucket] = static_cast<uint32_t>(i);
+                }
+            }
+            for (; bucket <= (size_t{1} << header.radix_bits); ++bucket) {
+                bucket_out[bucket] = static_cast<uint32_t>(order.size());
+            }
+
+            if (!strings.empty()) {
+                std::memcpy(file.data() + header.strings_offset, strings.data(), strings.size());
+            }
+            return file;
+        }
+
+        [[maybe_unused]] void write(const std::filesystem::path &path) const {
+            auto file = std::make_shared<astra::mem::runtime_array<uint8_t>>(build());
+            write_file(path, file);
+        }
+    };
+} // namespace astra::io
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "macros.hpp"
+
+#ifdef ASTRA_X86
+#    include <emmintrin.h>
+#endif
+
+namespace astra::mem {
+    // an open addressing hash table for keys that already are hashes (fnv64, fnva64).
+    // the key is used as-is: the low 7 bits are kept in a control byte so a whole group of 16 slots can be matched with
+    // one simd compare, the bits just above them pick the home group. keys, values and control bytes are kept in
+    // separate arrays, so probing only touches the control bytes and the keys that actually match.
+    template<typename V>
+    class fnv_map {
+    private:
+        static constexpr size_t group_size  = 16;
+        static constexpr int8_t ctrl_empty   = -128;
+        static constexpr int8_t ctrl_deleted = -2;
+
+        int8_t *ctrl       = nullptr;
+        uint64_t *keys     = nullptr;
+        V *values          = nullptr;
+        size_t groups      = 0;
+        size_t count       = 0;
+        size_t growth_left = 0;
+
+        [[nodiscard]] static ASTRA_INLINE int8_t tag(uint64_t key) { return static_cast<int8_t>(key & 0x7F); }
+
+        [[nodiscard]] ASTRA_INLINE size_t home(uint64_t key) const { return static_cast<size_t>(key >> 7) & (groups - 1); }
+
+        // bit i is set when control byte i of the group equals `value`.
+        [[nodiscard]] static ASTRA_INLINE uint32_t match(const int8_t *group, int8_t value) {
+#ifdef ASTRA_X86
+            auto bytes = _mm_load_si128(reinterpret_cast<const __m128i *>(group));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+            uint32_t bits = 0;
+            for (size_t i = 0; i < group_size; ++i) {
+                bits |= static_cast<uint32_t>(group[i] == value) << i;
+            }
+            return bits;
+#endif
+        }
+
+        // bit i is set when slot i of the group is free (empty or deleted).
+        [[nodiscard]] static ASTRA_INLINE uint32_t match_free(const int8_t *group) {
+#ifdef ASTRA_X86
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(group))));
+#else
+            uint32_t bits = 0;
+            for (size_t i = 0; i < group_size; ++i) {
+                bits |= static_cast<uint32_t>(group[i] < 0) << i;
+            }
+            return bits;
+#endif
+        }
+
+        [[nodiscard]] size_t find_slot(uint64_t key) const {
+            if (groups == 0) {
+                return SIZE_MAX;
+            }
+
+            auto group = home(key);
+            auto value = tag(key);
+            for (size_t step = 1;; ++step) {
+                auto base = group * group_size;
+                for (auto bits = match(ctrl + base, value); bits != 0; bits &= bits - 1) {
+                    auto slot = base + static_cast<size_t>(std::countr_zero(bits));
+                    if (keys[slot] == key) {
+                        return slot;
+                    }
+                }
+
+                if (match(ctrl + base, ctrl_empty) != 0) {
+                    return SIZE_MAX;
+                }
+
+                // triangular probing visits every group when the group count is a power of two.
+                group = (group + step) & (groups - 1);
+            }
+        }
+
+        [[nodiscard]] size_t free_slot(uint64_t key) const {
+            auto group = home(key);
+            for (size_t step = 1;; ++step) {
+                auto base = group * group_size;
+                if (auto bits = match_free(ctrl + base); bits != 0) {
+                    return base + static_cast<size_t>(std::countr_zero(bits));
+                }
+
+                group = (group + step) & (groups - 1);
+            }
+        }
+
+        void allocate(size_t group_count) {
+            auto slots  = group_count * group_size;
+            ctrl        = static_cast<int8_t *>(::operator new(slots, std::align_val_t(ASTRA_ALIGNMENT)));
+            keys        = static_cast<uint64_t *>(::operator new(slots * sizeof(uint64_t), std::align_val_t(ASTRA_ALIGNMENT)));
+            values      = static_cast<V *>(::operator new(slots * sizeof(V), std::align_val_t(alignof(V) > ASTRA_ALIGNMENT ? alignof(V) : ASTRA_ALIGNMENT)));
+            groups      = group_count;
+            growth_left = slots - slots / 8;
+            std::memset(ctrl, ctrl_empty, slots);
+        }
+
+        void release() {
+            if (groups == 0) {
+                return;
+            }
+
+            for (size_t slot = 0; slot < groups * group_size; ++slot) {
+                if (ctrl[slot] >= 0) {
+                    std::destroy_at(values + slot);
+                }
+            }
+
+            ::operator delete(ctrl, std::align_val_t(ASTRA_ALIGNMENT));
+            ::operator delete(keys, std::align_val_t(ASTRA_ALIGNMENT));
+            ::operator delete(values, std::align_val_t(alignof(V) > ASTRA_ALIGNMENT ? alignof(V) : ASTRA_ALIGNMENT));
+            ctrl   = nullptr;
+            keys   = nullptr;
+            values = nullptr;
+            groups = 0;
+        }
+
+        // moves every entry into a table with `group_count` groups, keys are placed by their own bits so nothing is hashed.
+        void resize(size_t group_count) {
+            auto old_ctrl   = ctrl;
+            auto old_keys   = keys;
+            auto old_values = values;
+            auto old_slots  = groups * group_size;
+
+            allocate(group_count);
+            growth_left -= count;
+            for (size_t slot = 0; slot < old_slots; ++slot) {
+                if (old_ctrl[slot] >= 0) {
+                    auto target = free_slot(old_keys[slot]);
+                    ctrl[target] = old_ctrl[slot];
+                    keys[target] = old_keys[slot];
+                    std::construct_at(values + target, std::move(old_values[slot]));
+                    std::destroy_at(old_values + slot);
+                }
+            }
+
+            if (old_slots != 0) {
+                ::operator delete(old_ctrl, std::align_val_t(ASTRA_ALIGNMENT));
+                ::operator delete(old_keys, std::align_val_t(ASTRA_ALIGNMENT));
+                ::operator delete(old_values, std::align_val_t(alignof(V) > ASTRA_ALIGNMENT ? alignof(V) : ASTRA_ALIGNMENT));
+            }
+        }
+
+        [[nodiscard]] static size_t groups_for(size_t entries) {
+            // keep the load factor at or below 7/8.
+            auto slots = entries + entries / 7 + 1;
+            return std::bit_ceil((slots + group_size - 1) / group_size);
+        }
+
+    public:
+        fnv_map() = default;
+
+        explicit fnv_map(size_t entries) { reserve(entries); }
+
+        fnv_map(const fnv_map &)            = delete;
+        fnv_map &operator=(const fnv_map &) = delete;
+
+        fnv_map(fnv_map &&other) noexcept { *this = std::move(other); }
+
+        fnv_map &operator=(fnv_map &&other) noexcept {
+            if (this != &other) {
+                release();
+                ctrl        = std::exchange(other.ctrl, nullptr);
+                keys        = std::exchange(other.keys, nullptr);
+                values      = std::exchange(other.values, nullptr);
+                groups      = std::exchange(other.groups, 0);
+                count       = std::exchange(other.count, 0);
+                growth_left = std::exchange(other.growth_left, 0);
+            }
+            return *this;
+        }
+
+        ~fnv_map() { release(); }
+
+        [[nodiscard]] size_t size() const { return count; }
+
+        [[maybe_unused]] [[nodiscard]] bool empty() const { return count == 0; }
+
+        [[maybe_unused]] [[nodiscard]] size_t capacity() const { return groups * group_size; }
+
+        // sizes the table for `entries` in one go, so bulk loading never rehashes halfway through.
+        [[maybe_unused]] void reserve(size_t entries) {
+            auto wanted = groups_for(entries);
+            if (wanted > groups) {
+                resize(wanted);
+            }
+        }
+
+        [[maybe_unused]] void clear() {
+            release();
+            count       = 0;
+            growth_left = 0;
+        }
+
+        // inserts a value constructed from args unless the key exists, returns the value and whether it was inserted.
+        template<typename... Args>
+        std::pair<V *, bool> emplace(uint64_t key, Args &&...args) {
+            if (auto slot = find_slot(key); slot != SIZE_MAX) {
+                return {values + slot, false};
+            }
+
+            if (growth_left == 0) {
+                // tombstones count against growth, rehash in place if they are the reason we're full.
+                resize(count * 2 >= capacity() - capacity() / 8 ? std::max<size_t>(groups * 2, 1) : groups);
+            }
+
+            auto slot = free_slot(key);
+            if (ctrl[slot] == ctrl_empty) {
+                growth_left--;
+            }
+
+            ctrl[slot] = tag(key);
+            keys[slot] = key;
+            std::construct_at(values + slot, std::forward<Args>(args)...);
+            count++;
+            return {values + slot, true};
+        }
+
+        template<typename U>
+        [[maybe_unused]] V &insert_or_assign(uint64_t key, U &&value) {
+            auto [entry, inserted] = emplace(key, std::forward<U>(value));
+            if (!inserted) {
+                *entry = std::forward<U>(value);
+            }
+            return *entry;
+        }
+
+        [[maybe_unused]] V &operator[](uint64_t key) { return *emplace(key).first; }
+
+        // returns nullptr if the key is not present.
+        [[nodiscard]] V *find(uint64_t key) const {
+            auto slot = find_slot(key);
+            return slot == SIZE_MAX ? nullptr : values + slot;
+        }
+
+        [[maybe_unused]] [[nodiscard]] bool contains(uint64_t key) const { return find_slot(key) != SIZE_MAX; }
+
+        // looks up many keys at once. the home groups of a window of keys are prefetched before any of them is probed,
+        // so the cache misses of a window overlap instead of being paid one after the other.
+        [[maybe_unused]] void find_many(const uint64_t *lookup, size_t lookup_count, V **results) const {
+            constexpr size_t window = 16;
+            if (groups == 0) {
+                std::fill_n(results, lookup_count, nullptr);
+                return;
+            }
+
+            for (size_t i = 0; i < lookup_count; i += window) {
+                auto end = std::min(lookup_count, i + window);
+#if defined(__GNUC__) || defined(__clang__)
+                for (auto j = i; j < end; ++j) {
+                    auto base = home(lookup[j]) * group_size;
+                    __builtin_prefetch(ctrl + base);
+                    __builtin_prefetch(keys + base);
+                }
+#endif
+                for (auto j = i; j < end; ++j) {
+                    results[j] = find(lookup[j]);
+                }
+            }
+        }
+
+        [[maybe_unused]] bool erase(uint64_t key) {
+            auto slot = find_slot(key);
+            if (slot == SIZE_MAX) {
+                return false;
+            }
+
+            std::destroy_at(values + slot);
+            count--;
+
+            // a group that still has an empty slot never made a probe continue past it, so the slot can become empty again.
+            auto base = slot - slot % group_size;
+            if (match(ctrl + base, ctrl_empty) != 0) {
+                ctrl[slot] = ctrl_empty;
+                growth_left++;
+            } else {
+                ctrl[slot] = ctrl_deleted;
+            }
+            return true;
+        }
+
+        // calls fn(key, value) for every entry, in table order.
+        template<typename F>
+        [[maybe_unused]] void for_each(F &&fn) const {
+            for (size_t slot = 0; slot < groups * group_size; ++slot) {
+                if (ctrl[slot] >= 0) {
+                    fn(keys[slot], values[slot]);
+                }
+            }
+        }
+    };
+} // namespace astra::mem
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#ifdef ASTRA_INSTRUMENT
+#    include <atomic>
+#    include <map>
+#    include <mutex>
+#    include <string_view>
+#endif
+
+#include "macros.hpp"
+
+// opt-in accounting of runtime_array allocations, deep copies and views, per runtime_array<T> instantiation. it only
+// exists when ASTRA_INSTRUMENT is defined (the ASTRA_INSTRUMENT cmake option), otherwise every hook expands to nothing
+// and snapshot() is empty. each thread bumps its own counters with plain relaxed stores, snapshot() sums them over all
+// threads, live and exited. live and peak bytes need one global view, they are shared atomics per type.
+// ASTRA_MEM_SITE() attributes everything its enclosing scope does to that source location.
+
+namespace astra::mem::instrument {
+    struct counters_t {
+        uint64_t allocations     = 0;
+        uint64_t allocated_bytes = 0;
+        uint64_t releases        = 0;
+        uint64_t released_bytes  = 0;
+        uint64_t copies          = 0;
+        uint64_t copied_bytes    = 0;
+        uint64_t views           = 0;
+        uint64_t live_bytes      = 0; // types only, storage is often released away from the site that allocated it.
+        uint64_t peak_live_bytes = 0;
+    };
+
+    struct entry_t {
+        std::string name;
+        counters_t counters;
+    };
+
+    struct snapshot_t {
+        std::vector<entry_t> types; // one per runtime_array<T> that has been used.
+        std::vector<entry_t> sites; // one per ASTRA_MEM_SITE() that has been entered.
+        counters_t total; // its peak is the sum of the per-type peaks, an upper bound.
+    };
+
+    // true when the library was built with ASTRA_INSTRUMENT.
+#ifdef ASTRA_INSTRUMENT
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    enum class event { allocate, release, copy, view };
+
+#ifdef ASTRA_INSTRUMENT
+    namespace detail {
+        inline constexpr size_t max_types = 128; // later types share the last slot.
+        inline constexpr size_t max_sites = 256;
+        inline constexpr size_t no_site   = SIZE_MAX;
+
+        enum counter : size_t { allocations, allocated_bytes, releases, released_bytes, copies, copied_bytes, views, counter_count };
+
+        // written only by the owning thread, read by snapshot() from any thread.
+        struct thread_block_t {
+            std::atomic<uint64_t> types[max_types][counter_count] = {};
+            std::atomic<uint64_t> sites[max_sites][counter_count] = {};
+        };
+
+        struct registry_t {
+            std::mutex lock;
+            std::vector<thread_block_t *> threads;
+            thread_block_t retired; // the sums of every thread that has exited.
+            std::vector<std::string> type_names;
+            std::vector<std::string> site_names;
+            std::map<std::string, size_t> site_slots;
+            std::atomic<int64_t> live[max_types]  = {};
+            std::atomic<uint64_t> peak[max_types] = {};
+
+            size_t add_type(std::string name) {
+                std::lock_guard guard(lock);
+                if (type_names.size() == max_types - 1) {
+                    type_names.emplace_back("(other)");
+                }
+                if (type_names.size() >= max_types) {
+                    return max_types - 1;
+                }
+                type_names.push_back(std::move(name));
+                return type_names.size() - 1;
+            }
+
+            size_t add_site(const std::source_location &location) {
+                auto name = std::string(location.file_name()) + ":" + std::to_string(location.line()) + " " + location.function_name();
+                std::lock_guard guard(lock);
+                if (auto found = site_slots.find(name); found != site_slots.end()) {
+                    return found->second;
+                }
+                if (site_names.size() >= max_sites) {
+                    return no_site;
+                }
+                site_names.push_back(name);
+                return site_slots[name] = site_names.size() - 1;
+            }
+
+            void retire(thread_block_t *block) {
+                std::lock_guard guard(lock);
+                for (size_t t = 0; t < max_types; ++t) {
+                    for (size_t c = 0; c < counter_count; ++c) {
+                        retired.types[t][c].fetch_add(block->types[t][c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    }
+                }
+                for (size_t s = 0; s < max_sites; ++s) {
+                    for (size_t c = 0; c < counter_count; ++c) {
+                        retired.sites[s][c].fetch_add(block->sites[s][c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    }
+                }
+                std::erase(threads, block);
+            }
+        };
+
+        // never destroyed, arrays released by static destructors still have somewhere to report to.
+        inline registry_t &registry() {
+            static auto *instance = new registry_t;
+            return *instance;
+        }
+
+        inline thread_block_t *&thread_slot() {
+            thread_local thread_block_t *block = nullptr;
+            return block;
+        }
+
+        // folds the thread's counters into the registry when it exits. whatever the thread does after that (in other
+        // thread_local destructors) is counted straight into the retired block.
+        struct thread_handle_t {
+            thread_handle_t()                                   = default;
+            thread_handle_t(const thread_handle_t &)            = delete;
+            thread_handle_t &operator=(const thread_handle_t &) = delete;
+
+            ~thread_handle_t() {
+                auto block = thread_slot();
+                registry().retire(block);
+                thread_slot() = &registry().retired;
+                delete block;
+            }
+        };
+
+        inline thread_block_t &this_thread() {
+            auto &block = thread_slot();
+            if (block == nullptr) [[unlikely]] {
+                block = new thread_block_t;
+                {
+                    std::lock_guard guard(registry().lock);
+                    registry().threads.push_back(block);
+                }
+                thread_local thread_handle_t handle;
+            }
+            return *block;
+        }
+
+        inline size_t &current_site() {
+            thread_local size_t site = no_site;
+            return site;
+        }
+
+        // the readable name of T, cut out of the compiler's function signature.
+        template<typename T>
+        std::string type_name() {
+            std::string_view name = std::source_location::current().function_name();
+            if (auto start = name.find("T = "); start != std::string_view::npos) {
+                start += 4;
+                return std::string(name.substr(start, name.find_first_of(";]", start) - start));
+            }
+            if (auto start = name.find("type_name<"); start != std::string_view::npos) {
+                start += 10;
+                return std::string(name.substr(start, name.rfind(">(") - start));
+            }
+            return std::string(name);
+        }
+
+        template<typename T>
+        size_t type_slot() {
+            static const size_t slot = registry().add_type(type_name<T>());
+            return slot;
+        }
+
+        ASTRA_INLINE void bump(std::atomic<uint64_t> &counter, uint64_t value) { counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+
+        ASTRA_INLINE void bump(std::atomic<uint64_t> (&counters)[counter_count], event kind, uint64_t bytes) {
+            switch (kind) {
+                case event::allocate:
+                    bump(counters[allocations], 1);
+                    bump(counters[allocated_bytes], bytes);
+                    break;
+                case event::release:
+                    bump(counters[releases], 1);
+                    bump(counters[released_bytes], bytes);
+                    break;
+                case event::copy:
+                    bump(counters[copies], 1);
+                    bump(counters[copied_bytes], bytes);
+                    break;
+                case event::view: bump(counters[views], 1); break;
+            }
+        }
+
+        inline void add(counters_t &sum, const std::atomic<uint64_t> (&counters)[counter_count]) {
+            sum.allocations += counters[allocations].load(std::memory_order_relaxed);
+            sum.allocated_bytes += counters[allocated_bytes].load(std::memory_order_relaxed);
+            sum.releases += counters[releases].load(std::memory_order_relaxed);
+            sum.released_bytes += counters[released_bytes].load(std::memory_order_relaxed);
+            sum.copies += counters[copies].load(std::memory_order_relaxed);
+            sum.copied_bytes += counters[copied_bytes].load(std::memory_order_relaxed);
+            sum.views += counters[views].load(std::memory_order_relaxed);
+        }
+    } // namespace detail
+
+    // counts one event of runtime_array<T> on this thread, `bytes` is ignored for views.
+    template<typename T>
+    inline void record(event kind, uint64_t bytes) {
+        auto &block = detail::this_thread();
+        auto slot   = detail::type_slot<T>();
+        detail::bump(block.types[slot], kind, bytes);
+        if (auto site = detail::current_site(); site != detail::no_site) {
+            detail::bump(block.sites[site], kind, bytes);
+        }
+
+        auto &registry = detail::registry();
+        if (kind == event::allocate) {
+            auto live = static_cast<uint64_t>(registry.live[slot].fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes));
+            auto peak = registry.peak[slot].load(std::memory_order_relaxed);
+            while (live > peak && !registry.peak[slot].compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+        } else if (kind == event::release) {
+            registry.live[slot].fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        }
+    }
+
+    // attributes the events of this thread to `location` until the scope ends, scopes nest.
+    class site_scope {
+    private:
+        size_t previous;
+
+    public:
+        explicit site_scope(size_t slot) : previous(detail::current_site()) { detail::current_site() = slot; }
+
+        // looks the location up on every entry, ASTRA_MEM_SITE() does that once per call site.
+        explicit site_scope(const std::source_location &location = std::source_location::current()) : site_scope(detail::registry().add_site(location)) { }
+
+        ~site_scope() { detail::current_site() = previous; }
+
+        site_scope(const site_scope &)            = delete;
+        site_scope &operator=(const site_scope &) = delete;
+    };
+
+    [[maybe_unused]] inline size_t register_site(const std::source_location &location = std::source_location::current()) { return detail::registry().add_site(location); }
+
+    // the counters of every thread so far.
+    [[maybe_unused]] inline snapshot_t snapshot() {
+        auto &registry = detail::registry();
+        std::lock_guard guard(registry.lock);
+
+        snapshot_t result;
+        for (size_t t = 0; t < registry.type_names.size(); ++t) {
+            entry_t entry{registry.type_names[t], {}};
+            detail::add(entry.counters, registry.retired.types[t]);
+            for (auto block : registry.threads) {
+                detail::add(entry.counters, block->types[t]);
+            }
+            entry.counters.live_bytes      = static_cast<uint64_t>(std::max<int64_t>(registry.live[t].load(std::memory_order_relaxed), 0));
+            entry.counters.peak_live_bytes = registry.peak[t].load(std::memory_order_relaxed);
+            result.types.push_back(std::move(entry));
+        }
+
+        for (size_t s = 0; s < registry.site_names.size(); ++s) {
+            entry_t entry{registry.site_names[s], {}};
+            detail::add(entry.counters, registry.retired.sites[s]);
+            for (auto block : registry.threads) {
+                detail::add(entry.counters, block->sites[s]);
+            }
+            result.sites.push_back(std::move(entry));
+        }
+
+        for (auto &entry : result.types) {
+            result.total.allocations += entry.counters.allocations;
+            result.total.allocated_bytes += entry.counters.allocated_bytes;
+            result.total.releases += entry.counters.releases;
+            result.total.released_bytes += entry.counters.released_bytes;
+            result.total.copies += entry.counters.copies;
+            result.total.copied_bytes += entry.counters.copied_bytes;
+            result.total.views += entry.counters.views;
+            result.total.live_bytes += entry.counters.live_bytes;
+            result.total.peak_live_bytes += entry.counters.peak_live_bytes;
+        }
+        return result;
+    }
+#else
+    template<typename T>
+    ASTRA_INLINE void record(event, uint64_t) { }
+
+    class site_scope {
+    public:
+        explicit site_scope(size_t) { }
+
+        explicit site_scope(const std::source_location & = std::source_location::current()) { }
+    };
+
+    [[maybe_unused]] inline size_t register_site(const std::source_location & = std::source_location::current()) { return 0; }
+
+    [[maybe_unused]] inline snapshot_t snapshot() { return {}; }
+#endif
+
+    // what happened between two snapshots. live and peak bytes are taken from `later` as they are.
+    [[maybe_unused]] inline snapshot_t difference(const snapshot_t &later, const snapshot_t &earlier) {
+        auto subtract = [](counters_t a, const counters_t &b) {
+            a.allocations -= b.allocations;
+            a.allocated_bytes -= b.allocated_bytes;
+            a.releases -= b.releases;
+            a.released_bytes -= b.released_bytes;
+            a.copies -= b.copies;
+            a.copied_bytes -= b.copied_bytes;
+            a.views -= b.views;
+            return a;
+        };
+
+        // types and sites are only ever appended, so entries line up by index.
+        auto result  = later;
+        result.total = subtract(later.total, earlier.total);
+        for (size_t i = 0; i < std::min(result.types.size(), earlier.types.size()); ++i) {
+            result.types[i].counters = subtract(later.types[i].counters, earlier.types[i].counters);
+        }
+        for (size_t i = 0; i < std::min(result.sites.size(), earlier.sites.size()); ++i) {
+            result.sites[i].counters = subtract(later.sites[i].counters, earlier.sites[i].counters);
+        }
+        return result;
+    }
+
+    // a plain text table of a snapshot, types first and then sites.
+    [[maybe_unused]] inline void report(std::ostream &out, const snapshot_t &snapshot) {
+        if constexpr (!enabled) {
+            out << "astra instrumentation is disabled, build with ASTRA_INSTRUMENT\n";
+            return;
+        }
+
+        auto row = [&out](const std::string &name, const counters_t &counters, bool live) {
+            out << name << "\n    allocations " << counters.allocations << " (" << counters.allocated_bytes << " bytes), releases " << counters.releases << " (" << counters.released_bytes << " bytes), copies " << counters.copies << " (" << counters.copied_bytes << " bytes), views " << counters.views;
+            if (live) {
+                out << ", live " << counters.live_bytes << " bytes, peak " << counters.peak_live_bytes << " bytes";
+            }
+            out << '\n';
+        };
+
+        out << "runtime_array types\n";
+        for (auto &entry : snapshot.types) {
+            row("  " + entry.name, entry.counters, true);
+        }
+
+        if (!snapshot.sites.empty()) {
+            out << "sites\n";
+            for (auto &entry : snapshot.sites) {
+                row("  " + entry.name, entry.counters, false);
+            }
+        }
+
+        row("total", snapshot.total, true);
+    }
+} // namespace astra::mem::instrument
+
+#ifdef ASTRA_INSTRUMENT
+#    define ASTRA_MEM_CONCAT_(a, b) a##b
+#    define ASTRA_MEM_CONCAT(a, b) ASTRA_MEM_CONCAT_(a, b)
+// attributes the rest of the enclosing scope to this line, the site is registered once.
+#    define ASTRA_MEM_SITE()                                                                                                  \
+        static const size_t ASTRA_MEM_CONCAT(astra_mem_site_, __LINE__) = ::astra::mem::instrument::register_site();         \
+        ::astra::mem::instrument::site_scope ASTRA_MEM_CONCAT(astra_mem_scope_, __LINE__)(ASTRA_MEM_CONCAT(astra_mem_site_, __LINE__))
+#    define ASTRA_MEM_RECORD(type, kind, bytes) ::astra::mem::instrument::record<type>(::astra::mem::instrument::event::kind, static_cast<uint64_t>(bytes))
+#else
+#    define ASTRA_MEM_SITE()
+#    define ASTRA_MEM_RECORD(type, kind, bytes) ((void) 0)
+#endif
@@ -0,0 +1,743 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "runtime_array.hpp"
+#include "xxhash.hpp"
+
+// lz4 block and frame codec without dependencies. https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+//
+// everything decodes straight from the source buffer into a caller provided destination, usually a read_file slab or a
+// map_file mapping into a preallocated runtime_array. literals and matches are copied 16 bytes at a time while both
+// buffers have room for it, short match offsets repeat a 16 byte pattern, and the last bytes of a buffer fall back to
+// exact copies so nothing is ever read or written outside the spans. because of the wide copies the bytes of the
+// destination past the decoded size may be overwritten. malformed input throws std::invalid_argument, a destination
+// that is too small throws std::out_of_range.
+//
+// frame decoding first walks the block headers, which is cheap, then decodes the blocks of frames with independent
+// blocks (the default of the lz4 tool and of lz4_compress) on the worker pool. each block gets a provisional place in
+// the destination assuming every block but the last one of a frame is full, which is what every lz4 encoder writes,
+// and decodes go sequential when that doesn't hold. frames with linked blocks are one sequential job each.
+//
+// the compressor is the greedy single probe matcher of the lz4 fast mode with a 4096 entry hash table. frames it
+// writes always have independent blocks, which are compressed on the worker pool, and blocks that don't shrink are
+// stored as they are.
+
+namespace astra::io {
+    enum class lz4_block_size : uint8_t {
+        kb64  = 4,
+        kb256 = 5,
+        mb1   = 6,
+        mb4   = 7,
+    };
+
+    struct lz4_decode_options_t {
+        bool verify_checksums = true; // block and content checksums, the header checksum is always verified.
+        size_t max_output     = SIZE_MAX; // the largest buffer the runtime_array overload may allocate.
+        size_t workers        = 0;
+    };
+
+    struct lz4_frame_options_t {
+        lz4_block_size block_size = lz4_block_size::mb1;
+        bool block_checksum       = false;
+        bool content_checksum     = true;
+        bool content_size         = true;
+        size_t workers            = 0;
+    };
+
+    namespace detail {
+        constexpr uint32_t LZ4_MAGIC           = 0x184D2204;
+        constexpr uint32_t LZ4_SKIPPABLE_MAGIC = 0x184D2A50; // the low 4 bits are free.
+        constexpr uint32_t LZ4_LEGACY_MAGIC    = 0x184C2102;
+        constexpr uint32_t LZ4_RAW_BLOCK       = 0x80000000;
+
+        constexpr uint8_t LZ4_FLAG_VERSION          = 0x40;
+        constexpr uint8_t LZ4_FLAG_INDEPENDENT      = 0x20;
+        constexpr uint8_t LZ4_FLAG_BLOCK_CHECKSUM   = 0x10;
+        constexpr uint8_t LZ4_FLAG_CONTENT_SIZE     = 0x08;
+        constexpr uint8_t LZ4_FLAG_CONTENT_CHECKSUM = 0x04;
+        constexpr uint8_t LZ4_FLAG_DICTIONARY       = 0x01;
+
+        constexpr size_t LZ4_MIN_MATCH     = 4;
+        constexpr size_t LZ4_LAST_LITERALS = 5;  // the last 5 bytes of a block are always literals.
+        constexpr size_t LZ4_MATCH_LIMIT   = 12; // and the last match starts at least 12 bytes before the end.
+        constexpr size_t LZ4_MAX_OFFSET    = 65535;
+        constexpr size_t LZ4_HASH_LOG      = 12;
+        constexpr size_t LZ4_SKIP_TRIGGER  = 6; // every 64 failed probes the search step grows by one byte.
+
+        using lz4_table_t = std::array<uint32_t, size_t{1} << LZ4_HASH_LOG>;
+
+        ASTRA_INLINE uint32_t lz4_load32(const uint8_t *bytes) {
+            uint32_t value;
+            std::memcpy(&value, bytes, 4);
+            return value;
+        }
+
+        ASTRA_INLINE uint64_t lz4_load64(const uint8_t *bytes) {
+            uint64_t value;
+            std::memcpy(&value, bytes, 8);
+            return value;
+        }
+
+        // little endian fields of the frame format.
+        template<typename U>
+        ASTRA_INLINE U lz4_load_le(const uint8_t *bytes) {
+            U value;
+            std::memcpy(&value, bytes, sizeof(U));
+            if constexpr (std::endian::native == std::endian::big) {
+                value = std::byteswap(value);
+            }
+            return value;
+        }
+
+        template<typename U>
+        ASTRA_INLINE void lz4_store_le(uint8_t *bytes, U value) {
+            if constexpr (std::endian::native == std::endian::big) {
+                value = std::byteswap(value);
+            }
+            std::memcpy(bytes, &value, sizeof(U));
+        }
+
+        ASTRA_INLINE void lz4_copy16(uint8_t *dst, const uint8_t *src) { std::memcpy(dst, src, 16); }
+
+        [[noreturn]] inline void lz4_malformed(const char *what) { throw std::invalid_argument(what); }
+
+        [[noreturn]] inline void lz4_overflow() { throw std::out_of_range("lz4: destination is too small for the decoded data"); }
+
+        // a literal or match length of 15 continues with bytes that are added until one of them isn't 255.
+        ASTRA_INLINE size_t lz4_read_length(const uint8_t *&ip, const uint8_t *iend, size_t length) {
+            if (length != 15) {
+                return length;
+            }
+
+            uint8_t byte;
+            do {
+                if (ip >= iend) {
+                    lz4_malformed("lz4: block ends inside a length");
+                }
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        }
+
+        // decodes one block to `dst`, matches may reach back to `window`, which is `dst` for independent blocks and the
+        // start of the frame for linked ones. returns the decoded size.
+        inline size_t lz4_decode(const uint8_t *src, size_t size, const uint8_t *window, uint8_t *dst, size_t capacity) {
+            auto ip   = src;
+            auto iend = src + size;
+            auto op   = dst;
+            auto oend = dst + capacity;
+            if (size == 0) {
+                lz4_malformed("lz4: empty block");
+            }
+
+            for (;;) {
+                auto token   = *ip++;
+                size_t count = token >> 4;
+                if (count < 15 && iend - ip >= 16 && oend - op >= 16) {
+                    lz4_copy16(op, ip);
+                } else {
+                    count = lz4_read_length(ip, iend, count);
+                    if (count > static_cast<size_t>(iend - ip)) {
+                        lz4_malformed("lz4: literals run past the end of the block");
+                    }
+                    if (count > static_cast<size_t>(oend - op)) {
+                        lz4_overflow();
+                    }
+                    if (count != 0) {
+                        std::memcpy(op, ip, count);
+                    }
+                }
+                ip += count;
+                op += count;
+
+                // the last sequence has no match.
+                if (ip == iend) {
+                    break;
+                }
+
+                if (iend - ip < 2) {
+                    lz4_malformed("lz4: block ends inside a match offset");
+                }
+                size_t offset = lz4_load_le<uint16_t>(ip);
+                ip += 2;
+                if (offset == 0 || offset > static_cast<size_t>(op - window)) {
+                    lz4_malformed("lz4: match offset points before the start of the data");
+                }
+
+                count = lz4_read_length(ip, iend, token & 15) + LZ4_MIN_MATCH;
+                if (count > static_cast<size_t>(oend - op)) {
+                    lz4_overflow();
+                }
+
+                const uint8_t *match = op - offset;
+                if (static_cast<size_t>(oend - op) < count + 16) {
+                    // exact copy near the end of the destination, overlapping on purpose for short offsets.
+                    for (size_t i = 0; i < count; ++i) {
+                        op[i] = match[i];
+                    }
+                } else if (offset >= 16) {
+                    // each chunk only reads bytes that were final before it started.
+                    for (size_t i = 0; i < count; i += 16) {
+                        lz4_copy16(op + i, match + i);
+                    }
+                } else {
+                    // a short offset repeats the last `offset` bytes. build 16 bytes of that pattern and store them
+                    // every largest multiple of `offset` that fits into 16 bytes.
+                    alignas(16) uint8_t pattern[16];
+                    for (size_t i = 0; i < 16; ++i) {
+                        pattern[i] = i < offset ? match[i] : pattern[i - offset];
+                    }
+
+                    auto step = 16 - 16 % offset;
+                    for (size_t i = 0; i < count; i += step) {
+                        lz4_copy16(op + i, pattern);
+                    }
+                }
+                op += count;
+
+                // a block always ends on literals, so a match needs at least a token after it.
+                if (ip == iend) {
+                    lz4_malformed("lz4: block ends on a match");
+                }
+            }
+
+            return static_cast<size_t>(op - dst);
+        }
+
+        ASTRA_INLINE uint32_t lz4_hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG); }
+
+        // the number of equal bytes at `a` and `b`, `a` stops at `limit`.
+        ASTRA_INLINE size_t lz4_count(const uint8_t *a, const uint8_t *b, const uint8_t *limit) {
+            auto start = a;
+            while (limit - a >= 8) {
+                auto diff = lz4_load64(a) ^ lz4_load64(b);
+                if (diff != 0) {
+                    auto bits = std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff);
+                    return static_cast<size_t>(a - start) + bits / 8;
+                }
+                a += 8;
+                b += 8;
+            }
+
+            while (a < limit && *a == *b) {
+                ++a;
+                ++b;
+            }
+            return static_cast<size_t>(a - start);
+        }
+
+        ASTRA_INLINE uint8_t *lz4_write_length(uint8_t *op, size_t length) {
+            for (; length >= 255; length -= 255) {
+                *op++ = 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        // the most bytes a sequence with `literals` literals takes before its match length bytes.
+        ASTRA_INLINE size_t lz4_sequence_bytes(size_t literals) { return 1 + literals + (literals + 240) / 255 + 2; }
+
+        // writes one sequence, `match_length` 0 for the final literals. returns nullptr when it doesn't fit.
+        ASTRA_INLINE uint8_t *lz4_write_sequence(uint8_t *op, uint8_t *oend, const uint8_t *literals, size_t literal_count, size_t offset, size_t match_length) {
+            if (lz4_sequence_bytes(literal_count) + (match_length + 240) / 255 > static_cast<size_t>(oend - op)) {
+                return nullptr;
+            }
+
+            auto token = op++;
+            if (literal_count >= 15) {
+                *token = 15 << 4;
+                op     = lz4_write_length(op, literal_count - 15);
+            } else {
+                *token = static_cast<uint8_t>(literal_count << 4);
+            }
+
+            std::memcpy(op, literals, literal_count);
+            op += literal_count;
+            if (match_length == 0) {
+                return op;
+            }
+
+            lz4_store_le(op, static_cast<uint16_t>(offset));
+            op += 2;
+            match_length -= LZ4_MIN_MATCH;
+            if (match_length >= 15) {
+                *token |= 15;
+                op = lz4_write_length(op, match_length - 15);
+            } else {
+                *token |= static_cast<uint8_t>(match_length);
+            }
+            return op;
+        }
+
+        // compresses one independent block. returns the compressed size, or 0 when it doesn't fit into `capacity`.
+        inline size_t lz4_encode(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity, lz4_table_t &table) {
+            auto op     = dst;
+            auto oend   = dst + capacity;
+            auto anchor = src;
+            if (size == 0) {
+                // a lone token without literals, src may be nullptr here.
+                if (capacity == 0) {
+                    return 0;
+                }
+                *op = 0;
+                return 1;
+            }
+
+            if (size > LZ4_MATCH_LIMIT) {
+                auto ip          = src + 1;
+                auto match_start = src + size - LZ4_MATCH_LIMIT;
+                auto match_end   = src + size - LZ4_LAST_LITERALS;
+                auto attempts    = size_t{1} << LZ4_SKIP_TRIGGER;
+                table.fill(0);
+
+                while (ip <= match_start) {
+                    auto &slot = table[lz4_hash(lz4_load32(ip))];
+                    auto match = src + slot;
+                    slot       = static_cast<uint32_t>(ip - src);
+                    if (static_cast<size_t>(ip - match) > LZ4_MAX_OFFSET || lz4_load32(match) != lz4_load32(ip)) {
+                        ip += attempts++ >> LZ4_SKIP_TRIGGER;
+                        continue;
+                    }
+
+                    while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                        --ip;
+                        --match;
+                    }
+
+                    auto length = LZ4_MIN_MATCH + lz4_count(ip + LZ4_MIN_MATCH, match + LZ4_MIN_MATCH, match_end);
+                    op          = lz4_write_sequence(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - match), length);
+                    if (op == nullptr) {
+                        return 0;
+                    }
+
+                    ip += length;
+                    anchor   = ip;
+                    attempts = size_t{1} << LZ4_SKIP_TRIGGER;
+                    if (ip <= match_start) {
+                        table[lz4_hash(lz4_load32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+                    }
+                }
+            }
+
+            op = lz4_write_sequence(op, oend, anchor, static_cast<size_t>(src + size - anchor), 0, 0);
+            return op == nullptr ? 0 : static_cast<size_t>(op - dst);
+        }
+
+        struct lz4_block_t {
+            const uint8_t *data = nullptr;
+            uint32_t size       = 0;
+            bool raw            = false;
+            bool has_checksum   = false;
+            uint32_t checksum   = 0;
+        };
+
+        struct lz4_frame_t {
+            std::vector<lz4_block_t> blocks;
+            size_t block_max      = 0;
+            bool independent      = false;
+            bool has_size         = false;
+            uint64_t content_size = 0;
+            bool has_checksum     = false;
+            uint32_t checksum     = 0;
+        };
+
+        // walks the frames of `src` without decoding anything. skippable frames are dropped.
+        inline std::vector<lz4_frame_t> lz4_scan(std::span<const uint8_t> src) {
+            std::vector<lz4_frame_t> frames;
+            auto ip   = src.data();
+            auto iend = src.data() + src.size();
+            auto need = [&](size_t bytes) {
+                if (bytes > static_cast<size_t>(iend - ip)) {
+                    lz4_malformed("lz4: frame is truncated");
+                }
+            };
+
+            while (ip != iend) {
+                need(4);
+                auto magic = lz4_load_le<uint32_t>(ip);
+                ip += 4;
+                if ((magic & 0xFFFFFFF0) == LZ4_SKIPPABLE_MAGIC) {
+                    need(4);
+                    auto size = lz4_load_le<uint32_t>(ip);
+                    ip += 4;
+                    need(size);
+                    ip += size;
+                    continue;
+                }
+
+                if (magic == LZ4_LEGACY_MAGIC) {
+                    lz4_malformed("lz4: legacy frames are not supported");
+                }
+                if (magic != LZ4_MAGIC) {
+                    lz4_malformed("lz4: not an lz4 frame");
+                }
+
+                auto descriptor = ip;
+                need(3);
+                auto flags = ip[0];
+                auto bd    = ip[1];
+                if ((flags & 0xC0) != LZ4_FLAG_VERSION || (flags & 0x02) != 0 || (bd & 0x8F) != 0) {
+                    lz4_malformed("lz4: unsupported frame version or reserved bits set");
+                }
+                if ((flags & LZ4_FLAG_DICTIONARY) != 0) {
+                    lz4_malformed("lz4: frames with a dictionary are not supported");
+                }
+
+                auto id = (bd >> 4) & 7;
+                if (id < 4) {
+                    lz4_malformed("lz4: invalid block size");
+                }
+
+                lz4_frame_t frame;
+                frame.block_max   = size_t{1} << (8 + 2 * id);
+                frame.independent = (flags & LZ4_FLAG_INDEPENDENT) != 0;
+                frame.has_size    = (flags & LZ4_FLAG_CONTENT_SIZE) != 0;
+                ip += 2;
+                if (frame.has_size) {
+                    need(9);
+                    frame.content_size = lz4_load_le<uint64_t>(ip);
+                    ip += 8;
+                }
+
+                if (((hash::xxh32(descriptor, static_cast<size_t>(ip - descriptor)) >> 8) & 0xFF) != *ip) {
+                    lz4_malformed("lz4: frame header checksum mismatch");
+                }
+                ++ip;
+
+                for (;;) {
+                    need(4);
+                    auto header = lz4_load_le<uint32_t>(ip);
+                    ip += 4;
+                    if (header == 0) {
+                        break;
+                    }
+
+                    lz4_block_t block;
+                    block.raw  = (header & LZ4_RAW_BLOCK) != 0;
+                    block.size = header & ~LZ4_RAW_BLOCK;
+                    if (block.size > frame.block_max) {
+                        lz4_malformed("lz4: block is larger than the frame's block size");
+                    }
+
+                    need(block.size);
+                    block.data = ip;
+                    ip += block.size;
+                    if ((flags & LZ4_FLAG_BLOCK_CHECKSUM) != 0) {
+                        need(4);
+                        block.has_checksum = true;
+                        block.checksum     = lz4_load_le<uint32_t>(ip);
+                        ip += 4;
+                    }
+                    frame.blocks.push_back(block);
+                }
+
+                if ((flags & LZ4_FLAG_CONTENT_CHECKSUM) != 0) {
+                    need(4);
+                    frame.has_checksum = true;
+                    frame.checksum     = lz4_load_le<uint32_t>(ip);
+                    ip += 4;
+                }
+                frames.push_back(std::move(frame));
+            }
+
+            return frames;
+        }
+
+        inline size_t lz4_decode_block(const lz4_block_t &block, const uint8_t *window, uint8_t *dst, size_t capacity, bool verify) {
+            if (verify && block.has_checksum && hash::xxh32(block.data, block.size) != block.checksum) {
+                lz4_malformed("lz4: block checksum mismatch");
+            }
+
+            if (!block.raw) {
+                return lz4_decode(block.data, block.size, window, dst, capacity);
+            }
+
+            if (block.size > capacity) {
+                lz4_overflow();
+            }
+            if (block.size != 0) {
+                std::memcpy(dst, block.data, block.size);
+            }
+            return block.size;
+        }
+
+        inline void lz4_check_frame(const lz4_frame_t &frame, const uint8_t *data, size_t size, bool verify) {
+            if (frame.has_size && frame.content_size != size) {
+                lz4_malformed("lz4: decoded size doesn't match the frame's content size");
+            }
+            if (verify && frame.has_checksum && hash::xxh32(data, size) != frame.checksum) {
+                lz4_malformed("lz4: content checksum mismatch");
+            }
+        }
+
+        inline size_t lz4_decode_frame(const lz4_frame_t &frame, uint8_t *dst, size_t capacity, bool verify) {
+            size_t size = 0;
+            for (const auto &block : frame.blocks) {
+                auto out = dst + size;
+                size += lz4_decode_block(block, frame.independent ? out : dst, out, capacity - size, verify);
+            }
+
+            lz4_check_frame(frame, dst, size, verify);
+            return size;
+        }
+
+        inline size_t lz4_decode_sequential(const std::vector<lz4_frame_t> &frames, uint8_t *dst, size_t capacity, bool verify) {
+            size_t size = 0;
+            for (const auto &frame : frames) {
+                size += lz4_decode_frame(frame, dst + size, capacity - size, verify);
+            }
+            return size;
+        }
+
+        // a block of an independent frame, or a whole frame with linked blocks when `block` is SIZE_MAX.
+        struct lz4_job_t {
+            size_t frame = 0;
+            size_t block = 0;
+            size_t out   = 0;
+            size_t room  = 0;
+        };
+
+        inline size_t lz4_decode_parallel(const std::vector<lz4_frame_t> &frames, uint8_t *dst, size_t capacity, const lz4_decode_options_t &options) {
+            // provisional layout, every block but the last of a frame is full and frames without a content size
+            // reserve a full last block. the last frame gets whatever is left.
+            std::vector<lz4_job_t> jobs;
+            std::vector<size_t> frame_out(frames.size());
+            size_t out = 0;
+            for (size_t f = 0; f < frames.size(); ++f) {
+                const auto &frame = frames[f];
+                auto blocks       = frame.blocks.size();
+                auto reserve      = frame.has_size ? std::min<uint64_t>(frame.content_size, SIZE_MAX) : blocks * frame.block_max;
+                if (f + 1 == frames.size() && !frame.has_size) {
+                    reserve = capacity - out;
+                }
+                if (reserve > capacity - out || (blocks > 0 && (blocks - 1) * frame.block_max > reserve)) {
+                    return lz4_decode_sequential(frames, dst, capacity, options.verify_checksums);
+                }
+
+                frame_out[f] = out;
+                if (!frame.independent) {
+                    jobs.push_back({f, SIZE_MAX, out, reserve});
+                } else {
+                    for (size_t b = 0; b < blocks; ++b) {
+                        auto room = b + 1 == blocks ? reserve - b * frame.block_max : frame.block_max;
+                        jobs.push_back({f, b, out + b * frame.block_max, room});
+                    }
+                }
+                out += reserve;
+            }
+
+            std::vector<size_t> decoded(jobs.size());
+            std::atomic<bool> short_block = false;
+            parallel::for_each(
+                    jobs.size(),
+                    [&](size_t i) {
+                        const auto &job   = jobs[i];
+                        const auto &frame = frames[job.frame];
+                        auto at           = dst + job.out;
+                        if (job.block == SIZE_MAX) {
+                            decoded[i] = lz4_decode_frame(frame, at, job.room, options.verify_checksums);
+                            return;
+                        }
+
+                        decoded[i] = lz4_decode_block(frame.blocks[job.block], at, at, job.room, options.verify_checksums);
+                        if (job.block + 1 < frame.blocks.size() && decoded[i] != frame.block_max) {
+                            short_block.store(true, std::memory_order_relaxed);
+                        }
+                    },
+                    options.workers);
+
+            if (short_block.load(std::memory_order_relaxed)) {
+                return lz4_decode_sequential(frames, dst, capacity, options.verify_checksums);
+            }
+
+            // the decoded size of each frame. independent frames are checked once all of their blocks are done.
+            std::vector<size_t> frame_size(frames.size(), 0);
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                frame_size[jobs[i].frame] += decoded[i];
+            }
+
+            parallel::for_each(
+                    frames.size(),
+                    [&](size_t f) {
+                        if (frames[f].independent) {
+                            lz4_check_frame(frames[f], dst + frame_out[f], frame_size[f], options.verify_checksums);
+                        }
+                    },
+                    options.workers);
+
+            // close the gaps left by reservations that were too large.
+            size_t size = 0;
+            for (size_t f = 0; f < frames.size(); ++f) {
+                if (frame_out[f] != size) {
+                    std::memmove(dst + size, dst + frame_out[f], frame_size[f]);
+                }
+                size += frame_size[f];
+            }
+            return size;
+        }
+
+        // the most the frames can decode to, counted from their blocks and never from a header field alone: a stored
+        // block is its own size, a compressed one at most block_max and 255 bytes per input byte (a run length byte
+        // adds 255, nothing else adds more). a content size larger than that is corrupt, a smaller one is exact.
+        inline size_t lz4_decoded_bound(const std::vector<lz4_frame_t> &frames, size_t max_output) {
+            size_t size = 0;
+            for (const auto &frame : frames) {
+                uint64_t blocks = 0;
+                for (const auto &block : frame.blocks) {
+                    blocks += block.raw ? block.size : std::min<uint64_t>(frame.block_max, uint64_t(block.size) * 255);
+                }
+
+                if (frame.has_size && frame.content_size > blocks) {
+                    throw std::invalid_argument("lz4: content size is larger than the frame's blocks can decode to");
+                }
+
+                auto frame_size = frame.has_size ? frame.content_size : blocks;
+                if (frame_size > max_output - size) {
+                    throw std::out_of_range("lz4: decoded size exceeds max_output");
+                }
+                size += static_cast<size_t>(frame_size);
+            }
+            return size;
+        }
+    } // namespace detail
+
+    // the largest compressed size of a block of `size` bytes.
+    [[maybe_unused]] constexpr size_t lz4_compress_bound(size_t size) { return size + size / 255 + 16; }
+
+    // the largest size of a frame written by lz4_compress, blocks that don't shrink are stored as they are.
+    [[maybe_unused]] constexpr size_t lz4_frame_bound(size_t size, const lz4_frame_options_t &options = {}) {
+        auto block_max = size_t{1} << (8 + 2 * static_cast<size_t>(options.block_size));
+        auto blocks    = (size + block_max - 1) / block_max;
+        return 4 + 2 + 8 + 1 + blocks * (4 + 4) + size + 4 + 4;
+    }
+
+    // decodes one raw lz4 block into `dst` and returns the decoded size.
+    [[maybe_unused]] inline size_t lz4_decompress_block(std::span<const uint8_t> src, std::span<uint8_t> dst) {
+        return detail::lz4_decode(src.data(), src.size(), dst.data(), dst.data(), dst.size());
+    }
+
+    // compresses `src` into one raw lz4 block and returns its size. `dst` should hold lz4_compress_bound(src.size())
+    // bytes, anything smaller throws std::out_of_range if the block doesn't fit.
+    [[maybe_unused]] inline size_t lz4_compress_block(std::span<const uint8_t> src, std::span<uint8_t> dst) {
+        detail::lz4_table_t table;
+        auto size = detail::lz4_encode(src.data(), src.size(), dst.data(), dst.size(), table);
+        if (size == 0) {
+            throw std::out_of_range("lz4: destination is too small for the compressed block");
+        }
+        return size;
+    }
+
+    // decodes a sequence of lz4 frames, as written by the lz4 tool or lz4_compress, into `dst` and returns the decoded
+    // size.
+    [[maybe_unused]] inline size_t lz4_decompress(std::span<const uint8_t> src, std::span<uint8_t> dst, const lz4_decode_options_t &options = {}) {
+        auto frames = detail::lz4_scan(src);
+        if (options.workers == 1) {
+            return detail::lz4_decode_sequential(frames, dst.data(), dst.size(), options.verify_checksums);
+        }
+        return detail::lz4_decode_parallel(frames, dst.data(), dst.size(), options);
+    }
+
+    // the same into a new buffer, sized from the blocks that are actually present and never from the content size alone.
+    // frames without a content size make the buffer as large as their blocks allow and the result is a view of it.
+    // throws std::out_of_range instead of allocating more than options.max_output bytes.
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> lz4_decompress(const astra::mem::runtime_array<uint8_t> &src, const lz4_decode_options_t &options = {}) {
+        auto frames = detail::lz4_scan(src);
+        auto result = astra::mem::runtime_array<uint8_t>(nullptr, detail::lz4_decoded_bound(frames, options.max_output));
+        size_t size;
+        if (options.workers == 1) {
+            size = detail::lz4_decode_sequential(frames, result.data(), result.size(), options.verify_checksums);
+        } else {
+            size = detail::lz4_decode_parallel(frames, result.data(), result.size(), options);
+        }
+        return size == result.size() ? result : result.view(0, size);
+    }
+
+    // writes one lz4 frame of `src` with independent blocks to `dst`, which needs lz4_frame_bound(src.size()) bytes,
+    // and returns its size.
+    [[maybe_unused]] inline size_t lz4_compress(std::span<const uint8_t> src, std::span<uint8_t> dst, const lz4_frame_options_t &options = {}) {
+        if (dst.size() < lz4_frame_bound(src.size(), options)) {
+            throw std::out_of_range("lz4: destination is smaller than lz4_frame_bound");
+        }
+
+        auto op = dst.data();
+        detail::lz4_store_le(op, detail::LZ4_MAGIC);
+        op += 4;
+
+        auto descriptor = op;
+        *op++           = static_cast<uint8_t>(detail::LZ4_FLAG_VERSION | detail::LZ4_FLAG_INDEPENDENT | (options.block_checksum ? detail::LZ4_FLAG_BLOCK_CHECKSUM : 0) |
+                                     (options.content_size ? detail::LZ4_FLAG_CONTENT_SIZE : 0) | (options.content_checksum ? detail::LZ4_FLAG_CONTENT_CHECKSUM : 0));
+        *op++           = static_cast<uint8_t>(static_cast<uint8_t>(options.block_size) << 4);
+        if (options.content_size) {
+            detail::lz4_store_le(op, static_cast<uint64_t>(src.size()));
+            op += 8;
+        }
+        *op = static_cast<uint8_t>((hash::xxh32(descriptor, static_cast<size_t>(op - descriptor)) >> 8) & 0xFF);
+        ++op;
+
+        // every block is written to a slot as large as its worst case, then the slots are packed.
+        auto block_max = size_t{1} << (8 + 2 * static_cast<size_t>(options.block_size));
+        auto slot_size = 4 + block_max + 4;
+        auto blocks    = (src.size() + block_max - 1) / block_max;
+        auto base      = op;
+        std::vector<size_t> written(blocks);
+        parallel::for_each(
+                blocks,
+                [&](size_t i) {
+                    auto data   = src.data() + i * block_max;
+                    auto length = std::min(block_max, src.size() - i * block_max);
+                    auto slot   = base + i * slot_size;
+
+                    detail::lz4_table_t table;
+                    auto size = detail::lz4_encode(data, length, slot + 4, length - 1, table);
+                    if (size == 0) {
+                        std::memcpy(slot + 4, data, length);
+                        detail::lz4_store_le(slot, static_cast<uint32_t>(length) | detail::LZ4_RAW_BLOCK);
+                        size = length;
+                    } else {
+                        detail::lz4_store_le(slot, static_cast<uint32_t>(size));
+                    }
+
+                    if (options.block_checksum) {
+                        detail::lz4_store_le(slot + 4 + size, hash::xxh32(slot + 4, size));
+                        size += 4;
+                    }
+                    written[i] = 4 + size;
+                },
+                options.workers);
+
+        for (size_t i = 0; i < blocks; ++i) {
+            auto slot = base + i * slot_size;
+            if (slot != op) {
+                std::memmove(op, slot, written[i]);
+            }
+            op += written[i];
+        }
+
+        detail::lz4_store_le(op, uint32_t{0});
+        op += 4;
+        if (options.content_checksum) {
+            detail::lz4_store_le(op, hash::xxh32(src.data(), src.size()));
+            op += 4;
+        }
+        return static_cast<size_t>(op - dst.data());
+    }
+
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> lz4_compress(const astra::mem::runtime_array<uint8_t> &src, const lz4_frame_options_t &options = {}) {
+        auto result = astra::mem::runtime_array<uint8_t>(nullptr, lz4_frame_bound(src.size(), options));
+        return result.view(0, lz4_compress(src, result, options));
+    }
+} // namespace astra::io
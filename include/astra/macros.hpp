@@ -3,23 +3,38 @@
 // try to figure out how to force inlining.
 #ifndef ASTRA_INLINE
 #    ifdef WIN32
-#        define ASRTA_INLINE __forceinline
+#        define ASTRA_INLINE __forceinline
 #    else
-#        define ASRTA_INLINE __attribute__((always_inline))
+#        define ASTRA_INLINE inline __attribute__((always_inline))
 #    endif
 #endif
 
-// try to determine the alignment space of the current architectuire
+// try to determine the alignment space of the current architecture
 #ifdef __AVX__
 #    ifdef __AVX512F__
-#        define ASRTA_ALIGNMENT 64
+#        define ASTRA_ALIGNMENT 64
 #    else
 #        ifdef __AVX2__
-#            define ASRTA_ALIGNMENT 32
+#            define ASTRA_ALIGNMENT 32
 #        else
-#            define ASRTA_ALIGNMENT 16
+#            define ASTRA_ALIGNMENT 16
 #        endif
 #    endif
 #else
-#    define ASRTA_ALIGNMENT __STDCPP_DEFAULT_NEW_ALIGNMENT__
-#endif
\ No newline at end of file
+#    define ASTRA_ALIGNMENT __STDCPP_DEFAULT_NEW_ALIGNMENT__
+#endif
+
+// compile a single function for a newer instruction set than the rest of the translation unit.
+// callers are responsible for checking astra::cpu before calling it.
+#ifndef ASTRA_TARGET
+#    if defined(__GNUC__) || defined(__clang__)
+#        define ASTRA_TARGET(isa) __attribute__((target(isa)))
+#    else
+#        define ASTRA_TARGET(isa)
+#    endif
+#endif
+
+// x86 intrinsics are available, either globally or through ASTRA_TARGET.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    define ASTRA_X86 1
+#endif
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numbers>
+#include <stdexcept>
+#include <vector>
+
+#include "dds_layout.hpp"
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "pixel_convert.hpp"
+#include "runtime_array.hpp"
+
+#ifdef ASTRA_X86
+#    include <emmintrin.h>
+#endif
+
+// mip chain generation for uncompressed surfaces. every level is filtered from the one above it in linear rgba floats,
+// _SRGB formats are decoded to linear light first so averages come out gamma-correct. the filters are separable: each
+// destination pixel of an axis reads a window of consecutive source pixels with fixed weights, which also covers odd
+// sizes where a destination pixel spans 2.5 source pixels. a level is produced in bands of rows on a thread pool, each
+// band keeps a ring of horizontally filtered source rows so no row is filtered twice, decodes mip 0 a row at a time and
+// encodes every finished row while it is still in cache.
+
+namespace astra::gdx {
+    enum class mip_filter {
+        box,     // area average, the classic 2x2 mean for even sizes.
+        kaiser,  // kaiser windowed sinc, radius 3 and alpha 4. sharp with little ringing.
+        lanczos, // lanczos3, sharper than kaiser with a bit more ringing.
+    };
+
+    // what filters read past the edge of a surface. cube faces and atlases want clamp, tiling textures want wrap.
+    enum class mip_address { clamp, wrap };
+
+    struct mip_options_t {
+        mip_filter filter   = mip_filter::box;
+        mip_address address = mip_address::clamp;
+        uint32_t mip_count  = 0; // 0 builds the full chain down to 1x1.
+        size_t workers      = 0;
+    };
+
+    namespace detail {
+        // the taps of one axis. destination pixel i reads the `taps` consecutive source positions starting at start[i],
+        // which may lie past the edges, index[] holds them with the addressing mode applied. short windows are padded
+        // with zero weights.
+        struct mip_axis_t {
+            size_t taps = 0;
+            std::vector<int64_t> start;
+            std::vector<uint32_t> index;
+            std::vector<float> weight;
+        };
+
+        inline double mip_sinc(double x) {
+            if (std::abs(x) < 1e-9) {
+                return 1.0;
+            }
+            x *= std::numbers::pi;
+            return std::sin(x) / x;
+        }
+
+        // zeroth order modified bessel function of the first kind, the series converges quickly for the alphas used here.
+        inline double bessel_i0(double x) {
+            double sum  = 1.0;
+            double term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        inline constexpr double mip_filter_radius = 3.0;
+
+        inline double mip_kernel(mip_filter filter, double x) {
+            x = std::abs(x);
+            if (x >= mip_filter_radius) {
+                return 0.0;
+            }
+
+            if (filter == mip_filter::lanczos) {
+                return mip_sinc(x) * mip_sinc(x / mip_filter_radius);
+            }
+
+            constexpr double alpha = 4.0;
+            auto ratio             = x / mip_filter_radius;
+            return mip_sinc(x) * bessel_i0(alpha * std::sqrt(1.0 - ratio * ratio)) / bessel_i0(alpha);
+        }
+
+        inline uint32_t mip_address_index(int64_t index, uint32_t size, mip_address address) {
+            if (address == mip_address::wrap) {
+                return static_cast<uint32_t>(((index % size) + size) % size);
+            }
+            return static_cast<uint32_t>(std::clamp<int64_t>(index, 0, size - 1));
+        }
+
+        inline mip_axis_t make_mip_axis(uint32_t source, uint32_t target, mip_filter filter, mip_address address) {
+            auto scale = static_cast<double>(source) / target;
+            std::vector<int64_t> first(target);
+            std::vector<std::vector<double>> weights(target);
+
+            for (uint32_t i = 0; i < target; ++i) {
+                auto &list = weights[i];
+                if (filter == mip_filter::box) {
+                    // the share of each source pixel covered by [i * scale, (i + 1) * scale).
+                    auto from = i * scale;
+                    auto to   = (i + 1) * scale;
+                    first[i]  = static_cast<int64_t>(std::floor(from));
+                    for (auto j = first[i]; static_cast<double>(j) < to; ++j) {
+                        list.push_back(std::min<double>(to, j + 1) - std::max<double>(from, j));
+                    }
+                } else {
+                    // the kernel is stretched by the scale so it stays a low pass filter for the destination.
+                    auto center = (i + 0.5) * scale;
+                    auto radius = mip_filter_radius * scale;
+                    first[i]    = static_cast<int64_t>(std::floor(center - radius));
+                    for (auto j = first[i]; static_cast<double>(j) <= center + radius; ++j) {
+                        list.push_back(mip_kernel(filter, (j + 0.5 - center) / scale));
+                    }
+                }
+
+                while (!list.empty() && std::abs(list.back()) < 1e-9) {
+                    list.pop_back();
+                }
+                while (!list.empty() && std::abs(list.front()) < 1e-9) {
+                    list.erase(list.begin());
+                    first[i]++;
+                }
+            }
+
+            mip_axis_t axis;
+            for (auto &list : weights) {
+                axis.taps = std::max(axis.taps, list.size());
+            }
+
+            axis.start = first;
+            axis.index.resize(axis.taps * target);
+            axis.weight.resize(axis.taps * target);
+            for (uint32_t i = 0; i < target; ++i) {
+                double sum = 0.0;
+                for (auto weight : weights[i]) {
+                    sum += weight;
+                }
+
+                for (size_t t = 0; t < axis.taps; ++t) {
+                    auto slot         = i * axis.taps + t;
+                    axis.index[slot]  = mip_address_index(first[i] + static_cast<int64_t>(t), source, address);
+                    axis.weight[slot] = t < weights[i].size() ? static_cast<float>(weights[i][t] / sum) : 0.f;
+                }
+            }
+            return axis;
+        }
+
+        // one rgba float pixel per sse register.
+        inline void mip_filter_row(const float *src, const mip_axis_t &axis, uint32_t width, float *dst) {
+            auto index  = axis.index.data();
+            auto weight = axis.weight.data();
+            for (uint32_t x = 0; x < width; ++x, index += axis.taps, weight += axis.taps) {
+#ifdef ASTRA_X86
+                auto sum = _mm_setzero_ps();
+                for (size_t t = 0; t < axis.taps; ++t) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(src + index[t] * 4)));
+                }
+                _mm_storeu_ps(dst + x * 4, sum);
+#else
+                float sum[4] = {};
+                for (size_t t = 0; t < axis.taps; ++t) {
+                    for (size_t c = 0; c < 4; ++c) {
+                        sum[c] += weight[t] * src[index[t] * 4 + c];
+                    }
+                }
+                std::memcpy(dst + x * 4, sum, sizeof(sum));
+#endif
+            }
+        }
+
+        inline void mip_combine_rows(const float *const *rows, const float *weight, size_t taps, size_t floats, float *dst) {
+            size_t i = 0;
+#ifdef ASTRA_X86
+            for (; i + 4 <= floats; i += 4) {
+                auto sum = _mm_setzero_ps();
+                for (size_t t = 0; t < taps; ++t) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(rows[t] + i)));
+                }
+                _mm_storeu_ps(dst + i, sum);
+            }
+#endif
+            for (; i < floats; ++i) {
+                float sum = 0.f;
+                for (size_t t = 0; t < taps; ++t) {
+                    sum += weight[t] * rows[t][i];
+                }
+                dst[i] = sum;
+            }
+        }
+
+        // the rows of the level being filtered: rgba floats, or mip 0 in its own format which is decoded a row at a time
+        // so the top level never exists as floats in full.
+        struct mip_rows_t {
+            const uint8_t *data          = nullptr;
+            size_t pitch                 = 0;
+            const convert_plan_t *decode = nullptr; // nullptr when the rows already are rgba floats.
+
+            [[nodiscard]] const float *row(uint32_t y, uint32_t width, float *scratch) const {
+                auto bytes = data + y * pitch;
+                if (decode == nullptr) {
+                    return reinterpret_cast<const float *>(bytes);
+                }
+                convert_range(*decode, bytes, reinterpret_cast<uint8_t *>(scratch), width);
+                return scratch;
+            }
+        };
+
+        // filters one level into the next. the result is written as rgba floats to `dst`, for the level after it, and
+        // encoded to `encoded` through `encode` while each row is still in cache.
+        // a band of destination rows walks down the source with a ring of horizontally filtered rows, the windows of
+        // consecutive rows overlap so every source row is filtered once per band.
+        inline void mip_downsample(const mip_rows_t &src, uint32_t src_width, uint32_t src_height, float *dst, uint32_t dst_width, uint32_t dst_height, const convert_plan_t &encode, uint8_t *encoded, const mip_options_t &options) {
+            auto horizontal = make_mip_axis(src_width, dst_width, options.filter, options.address);
+            auto vertical   = make_mip_axis(src_height, dst_height, options.filter, options.address);
+            size_t floats   = static_cast<size_t>(dst_width) * 4;
+            auto ring_size  = static_cast<int64_t>(vertical.taps);
+
+            // at least a megabyte of output or 8 rows per band, so the rows shared with the neighbouring bands are a
+            // small part of the work. the ring itself is `taps` rows of destination width.
+            auto band  = std::max<size_t>(8, (size_t { 1 } << 20) / (floats * sizeof(float)));
+            auto bands = (dst_height + band - 1) / band;
+            parallel::for_each(
+                bands,
+                [&](size_t b) {
+                    std::vector<float> ring(vertical.taps * floats);
+                    std::vector<int64_t> held(vertical.taps, INT64_MIN);
+                    std::vector<float> decoded(src.decode != nullptr ? static_cast<size_t>(src_width) * 4 : 0);
+                    std::vector<const float *> inputs(vertical.taps);
+
+                    auto last = std::min<size_t>(dst_height, (b + 1) * band);
+                    for (auto y = b * band; y < last; ++y) {
+                        for (size_t t = 0; t < vertical.taps; ++t) {
+                            auto position = vertical.start[y] + static_cast<int64_t>(t);
+                            auto slot     = static_cast<size_t>(((position % ring_size) + ring_size) % ring_size);
+                            if (held[slot] != position) {
+                                auto row = src.row(vertical.index[y * vertical.taps + t], src_width, decoded.data());
+                                mip_filter_row(row, horizontal, dst_width, ring.data() + slot * floats);
+                                held[slot] = position;
+                            }
+                            inputs[t] = ring.data() + slot * floats;
+                        }
+
+                        auto out = dst + y * floats;
+                        mip_combine_rows(inputs.data(), vertical.weight.data() + y * vertical.taps, vertical.taps, floats, out);
+                        convert_range(encode, reinterpret_cast<const uint8_t *>(out), encoded + y * dst_width * encode.dst_bytes, dst_width);
+                    }
+                },
+                options.workers);
+        }
+    } // namespace detail
+
+    // the number of levels in a full chain down to 1x1.
+    [[maybe_unused]] inline uint32_t full_mip_count(uint32_t width, uint32_t height) { return static_cast<uint32_t>(std::bit_width(std::max<uint32_t>({width, height, 1}))); }
+
+    // formats that can be filtered, the uncompressed ones convert() reads and writes.
+    [[maybe_unused]] inline bool can_generate_mips(dxgi_format_t format) { return can_convert(format, dxgi_format_t::R32G32B32A32_FLOAT) && can_convert(dxgi_format_t::R32G32B32A32_FLOAT, format); }
+
+    // the layout generate_mips writes: `source` with `mip_count` levels, 0 for a full chain.
+    [[maybe_unused]] inline dds_layout mip_layout(const dds_layout &source, uint32_t mip_count = 0) {
+        auto full        = full_mip_count(source.width, source.height);
+        dds_layout result = source;
+        result.mip_count = mip_count == 0 ? full : std::min(mip_count, full);
+        result.build();
+        return result;
+    }
+
+    // builds the mip chain of every array slice and cube face. `payload` is laid out like `source`, only its mip 0
+    // surfaces are read and they are copied to the result unchanged. the result is laid out exactly like
+    // mip_layout(source, options.mip_count), ready to be written after mip_layout(...).header().
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> generate_mips(const dds_layout &source, const astra::mem::runtime_array<uint8_t> &payload, const mip_options_t &options = {}) {
+        using enum dxgi_format_t;
+        if (!can_generate_mips(source.format)) {
+            throw std::invalid_argument("format can't be filtered");
+        }
+
+        if (source.depth > 1) {
+            throw std::invalid_argument("volume textures are not supported");
+        }
+
+        if (payload.size() < source.payload_size) {
+            throw std::out_of_range("dds payload is smaller than its header describes");
+        }
+
+        auto target = mip_layout(source, options.mip_count);
+        astra::mem::runtime_array<uint8_t> result(nullptr, target.payload_size);
+
+        static const auto isa = detail::best_convert_isa();
+        auto decode           = detail::make_convert_plan(source.format, R32G32B32A32_FLOAT, isa);
+        auto encode           = detail::make_convert_plan(R32G32B32A32_FLOAT, source.format, isa);
+
+        std::vector<float> current;
+        std::vector<float> next;
+        for (uint32_t slice = 0; slice < target.array_size; ++slice) {
+            for (uint32_t face = 0; face < target.face_count; ++face) {
+                auto &base = source.subresource(0, slice, face);
+                std::memcpy(result.data() + target.subresource(0, slice, face).offset, payload.data() + base.offset, base.size);
+
+                detail::mip_rows_t rows = {payload.data() + base.offset, base.row_pitch, &decode};
+                for (uint32_t mip = 1; mip < target.mip_count; ++mip) {
+                    auto &above = target.subresource(mip - 1, slice, face);
+                    auto &level = target.subresource(mip, slice, face);
+                    next.resize(static_cast<size_t>(level.width) * level.height * 4);
+                    detail::mip_downsample(rows, above.width, above.height, next.data(), level.width, level.height, encode, result.data() + level.offset, options);
+
+                    std::swap(current, next);
+                    rows = {reinterpret_cast<const uint8_t *>(current.data()), static_cast<size_t>(level.width) * 16, nullptr};
+                }
+            }
+        }
+        return result;
+    }
+
+    // the same for a dds file's header and payload.
+    [[maybe_unused]] inline astra::mem::runtime_array<uint8_t> generate_mips(const dds10_t &header, const astra::mem::runtime_array<uint8_t> &payload, const mip_options_t &options = {}) { return generate_mips(dds_layout(header), payload, options); }
+} // namespace astra::gdx
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace astra::parallel {
+    // selects the threaded overload of a bulk operation, e.g. array.fill(parallel::par, value).
+    // astra's own tag rather than std::execution so that no parallel stl backend (tbb) has to be linked.
+    struct par_t {
+        explicit par_t() = default;
+    };
+
+    inline constexpr par_t par{};
+
+    // the number of workers used when a caller passes 0.
+    [[maybe_unused]] inline std::size_t default_workers() {
+        auto count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    // calls fn(i) for every i in [0, count) on up to `workers` threads, the calling thread is one of them.
+    // items are handed out one at a time so uneven work balances itself.
+    // the first exception thrown by fn stops the remaining items and is rethrown once every worker has exited.
+    template<typename F>
+    [[maybe_unused]] void for_each(std::size_t count, F &&fn, std::size_t workers = 0) {
+        if (workers == 0) {
+            workers = default_workers();
+        }
+
+        workers = std::min(workers, count);
+        if (workers <= 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> next = 0;
+        std::exception_ptr error      = nullptr;
+        std::mutex error_lock;
+
+        auto work = [&]() {
+            for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard lock(error_lock);
+                    if (error == nullptr) {
+                        error = std::current_exception();
+                    }
+                    next.store(count, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(workers - 1);
+            for (std::size_t i = 1; i < workers; ++i) {
+                threads.emplace_back(work);
+            }
+
+            work();
+        }
+
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // splits [0, count) into contiguous ranges of at least `grain` items and calls fn(begin, end) for each of them.
+    template<typename F>
+    [[maybe_unused]] void for_ranges(std::size_t count, std::size_t grain, F &&fn, std::size_t workers = 0) {
+        if (count == 0) {
+            return;
+        }
+
+        grain       = std::max<std::size_t>(grain, 1);
+        auto ranges = (count + grain - 1) / grain;
+        for_each(ranges, [&](std::size_t i) { fn(i * grain, std::min(count, (i + 1) * grain)); }, workers);
+    }
+} // namespace astra::parallel
@@ -0,0 +1,814 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "cpu_features.hpp"
+#include "dds_layout.hpp"
+#include "macros.hpp"
+#include "parallel.hpp"
+#include "runtime_array.hpp"
+
+#ifdef ASTRA_X86
+#    include <immintrin.h>
+#endif
+
+// conversion between uncompressed dxgi formats. a source is decoded to linear rgba floats and encoded into the
+// destination a tile at a time, so the floats never leave L1. R32G32B32A32_FLOAT on either side skips the tile, and
+// 8-bit to 8-bit conversions skip floats entirely: swizzles are byte shuffles, unorm <-> srgb goes through byte tables.
+// the avx2 kernels (with f16c for half floats) write the same bytes as the scalar ones: both run the same float
+// operations in the same order, round with the current rounding mode, and encode srgb through the same table.
+
+namespace astra::gdx {
+    namespace detail {
+        // turns `count` pixels into rgba floats, 16 bytes per pixel.
+        using pixel_decode_fn = void (*)(const uint8_t *src, size_t count, float *rgba);
+        // turns `count` rgba float pixels into the destination format.
+        using pixel_encode_fn = void (*)(const float *rgba, size_t count, uint8_t *dst);
+        // converts between two formats without going through floats.
+        using pixel_direct_fn = void (*)(const uint8_t *src, size_t count, uint8_t *dst);
+
+        // every kernel reads a pixel completely before writing it, so they work in place as long as the destination
+        // pixel isn't larger than the source pixel.
+        inline constexpr size_t pixel_tile = 256;
+
+        ASTRA_INLINE uint16_t pixel_load16(const uint8_t *bytes) {
+            uint16_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+
+        ASTRA_INLINE uint32_t pixel_load32(const uint8_t *bytes) {
+            uint32_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+
+        // rounds to nearest even like cvtps2dq does, without going through errno-aware libm calls.
+        ASTRA_INLINE int32_t round_to_int(float value) {
+#ifdef ASTRA_X86
+            return _mm_cvtss_si32(_mm_set_ss(value));
+#else
+            return static_cast<int32_t>(std::lrint(value));
+#endif
+        }
+
+        // matches vcvtph2ps bit for bit, nans are quieted.
+        inline float half_to_float(uint16_t half) {
+            uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+            uint32_t rest = half & 0x7FFFu;
+            if (rest >= 0x7C00u) {
+                return std::bit_cast<float>(sign | 0x7F800000u | (rest & 0x3FFu) << 13 | (rest > 0x7C00u ? 0x400000u : 0u));
+            }
+
+            if (rest < 0x400u) {
+                // denormals are mantissa * 2^-24, done in integer and exact float math so no denormal operand is touched.
+                return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(static_cast<float>(rest) * 0x1p-24f));
+            }
+
+            return std::bit_cast<float>(sign | ((rest << 13) + 0x38000000u));
+        }
+
+        // matches vcvtps2ph with round to nearest even bit for bit, nans are quieted and keep the top of their payload.
+        inline uint16_t float_to_half(float value) {
+            auto bits = std::bit_cast<uint32_t>(value);
+            auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+            bits &= 0x7FFFFFFFu;
+
+            if (bits >= 0x47800000u) {
+                if (bits > 0x7F800000u) {
+                    return static_cast<uint16_t>(sign | 0x7E00u | ((bits >> 13) & 0x3FFu));
+                }
+                return static_cast<uint16_t>(sign | 0x7C00u);
+            }
+
+            if (bits < 0x38800000u) {
+                // half denormals and zero, adding 0.5 lines the mantissa up and lets the fpu do the rounding.
+                auto shifted = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + 0.5f);
+                return static_cast<uint16_t>(sign | (shifted - 0x3F000000u));
+            }
+
+            auto odd = (bits >> 13) & 1u;
+            bits += 0xC8000FFFu + odd;
+            return static_cast<uint16_t>(sign | (bits >> 13));
+        }
+
+        // linear floats are encoded to srgb with a table of 104 line segments, an eighth of a binade each between 2^-13
+        // and 1. anything below 2^-13 encodes to 0. the segments are fitted to the curve, rounding included, and are
+        // within a fraction of a step of the exact result.
+        inline constexpr uint32_t srgb_min_bits = (127 - 13) << 23;
+        inline constexpr uint32_t srgb_max_bits = 0x3F7FFFFF;
+
+        struct srgb_tables_t {
+            float to_linear[256];       // srgb byte -> linear float.
+            uint32_t from_linear[104];  // segment bias << 16 | slope, see encode_srgb.
+            uint8_t unorm_to_srgb[256]; // the same bytes as decoding to float and encoding again.
+            uint8_t srgb_to_unorm[256];
+        };
+
+        // max then min with maxss/minss semantics: a nan becomes `low`. written with intrinsics on x86 so it stays
+        // branchless, the ternaries compile to a compare and jump there.
+        ASTRA_INLINE float clamp_float(float value, float low, float high) {
+#ifdef ASTRA_X86
+            return _mm_cvtss_f32(_mm_min_ss(_mm_max_ss(_mm_set_ss(value), _mm_set_ss(low)), _mm_set_ss(high)));
+#else
+            value = value > low ? value : low;
+            return value < high ? value : high;
+#endif
+        }
+
+        ASTRA_INLINE uint8_t encode_unorm8(float value) {
+            value = clamp_float(value, 0.f, 1.f);
+            return static_cast<uint8_t>(round_to_int(value * 255.f));
+        }
+
+        ASTRA_INLINE uint8_t encode_srgb(float value, const uint32_t *table) {
+            auto bits  = std::bit_cast<uint32_t>(clamp_float(value, std::bit_cast<float>(srgb_min_bits), std::bit_cast<float>(srgb_max_bits)));
+            auto entry = table[(bits - srgb_min_bits) >> 20];
+            auto bias  = (entry >> 16) << 9;
+            auto slope = entry & 0xFFFFu;
+            auto step  = (bits >> 12) & 0xFFu;
+            return static_cast<uint8_t>((bias + slope * step) >> 16);
+        }
+
+        inline srgb_tables_t make_srgb_tables() {
+            auto to_linear = [](double c) { return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4); };
+            auto to_srgb   = [](double x) { return x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055; };
+
+            srgb_tables_t tables = {};
+            for (size_t i = 0; i < 256; ++i) {
+                tables.to_linear[i] = static_cast<float>(to_linear(static_cast<double>(i) / 255.0));
+            }
+
+            // least squares over the 256 steps of each segment, sampled at the middle of each step.
+            for (uint32_t i = 0; i < 104; ++i) {
+                double x0 = std::bit_cast<float>(srgb_min_bits + (i << 20));
+                double x1 = std::bit_cast<float>(srgb_min_bits + ((i + 1) << 20));
+                double st = 0, sy = 0, stt = 0, sty = 0;
+                for (size_t t = 0; t < 256; ++t) {
+                    auto x = x0 + (x1 - x0) * (static_cast<double>(t) + 0.5) / 256.0;
+                    auto y = (to_srgb(x) * 255.0 + 0.5) * 65536.0;
+                    st += static_cast<double>(t);
+                    sy += y;
+                    stt += static_cast<double>(t * t);
+                    sty += static_cast<double>(t) * y;
+                }
+
+                auto slope = (256.0 * sty - st * sy) / (256.0 * stt - st * st);
+                auto bias  = (sy - slope * st) / 256.0;
+                auto b     = static_cast<uint32_t>(std::clamp(std::lround(bias / 512.0), 0l, 0xFFFFl));
+                auto s     = static_cast<uint32_t>(std::clamp(std::lround(slope), 0l, 0xFFFFl));
+                tables.from_linear[i] = b << 16 | s;
+            }
+
+            for (size_t i = 0; i < 256; ++i) {
+                tables.unorm_to_srgb[i] = encode_srgb(static_cast<float>(i) * (1.f / 255.f), tables.from_linear);
+                tables.srgb_to_unorm[i] = encode_unorm8(tables.to_linear[i]);
+            }
+            return tables;
+        }
+
+        inline const srgb_tables_t &srgb_tables() {
+            static const srgb_tables_t instance = make_srgb_tables();
+            return instance;
+        }
+
+        // formats that pack unorm channels into 16 or 32 bits. a channel with 0 bits reads as 1.0.
+        struct packed_layout_t {
+            uint32_t bytes;
+            uint32_t shift[4];
+            uint32_t bits[4];
+
+            [[nodiscard]] constexpr uint32_t mask(size_t c) const { return (1u << bits[c]) - 1; }
+
+            [[nodiscard]] constexpr float scale(size_t c) const { return bits[c] == 0 ? 0.f : 1.f / static_cast<float>(mask(c)); }
+        };
+
+        inline constexpr packed_layout_t r10g10b10a2_layout = {4, {0, 10, 20, 30}, {10, 10, 10, 2}};
+        inline constexpr packed_layout_t b5g6r5_layout      = {2, {11, 5, 0, 0}, {5, 6, 5, 0}};
+        inline constexpr packed_layout_t b4g4r4a4_layout    = {2, {8, 4, 0, 12}, {4, 4, 4, 4}};
+
+        inline void decode_rgba32f(const uint8_t *src, size_t count, float *rgba) { std::memmove(rgba, src, count * 16); }
+
+        inline void decode_rgba16f_scalar(const uint8_t *src, size_t count, float *rgba) {
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t c = 0; c < 4; ++c) {
+                    rgba[i * 4 + c] = half_to_float(pixel_load16(src + i * 8 + c * 2));
+                }
+            }
+        }
+
+        template<packed_layout_t layout>
+        void decode_packed_scalar(const uint8_t *src, size_t count, float *rgba) {
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t value = layout.bytes == 4 ? pixel_load32(src + i * 4) : pixel_load16(src + i * 2);
+                for (size_t c = 0; c < 4; ++c) {
+                    rgba[i * 4 + c] = layout.bits[c] == 0 ? 1.f : static_cast<float>((value >> layout.shift[c]) & layout.mask(c)) * layout.scale(c);
+                }
+            }
+        }
+
+        // the 11 and 10 bit floats are halves with fewer mantissa bits and no sign.
+        inline void decode_rg11b10f_scalar(const uint8_t *src, size_t count, float *rgba) {
+            for (size_t i = 0; i < count; ++i) {
+                auto value      = pixel_load32(src + i * 4);
+                rgba[i * 4 + 0] = half_to_float(static_cast<uint16_t>((value & 0x7FFu) << 4));
+                rgba[i * 4 + 1] = half_to_float(static_cast<uint16_t>(((value >> 11) & 0x7FFu) << 4));
+                rgba[i * 4 + 2] = half_to_float(static_cast<uint16_t>(((value >> 22) & 0x3FFu) << 5));
+                rgba[i * 4 + 3] = 1.f;
+            }
+        }
+
+        // three 9 bit mantissas share one exponent, value = mantissa * 2^(exponent - 24). the product is exact.
+        inline void decode_rgb9e5_scalar(const uint8_t *src, size_t count, float *rgba) {
+            for (size_t i = 0; i < count; ++i) {
+                auto value = pixel_load32(src + i * 4);
+                auto scale = std::bit_cast<float>(((value >> 27) + 103) << 23);
+                for (size_t c = 0; c < 3; ++c) {
+                    rgba[i * 4 + c] = static_cast<float>((value >> (9 * c)) & 0x1FFu) * scale;
+                }
+                rgba[i * 4 + 3] = 1.f;
+            }
+        }
+
+        template<bool bgra, bool srgb, bool opaque>
+        void decode_rgba8_scalar(const uint8_t *src, size_t count, float *rgba) {
+            const auto &tables = srgb_tables();
+            for (size_t i = 0; i < count; ++i) {
+                auto pixel = src + i * 4;
+                for (size_t c = 0; c < 3; ++c) {
+                    auto value      = pixel[bgra ? 2 - c : c];
+                    rgba[i * 4 + c] = srgb ? tables.to_linear[value] : static_cast<float>(value) * (1.f / 255.f);
+                }
+                rgba[i * 4 + 3] = opaque ? 1.f : static_cast<float>(pixel[3]) * (1.f / 255.f);
+            }
+        }
+
+        inline void encode_rgba32f(const float *rgba, size_t count, uint8_t *dst) { std::memmove(dst, rgba, count * 16); }
+
+        inline void encode_rgba16f_scalar(const float *rgba, size_t count, uint8_t *dst) {
+            for (size_t i = 0; i < count; ++i) {
+                uint16_t pixel[4];
+                for (size_t c = 0; c < 4; ++c) {
+                    pixel[c] = float_to_half(rgba[i * 4 + c]);
+                }
+                std::memcpy(dst + i * 8, pixel, sizeof(pixel));
+            }
+        }
+
+        template<bool bgra, bool srgb, bool opaque = false>
+        void encode_rgba8_scalar(const float *rgba, size_t count, uint8_t *dst) {
+            const auto &tables = srgb_tables();
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t pixel[4];
+                for (size_t c = 0; c < 3; ++c) {
+                    auto value             = rgba[i * 4 + c];
+                    pixel[bgra ? 2 - c : c] = srgb ? encode_srgb(value, tables.from_linear) : encode_unorm8(value);
+                }
+                pixel[3] = opaque ? uint8_t { 255 } : encode_unorm8(rgba[i * 4 + 3]);
+                std::memcpy(dst + i * 4, pixel, sizeof(pixel));
+            }
+        }
+
+        template<packed_layout_t layout>
+        void encode_packed_scalar(const float *rgba, size_t count, uint8_t *dst) {
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t value = 0;
+                for (size_t c = 0; c < 4; ++c) {
+                    if (layout.bits[c] != 0) {
+                        value |= static_cast<uint32_t>(round_to_int(clamp_float(rgba[i * 4 + c], 0.f, 1.f) * static_cast<float>(layout.mask(c)))) << layout.shift[c];
+                    }
+                }
+
+                if constexpr (layout.bytes == 4) {
+                    std::memcpy(dst + i * 4, &value, 4);
+                } else {
+                    auto half = static_cast<uint16_t>(value);
+                    std::memcpy(dst + i * 2, &half, 2);
+                }
+            }
+        }
+
+        // an unsigned float with a 5-bit exponent and `mantissa` bits, rounded to nearest even. negative values and -inf
+        // become 0 and finite values past the largest one clamp to it, like DirectXMath does.
+        template<uint32_t mantissa>
+        inline uint32_t float_to_small_float(float value) {
+            constexpr uint32_t drop     = 23 - mantissa;
+            constexpr uint32_t largest  = (142u << 23) | (((1u << mantissa) - 1) << drop);
+            constexpr uint32_t infinity = 0x1Fu << mantissa;
+
+            auto bits = std::bit_cast<uint32_t>(value);
+            if ((bits & 0x7F800000u) == 0x7F800000u) {
+                if ((bits & 0x7FFFFFu) != 0) {
+                    return infinity | ((1u << mantissa) - 1);
+                }
+                return (bits >> 31) != 0 ? 0 : infinity;
+            }
+
+            if ((bits >> 31) != 0 || bits == 0) {
+                return 0;
+            }
+
+            if (bits > largest) {
+                return (largest - (112u << 23)) >> drop;
+            }
+
+            if (bits < 0x38800000u) {
+                auto shift = 113 - (bits >> 23);
+                if (shift > 24) {
+                    return 0;
+                }
+                bits = (0x800000u | (bits & 0x7FFFFFu)) >> shift;
+            } else {
+                bits -= 112u << 23;
+            }
+            return (bits + (1u << (drop - 1)) - 1 + ((bits >> drop) & 1)) >> drop;
+        }
+
+        inline void encode_rg11b10f_scalar(const float *rgba, size_t count, uint8_t *dst) {
+            for (size_t i = 0; i < count; ++i) {
+                auto value = float_to_small_float<6>(rgba[i * 4]) | float_to_small_float<6>(rgba[i * 4 + 1]) << 11 | float_to_small_float<5>(rgba[i * 4 + 2]) << 22;
+                std::memcpy(dst + i * 4, &value, 4);
+            }
+        }
+
+        // the shared exponent comes from the largest channel, the other two lose precision. see the d3d11 spec.
+        inline void encode_rgb9e5_scalar(const float *rgba, size_t count, uint8_t *dst) {
+            constexpr float largest = 0x1.FFp15f; // 511/512 * 2^16
+            for (size_t i = 0; i < count; ++i) {
+                float channel[3];
+                for (size_t c = 0; c < 3; ++c) {
+                    channel[c] = clamp_float(rgba[i * 4 + c], 0.f, largest);
+                }
+
+                auto top      = std::max({channel[0], channel[1], channel[2]});
+                auto exponent = std::max(-16, static_cast<int>(std::bit_cast<uint32_t>(top) >> 23) - 127) + 16;
+                auto scale    = std::bit_cast<float>(static_cast<uint32_t>(151 - exponent) << 23); // 2^(24 - exponent)
+                if (static_cast<uint32_t>(top * scale + 0.5f) == 512) {
+                    exponent += 1;
+                    scale *= 0.5f;
+                }
+
+                uint32_t value = static_cast<uint32_t>(exponent) << 27;
+                for (size_t c = 0; c < 3; ++c) {
+                    value |= static_cast<uint32_t>(channel[c] * scale + 0.5f) << (9 * c);
+                }
+                std::memcpy(dst + i * 4, &value, 4);
+            }
+        }
+
+        // 8-bit rgba to 8-bit rgba with the same encoding: swap red and blue, force alpha for X formats.
+        template<bool swap, bool opaque>
+        void swizzle_rgba8_scalar(const uint8_t *src, size_t count, uint8_t *dst) {
+            for (size_t i = 0; i < count; ++i) {
+                auto pixel = pixel_load32(src + i * 4);
+                if constexpr (swap) {
+                    pixel = (pixel & 0xFF00FF00u) | (pixel >> 16 & 0xFFu) | (pixel & 0xFFu) << 16;
+                }
+                if constexpr (opaque) {
+                    pixel |= 0xFF000000u;
+                }
+                std::memcpy(dst + i * 4, &pixel, sizeof(pixel));
+            }
+        }
+
+        // 8-bit rgba between unorm and srgb, alpha is never srgb encoded.
+        template<bool swap, bool opaque, bool to_srgb>
+        void recode_rgba8(const uint8_t *src, size_t count, uint8_t *dst) {
+            const auto &tables = srgb_tables();
+            const auto *table  = to_srgb ? tables.unorm_to_srgb : tables.srgb_to_unorm;
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t pixel[4] = {table[src[i * 4]], table[src[i * 4 + 1]], table[src[i * 4 + 2]], opaque ? uint8_t { 255 } : src[i * 4 + 3]};
+                if constexpr (swap) {
+                    std::swap(pixel[0], pixel[2]);
+                }
+                std::memcpy(dst + i * 4, pixel, sizeof(pixel));
+            }
+        }
+
+#ifdef ASTRA_X86
+        // the avx2 kernels handle two pixels per 256-bit register and leave ragged tails to the scalar kernels.
+        ASTRA_TARGET("avx2,f16c") inline __m256i rgba8_swap_mask() { return _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15)); }
+
+        // both pixels of a 64-bit load broadcast to four lanes each.
+        ASTRA_TARGET("avx2,f16c") inline __m256i spread_pair(__m128i pair) { return _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(pair), _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1)); }
+
+        ASTRA_TARGET("avx2,f16c") inline __m256i encode_srgb_avx2(__m256 value, const uint32_t *table) {
+            value      = _mm256_min_ps(_mm256_max_ps(value, _mm256_castsi256_ps(_mm256_set1_epi32(srgb_min_bits))), _mm256_castsi256_ps(_mm256_set1_epi32(srgb_max_bits)));
+            auto bits  = _mm256_castps_si256(value);
+            auto index = _mm256_srli_epi32(_mm256_sub_epi32(bits, _mm256_set1_epi32(srgb_min_bits)), 20);
+            auto entry = _mm256_i32gather_epi32(reinterpret_cast<const int *>(table), index, 4);
+            auto bias  = _mm256_slli_epi32(_mm256_srli_epi32(entry, 16), 9);
+            auto slope = _mm256_and_si256(entry, _mm256_set1_epi32(0xFFFF));
+            auto step  = _mm256_and_si256(_mm256_srli_epi32(bits, 12), _mm256_set1_epi32(0xFF));
+            return _mm256_srli_epi32(_mm256_add_epi32(bias, _mm256_mullo_epi32(slope, step)), 16);
+        }
+
+        ASTRA_TARGET("avx2,f16c") inline void decode_rgba16f_avx2(const uint8_t *src, size_t count, float *rgba) {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                _mm256_storeu_ps(rgba + i * 4, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8))));
+            }
+
+            if (i < count) {
+                decode_rgba16f_scalar(src + i * 8, count - i, rgba + i * 4);
+            }
+        }
+
+        template<packed_layout_t layout>
+        ASTRA_TARGET("avx2,f16c") void decode_packed_avx2(const uint8_t *src, size_t count, float *rgba) {
+            auto shift = _mm256_setr_epi32(layout.shift[0], layout.shift[1], layout.shift[2], layout.shift[3], layout.shift[0], layout.shift[1], layout.shift[2], layout.shift[3]);
+            auto mask  = _mm256_setr_epi32(layout.mask(0), layout.mask(1), layout.mask(2), layout.mask(3), layout.mask(0), layout.mask(1), layout.mask(2), layout.mask(3));
+            auto scale = _mm256_setr_ps(layout.scale(0), layout.scale(1), layout.scale(2), layout.scale(3), layout.scale(0), layout.scale(1), layout.scale(2), layout.scale(3));
+            auto one   = _mm256_set1_ps(1.f);
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128i pair;
+                if constexpr (layout.bytes == 4) {
+                    pair = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i * 4));
+                } else {
+                    pair = _mm_cvtepu16_epi32(_mm_cvtsi32_si128(static_cast<int>(pixel_load32(src + i * 2))));
+                }
+
+                auto channels = _mm256_and_si256(_mm256_srlv_epi32(spread_pair(pair), shift), mask);
+                auto value    = _mm256_mul_ps(_mm256_cvtepi32_ps(channels), scale);
+                if constexpr (layout.bits[3] == 0) {
+                    value = _mm256_blend_ps(value, one, 0x88);
+                }
+                _mm256_storeu_ps(rgba + i * 4, value);
+            }
+
+            if (i < count) {
+                decode_packed_scalar<layout>(src + i * layout.bytes, count - i, rgba + i * 4);
+            }
+        }
+
+        // the channels are moved into half float layout and converted with f16c.
+        ASTRA_TARGET("avx2,f16c") inline void decode_rg11b10f_avx2(const uint8_t *src, size_t count, float *rgba) {
+            auto shift = _mm256_setr_epi32(0, 11, 22, 0, 0, 11, 22, 0);
+            auto mask  = _mm256_setr_epi32(0x7FF, 0x7FF, 0x3FF, 0, 0x7FF, 0x7FF, 0x3FF, 0);
+            auto align = _mm256_setr_epi32(4, 4, 5, 0, 4, 4, 5, 0);
+            auto one   = _mm256_setr_epi32(0, 0, 0, 0x3C00, 0, 0, 0, 0x3C00);
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                auto value  = spread_pair(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i * 4)));
+                auto halves = _mm256_or_si256(_mm256_sllv_epi32(_mm256_and_si256(_mm256_srlv_epi32(value, shift), mask), align), one);
+                auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(halves, halves), 0x08);
+                _mm256_storeu_ps(rgba + i * 4, _mm256_cvtph_ps(_mm256_castsi256_si128(packed)));
+            }
+
+            if (i < count) {
+                decode_rg11b10f_scalar(src + i * 4, count - i, rgba + i * 4);
+            }
+        }
+
+        ASTRA_TARGET("avx2,f16c") inline void decode_rgb9e5_avx2(const uint8_t *src, size_t count, float *rgba) {
+            auto shift = _mm256_setr_epi32(0, 9, 18, 0, 0, 9, 18, 0);
+            auto mask  = _mm256_set1_epi32(0x1FF);
+            auto bias  = _mm256_set1_epi32(103);
+            auto one   = _mm256_set1_ps(1.f);
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                auto value    = spread_pair(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i * 4)));
+                auto mantissa = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(value, shift), mask));
+                auto scale    = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_srli_epi32(value, 27), bias), 23));
+                _mm256_storeu_ps(rgba + i * 4, _mm256_blend_ps(_mm256_mul_ps(mantissa, scale), one, 0x88));
+            }
+
+            if (i < count) {
+                decode_rgb9e5_scalar(src + i * 4, count - i, rgba + i * 4);
+            }
+        }
+
+        template<bool bgra, bool srgb, bool opaque>
+        ASTRA_TARGET("avx2,f16c") void decode_rgba8_avx2(const uint8_t *src, size_t count, float *rgba) {
+            const auto &tables = srgb_tables();
+            auto scale         = _mm256_set1_ps(1.f / 255.f);
+            auto one           = _mm256_set1_ps(1.f);
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                auto pair = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i * 4));
+                if constexpr (bgra) {
+                    pair = _mm_shuffle_epi8(pair, _mm256_castsi256_si128(rgba8_swap_mask()));
+                }
+
+                auto bytes = _mm256_cvtepu8_epi32(pair);
+                auto value = _mm256_mul_ps(_mm256_cvtepi32_ps(bytes), scale);
+                if constexpr (srgb) {
+                    value = _mm256_blend_ps(_mm256_i32gather_ps(tables.to_linear, bytes, 4), value, 0x88);
+                }
+                if constexpr (opaque) {
+                    value = _mm256_blend_ps(value, one, 0x88);
+                }
+                _mm256_storeu_ps(rgba + i * 4, value);
+            }
+
+            if (i < count) {
+                decode_rgba8_scalar<bgra, srgb, opaque>(src + i * 4, count - i, rgba + i * 4);
+            }
+        }
+
+        ASTRA_TARGET("avx2,f16c") inline void encode_rgba16f_avx2(const float *rgba, size_t count, uint8_t *dst) {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 8), _mm256_cvtps_ph(_mm256_loadu_ps(rgba + i * 4), _MM_FROUND_TO_NEAREST_INT));
+            }
+
+            if (i < count) {
+                encode_rgba16f_scalar(rgba + i * 4, count - i, dst + i * 8);
+            }
+        }
+
+        // 8 pixels per iteration, the two pack steps interleave them so one permute puts them back in order.
+        template<bool bgra, bool srgb, bool opaque = false>
+        ASTRA_TARGET("avx2,f16c") void encode_rgba8_avx2(const float *rgba, size_t count, uint8_t *dst) {
+            const auto &tables = srgb_tables();
+            auto zero          = _mm256_setzero_ps();
+            auto one           = _mm256_set1_ps(1.f);
+            auto scale         = _mm256_set1_ps(255.f);
+            auto order         = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256i lanes[4];
+                for (size_t k = 0; k < 4; ++k) {
+                    auto value = _mm256_loadu_ps(rgba + (i + k * 2) * 4);
+                    lanes[k]   = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(value, zero), one), scale));
+                    if constexpr (srgb) {
+                        lanes[k] = _mm256_blend_epi32(encode_srgb_avx2(value, tables.from_linear), lanes[k], 0x88);
+                    }
+                }
+
+                auto words = _mm256_packus_epi16(_mm256_packus_epi32(lanes[0], lanes[1]), _mm256_packus_epi32(lanes[2], lanes[3]));
+                auto bytes = _mm256_permutevar8x32_epi32(words, order);
+                if constexpr (bgra) {
+                    bytes = _mm256_shuffle_epi8(bytes, rgba8_swap_mask());
+                }
+                if constexpr (opaque) {
+                    bytes = _mm256_or_si256(bytes, _mm256_set1_epi32(static_cast<int>(0xFF000000u)));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), bytes);
+            }
+
+            if (i < count) {
+                encode_rgba8_scalar<bgra, srgb, opaque>(rgba + i * 4, count - i, dst + i * 4);
+            }
+        }
+
+        template<bool swap, bool opaque>
+        ASTRA_TARGET("avx2,f16c") void swizzle_rgba8_avx2(const uint8_t *src, size_t count, uint8_t *dst) {
+            auto alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+                if constexpr (swap) {
+                    pixels = _mm256_shuffle_epi8(pixels, rgba8_swap_mask());
+                }
+                if constexpr (opaque) {
+                    pixels = _mm256_or_si256(pixels, alpha);
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), pixels);
+            }
+
+            if (i < count) {
+                swizzle_rgba8_scalar<swap, opaque>(src + i * 4, count - i, dst + i * 4);
+            }
+        }
+#endif
+
+        enum class convert_isa { scalar, avx2 };
+
+        inline convert_isa best_convert_isa() {
+#ifdef ASTRA_X86
+            auto &cpu = cpu::current();
+            if (cpu.avx2 && cpu.f16c) {
+                return convert_isa::avx2;
+            }
+#endif
+            return convert_isa::scalar;
+        }
+
+#ifdef ASTRA_X86
+#    define ASTRA_PIXEL_PICK(type, scalar_fn, avx2_fn) (isa == convert_isa::avx2 ? static_cast<type>(avx2_fn) : static_cast<type>(scalar_fn))
+#else
+#    define ASTRA_PIXEL_PICK(type, scalar_fn, avx2_fn) static_cast<type>(scalar_fn)
+#endif
+
+        // returns nullptr for formats that can't be converted from.
+        inline pixel_decode_fn pixel_decoder(dxgi_format_t format, [[maybe_unused]] convert_isa isa) {
+            using enum dxgi_format_t;
+            switch (format) {
+                case R32G32B32A32_FLOAT: return decode_rgba32f;
+                case R16G16B16A16_FLOAT: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_rgba16f_scalar, decode_rgba16f_avx2);
+                case R10G10B10A2_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_packed_scalar<r10g10b10a2_layout>, decode_packed_avx2<r10g10b10a2_layout>);
+                case R11G11B10_FLOAT: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_rg11b10f_scalar, decode_rg11b10f_avx2);
+                case R9G9B9E5_SHAREDEXP: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_rgb9e5_scalar, decode_rgb9e5_avx2);
+                case B5G6R5_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_packed_scalar<b5g6r5_layout>, decode_packed_avx2<b5g6r5_layout>);
+                case B4G4R4A4_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, decode_packed_scalar<b4g4r4a4_layout>, decode_packed_avx2<b4g4r4a4_layout>);
+                case R8G8B8A8_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<false, false, false>), (decode_rgba8_avx2<false, false, false>));
+                case R8G8B8A8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<false, true, false>), (decode_rgba8_avx2<false, true, false>));
+                case B8G8R8A8_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<true, false, false>), (decode_rgba8_avx2<true, false, false>));
+                case B8G8R8A8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<true, true, false>), (decode_rgba8_avx2<true, true, false>));
+                case B8G8R8X8_UNORM: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<true, false, true>), (decode_rgba8_avx2<true, false, true>));
+                case B8G8R8X8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_decode_fn, (decode_rgba8_scalar<true, true, true>), (decode_rgba8_avx2<true, true, true>));
+                default: return nullptr;
+            }
+        }
+
+        // returns nullptr for formats that can't be converted to.
+        inline pixel_encode_fn pixel_encoder(dxgi_format_t format, [[maybe_unused]] convert_isa isa) {
+            using enum dxgi_format_t;
+            switch (format) {
+                case R32G32B32A32_FLOAT: return encode_rgba32f;
+                case R16G16B16A16_FLOAT: return ASTRA_PIXEL_PICK(pixel_encode_fn, encode_rgba16f_scalar, encode_rgba16f_avx2);
+                case R8G8B8A8_UNORM: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<false, false>), (encode_rgba8_avx2<false, false>));
+                case R8G8B8A8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<false, true>), (encode_rgba8_avx2<false, true>));
+                case B8G8R8A8_UNORM: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<true, false>), (encode_rgba8_avx2<true, false>));
+                case B8G8R8A8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<true, true>), (encode_rgba8_avx2<true, true>));
+                case B8G8R8X8_UNORM: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<true, false, true>), (encode_rgba8_avx2<true, false, true>));
+                case B8G8R8X8_UNORM_SRGB: return ASTRA_PIXEL_PICK(pixel_encode_fn, (encode_rgba8_scalar<true, true, true>), (encode_rgba8_avx2<true, true, true>));
+                // the packed formats only have scalar encoders, they are written once per mip level rather than per frame.
+                case R10G10B10A2_UNORM: return encode_packed_scalar<r10g10b10a2_layout>;
+                case R11G11B10_FLOAT: return encode_rg11b10f_scalar;
+                case R9G9B9E5_SHAREDEXP: return encode_rgb9e5_scalar;
+                case B5G6R5_UNORM: return encode_packed_scalar<b5g6r5_layout>;
+                case B4G4R4A4_UNORM: return encode_packed_scalar<b4g4r4a4_layout>;
+                default: return nullptr;
+            }
+        }
+
+        struct rgba8_kind_t {
+            bool valid  = false;
+            bool bgra   = false;
+            bool srgb   = false;
+            bool opaque = false;
+        };
+
+        inline rgba8_kind_t rgba8_kind(dxgi_format_t format) {
+            using enum dxgi_format_t;
+            switch (format) {
+                case R8G8B8A8_UNORM: return {true, false, false, false};
+                case R8G8B8A8_UNORM_SRGB: return {true, false, true, false};
+                case B8G8R8A8_UNORM: return {true, true, false, false};
+                case B8G8R8A8_UNORM_SRGB: return {true, true, true, false};
+                case B8G8R8X8_UNORM: return {true, true, false, true};
+                case B8G8R8X8_UNORM_SRGB: return {true, true, true, true};
+                default: return {};
+            }
+        }
+
+        template<bool swap, bool opaque>
+        inline pixel_direct_fn swizzle_kernel([[maybe_unused]] convert_isa isa) { return ASTRA_PIXEL_PICK(pixel_direct_fn, (swizzle_rgba8_scalar<swap, opaque>), (swizzle_rgba8_avx2<swap, opaque>)); }
+
+        template<bool swap, bool opaque>
+        inline pixel_direct_fn recode_kernel(bool to_srgb) { return to_srgb ? recode_rgba8<swap, opaque, true> : recode_rgba8<swap, opaque, false>; }
+
+        // returns nullptr when the conversion has to go through floats.
+        inline pixel_direct_fn pixel_direct(dxgi_format_t from, dxgi_format_t to, convert_isa isa) {
+            auto src = rgba8_kind(from);
+            auto dst = rgba8_kind(to);
+            if (!src.valid || !dst.valid) {
+                return nullptr;
+            }
+
+            auto swap   = src.bgra != dst.bgra;
+            auto opaque = src.opaque || dst.opaque;
+            if (src.srgb == dst.srgb) {
+                return swap ? (opaque ? swizzle_kernel<true, true>(isa) : swizzle_kernel<true, false>(isa)) : (opaque ? swizzle_kernel<false, true>(isa) : swizzle_kernel<false, false>(isa));
+            }
+            return swap ? (opaque ? recode_kernel<true, true>(dst.srgb) : recode_kernel<true, false>(dst.srgb)) : (opaque ? recode_kernel<false, true>(dst.srgb) : recode_kernel<false, false>(dst.srgb));
+        }
+
+#undef ASTRA_PIXEL_PICK
+
+        // how one pair of formats is converted, resolved once per call.
+        struct convert_plan_t {
+            dxgi_format_t from      = dxgi_format_t::UNKNOWN;
+            dxgi_format_t to        = dxgi_format_t::UNKNOWN;
+            size_t src_bytes        = 0;
+            size_t dst_bytes        = 0;
+            pixel_direct_fn direct  = nullptr;
+            pixel_decode_fn decode  = nullptr;
+            pixel_encode_fn encode  = nullptr;
+        };
+
+        inline convert_plan_t make_convert_plan(dxgi_format_t from, dxgi_format_t to, convert_isa isa) {
+            convert_plan_t plan = {from, to, format_info(from).bits_per_pixel / 8u, format_info(to).bits_per_pixel / 8u};
+            plan.decode         = pixel_decoder(from, isa);
+            plan.encode         = pixel_encoder(to, isa);
+            plan.direct         = pixel_direct(from, to, isa);
+            return plan;
+        }
+
+        // converts one contiguous run of pixels on the calling thread.
+        inline void convert_range(const convert_plan_t &plan, const uint8_t *src, uint8_t *dst, size_t count) {
+            using enum dxgi_format_t;
+            if (plan.from == plan.to) {
+                if (src != dst) {
+                    std::memmove(dst, src, count * plan.src_bytes);
+                }
+                return;
+            }
+
+            if (plan.direct != nullptr) {
+                plan.direct(src, count, dst);
+                return;
+            }
+
+            if (plan.to == R32G32B32A32_FLOAT) {
+                plan.decode(src, count, reinterpret_cast<float *>(dst));
+                return;
+            }
+
+            if (plan.from == R32G32B32A32_FLOAT) {
+                plan.encode(reinterpret_cast<const float *>(src), count, dst);
+                return;
+            }
+
+            alignas(32) float tile[pixel_tile * 4];
+            for (size_t i = 0; i < count; i += pixel_tile) {
+                auto n = std::min(pixel_tile, count - i);
+                plan.decode(src + i * plan.src_bytes, n, tile);
+                plan.encode(tile, n, dst + i * plan.dst_bytes);
+            }
+        }
+    } // namespace detail
+
+    [[maybe_unused]] inline bool can_convert(dxgi_format_t from, dxgi_format_t to) { return detail::pixel_decoder(from, detail::convert_isa::scalar) != nullptr && detail::pixel_encoder(to, detail::convert_isa::scalar) != nullptr; }
+
+    // converts `pixel_count` pixels from one uncompressed format to another, runs of pixels are split across `workers` threads.
+    // formats: R32G32B32A32_FLOAT, R16G16B16A16_FLOAT, R10G10B10A2_UNORM, R11G11B10_FLOAT, R9G9B9E5_SHAREDEXP,
+    // B5G6R5_UNORM, B4G4R4A4_UNORM and the 8-bit RGBA, BGRA and BGRX formats, in either direction. the conversions to
+    // the packed formats are scalar, everything else has avx2 kernels.
+    // src and dst may be the same buffer when a destination pixel is not larger than a source pixel, other overlaps throw.
+    // float formats are linear, _SRGB formats are decoded and encoded with the srgb curve. float buffers must be 4-byte aligned.
+    [[maybe_unused]] inline void convert(dxgi_format_t from, dxgi_format_t to, const uint8_t *src, uint8_t *dst, size_t pixel_count, size_t workers = 0) {
+        static const auto isa = detail::best_convert_isa();
+        if (!can_convert(from, to)) {
+            throw std::invalid_argument("unsupported pixel format conversion");
+        }
+
+        auto plan = detail::make_convert_plan(from, to, isa);
+        if (pixel_count == 0) {
+            return;
+        }
+
+        // roughly 256k to 1m of source per task.
+        constexpr size_t grain = 1 << 16;
+        auto src_end           = src + pixel_count * plan.src_bytes;
+        auto dst_end           = dst + pixel_count * plan.dst_bytes;
+        if (src >= dst_end || dst >= src_end) {
+            parallel::for_ranges(pixel_count, grain, [&](size_t first, size_t last) { detail::convert_range(plan, src + first * plan.src_bytes, dst + first * plan.dst_bytes, last - first); }, workers);
+            return;
+        }
+
+        if (src != dst || plan.dst_bytes > plan.src_bytes) {
+            throw std::invalid_argument("overlapping conversion must be in place and must not grow pixels");
+        }
+
+        // in place with smaller pixels runs in waves: the wave [done, end) writes below done * src_bytes, which holds no
+        // unread source pixels, so its ranges can run in parallel. each wave is src_bytes / dst_bytes times the last one.
+        size_t done = plan.dst_bytes == plan.src_bytes ? 0 : std::min(pixel_count, grain);
+        detail::convert_range(plan, src, dst, done);
+        while (done < pixel_count) {
+            auto end = plan.dst_bytes == plan.src_bytes ? pixel_count : std::min(pixel_count, done * plan.src_bytes / plan.dst_bytes);
+            parallel::for_ranges(end - done, grain, [&](size_t first, size_t last) { detail::convert_range(plan, src + (done + first) * plan.src_bytes, dst + (done + first) * plan.dst_bytes, last - first); }, workers);
+            done = end;
+        }
+    }
+
+    // converts a buffer of pixels in place. the array becomes a view of the converted pixels when they are not larger,
+    // larger pixels need a new buffer which replaces the array.
+    [[maybe_unused]] inline void convert(dxgi_format_t from, dxgi_format_t to, astra::mem::runtime_array<uint8_t> &pixels, size_t workers = 0) {
+        if (!can_convert(from, to)) {
+            throw std::invalid_argument("unsupported pixel format conversion");
+        }
+
+        auto src_bytes = format_info(from).bits_per_pixel / 8u;
+        auto dst_bytes = format_info(to).bits_per_pixel / 8u;
+        if (pixels.size() % src_bytes != 0) {
+            throw std::invalid_argument("buffer is not a whole number of pixels");
+        }
+
+        auto count = pixels.size() / src_bytes;
+        if (dst_bytes <= src_bytes) {
+            convert(from, to, pixels.data(), pixels.data(), count, workers);
+            pixels = pixels.view(0, count * dst_bytes);
+            return;
+        }
+
+        astra::mem::runtime_array<uint8_t> result(nullptr, count * dst_bytes);
+        convert(from, to, pixels.data(), result.data(), count, workers);
+        pixels = std::move(result);
+    }
+} // namespace astra::gdx
@@ -1,72 +1,211 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <compare>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <ranges>
+#include <span>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "allocator.hpp"
+#include "instrument.hpp"
 #include "macros.hpp"
+#include "parallel.hpp"
 
 namespace astra::mem {
+    namespace detail {
+        // the smallest piece of a bulk operation worth handing to another thread.
+        template<typename T>
+        constexpr std::size_t parallel_grain() {
+            return std::max<std::size_t>((1 << 20) / sizeof(T), 1);
+        }
+
+        // byte values go through memset. other trivially copyable values are written once and then doubled with memcpy
+        // up to a 16 KB pattern, which is repeated from cache. both are vectorized by the c library.
+        template<typename T>
+        void fill_n(T *dst, std::size_t count, const T &value) {
+            if (count == 0) {
+                return;
+            }
+
+            if constexpr (!std::is_trivially_copyable_v<T>) {
+                std::fill_n(dst, count, value);
+            } else if constexpr (sizeof(T) == 1) {
+                std::memset(dst, std::bit_cast<uint8_t>(value), count);
+            } else {
+                auto bytes = reinterpret_cast<uint8_t *>(dst);
+                auto total = count * sizeof(T);
+                std::memcpy(bytes, &value, sizeof(T));
+                std::size_t filled = sizeof(T), pattern = sizeof(T);
+                while (filled < total) {
+                    auto chunk = std::min(pattern, total - filled);
+                    std::memcpy(bytes + filled, bytes, chunk);
+                    filled += chunk;
+                    if (pattern < (16 << 10)) {
+                        pattern = filled;
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        bool equal_n(const T *a, const T *b, std::size_t count) {
+            if constexpr (std::has_unique_object_representations_v<T>) {
+                return count == 0 || std::memcmp(a, b, count * sizeof(T)) == 0;
+            } else {
+                return std::equal(a, a + count, b);
+            }
+        }
+    } // namespace detail
+
     template<typename T>
     class runtime_array {
+        template<typename U>
+        friend class runtime_array;
+
     public:
         std::shared_ptr<T[]> ptr = nullptr;
         std::size_t length       = 0;
 
-        struct Iterator {
+        // a plain pointer underneath, so algorithms over runtime_array lower to memmove/memset and vector loops.
+        template<bool constant>
+        struct BasicIterator {
         public:
-            using iterator_category [[maybe_unused]] = std::forward_iterator_tag;
-            using difference_type [[maybe_unused]]   = std::ptrdiff_t;
-            using value_type                         = T;
-            using pointer                            = value_type *;
-            using reference                          = value_type &;
-
-            explicit Iterator(pointer ptr) : array_ptr(ptr) { }
+            using iterator_concept [[maybe_unused]]  = std::contiguous_iterator_tag;
+            using iterator_category [[maybe_unused]] = std::random_access_iterator_tag;
+            using difference_type                    = std::ptrdiff_t;
+            using value_type                         = std::remove_cv_t<T>;
+            using element_type                       = std::conditional_t<constant, const T, T>;
+            using pointer                            = element_type *;
+            using reference                          = element_type &;
+
+            BasicIterator() = default;
+
+            explicit BasicIterator(pointer ptr) : array_ptr(ptr) { }
+
+            operator BasicIterator<true>() const // NOLINT(google-explicit-constructor)
+                requires(!constant)
+            {
+                return BasicIterator<true>(array_ptr);
+            }
 
             reference operator*() const { return *array_ptr; }
 
-            pointer operator->() { return array_ptr; }
+            pointer operator->() const { return array_ptr; }
 
-            Iterator &operator++() {
+            reference operator[](difference_type index) const { return array_ptr[index]; }
+
+            BasicIterator &operator++() {
                 array_ptr++;
                 return *this;
             }
 
-            Iterator operator++(int) { // NOLINT(cert-dcl21-cpp)
-                Iterator tmp = *this;
+            BasicIterator operator++(int) { // NOLINT(cert-dcl21-cpp)
+                BasicIterator tmp = *this;
                 ++(*this);
                 return tmp;
             }
 
-            friend bool operator==(const Iterator &a, const Iterator &b) { return a.array_ptr == b.array_ptr; };
+            BasicIterator &operator--() {
+                array_ptr--;
+                return *this;
+            }
 
-            friend bool operator!=(const Iterator &a, const Iterator &b) { return a.array_ptr != b.array_ptr; };
+            BasicIterator operator--(int) { // NOLINT(cert-dcl21-cpp)
+                BasicIterator tmp = *this;
+                --(*this);
+                return tmp;
+            }
+
+            BasicIterator &operator+=(difference_type count) {
+                array_ptr += count;
+                return *this;
+            }
+
+            BasicIterator &operator-=(difference_type count) {
+                array_ptr -= count;
+                return *this;
+            }
+
+            friend BasicIterator operator+(BasicIterator it, difference_type count) { return it += count; }
+
+            friend BasicIterator operator+(difference_type count, BasicIterator it) { return it += count; }
+
+            friend BasicIterator operator-(BasicIterator it, difference_type count) { return it -= count; }
+
+            friend difference_type operator-(const BasicIterator &a, const BasicIterator &b) { return a.array_ptr - b.array_ptr; }
+
+            friend bool operator==(const BasicIterator &a, const BasicIterator &b) { return a.array_ptr == b.array_ptr; }
+
+            friend auto operator<=>(const BasicIterator &a, const BasicIterator &b) { return a.array_ptr <=> b.array_ptr; }
 
         private:
-            pointer array_ptr;
+            pointer array_ptr = nullptr;
         };
 
+        using Iterator      = BasicIterator<false>;
+        using ConstIterator = BasicIterator<true>;
+
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator        = Iterator;
+        using const_iterator  = ConstIterator;
+
     private:
+        // byte offset from ptr to the first element, non-zero for views.
         std::size_t offset = 0;
 
         void alloc(size_t size) {
+            offset = 0;
+
+            if (auto &source = current_allocator(); source != nullptr) {
+                auto buffer = static_cast<T *>(source->allocate(size * sizeof(T)));
+                std::uninitialized_default_construct_n(buffer, size);
+                ptr = std::shared_ptr<T[]>(buffer, [size, source](T *p) {
+                    ASTRA_MEM_RECORD(T, release, size * sizeof(T));
+                    std::destroy_n(p, size);
+                    source->deallocate(p, size * sizeof(T));
+                });
+                ASTRA_MEM_RECORD(T, allocate, size * sizeof(T));
+                return;
+            }
+
 #ifdef WIN32
-            if (sizeof(T) <= ASTRA_ALIGNMENT || sizeof(T) % 2 == 0) {
-                ptr = std::make_shared<T[]>(size + (ASTRA_ALIGNMENT / sizeof(T)) + 1);
-                if (!is_aligned()) {
-                    offset = ASTRA_ALIGNMENT - (reinterpret_cast<intptr_t>(this->ptr.get()) % ASTRA_ALIGNMENT);
-                }
-            } else {
-                ptr = std::make_shared<T[]>(size);
+            auto count = sizeof(T) <= ASTRA_ALIGNMENT || sizeof(T) % 2 == 0 ? size + (ASTRA_ALIGNMENT / sizeof(T)) + 1 : size;
+#    ifdef ASTRA_INSTRUMENT
+            // make_shared has nowhere to report the release from.
+            ptr = std::shared_ptr<T[]>(new T[count](), [count](T *p) {
+                ASTRA_MEM_RECORD(T, release, count * sizeof(T));
+                delete[] p;
+            });
+#    else
+            ptr = std::make_shared<T[]>(count);
+#    endif
+            if (count != size && !is_aligned()) {
+                offset = ASTRA_ALIGNMENT - (reinterpret_cast<intptr_t>(this->ptr.get()) % ASTRA_ALIGNMENT);
             }
+            ASTRA_MEM_RECORD(T, allocate, count * sizeof(T));
 #else
-            ptr = std::shared_ptr<T[]>(new (std::align_val_t(ASTRA_ALIGNMENT)) T[size]);
+            auto buffer = static_cast<T *>(::operator new[](size * sizeof(T), std::align_val_t(ASTRA_ALIGNMENT)));
+            std::uninitialized_default_construct_n(buffer, size);
+            ptr = std::shared_ptr<T[]>(buffer, [size](T *p) {
+                ASTRA_MEM_RECORD(T, release, size * sizeof(T));
+                std::destroy_n(p, size);
+                ::operator delete[](p, std::align_val_t(ASTRA_ALIGNMENT));
+            });
+            ASTRA_MEM_RECORD(T, allocate, size * sizeof(T));
 #endif
         }
 
@@ -81,20 +220,27 @@ namespace astra::mem {
             alloc(size);
 
             if (ptr != nullptr) {
+                ASTRA_MEM_RECORD(T, copy, byte_size());
                 std::copy_n(ptr, length, data());
             }
         }
 
-        [[maybe_unused]] runtime_array(T *ptr, std::size_t size, const T &default_value) : runtime_array(ptr, size) {
-            for (auto i = 0; i < length; ++i) {
-                ptr[i] = default_value;
-            }
-        }
+        // view constructor, shares storage with whoever else owns it. no data is copied.
+        runtime_array(std::shared_ptr<T[]> storage, std::size_t byte_offset, std::size_t size) : ptr(std::move(storage)), length(size), offset(byte_offset) { }
+
+        [[maybe_unused]] runtime_array(T *ptr, std::size_t size, const T &default_value) : runtime_array(ptr, size) { fill(default_value); }
+
+        // wraps memory owned by someone else without copying it, the caller keeps it alive for as long as the array
+        // and its views are used.
+        [[maybe_unused]] explicit runtime_array(std::span<T> values) : runtime_array(std::shared_ptr<T[]>(std::shared_ptr<T[]>(), values.data()), 0, values.size()) { }
+
+        // the same, but the array holds on to `owner` (a vector in a shared_ptr, a mapping, ...) to keep the memory alive.
+        [[maybe_unused]] runtime_array(std::span<T> values, const std::shared_ptr<const void> &owner) : runtime_array(std::shared_ptr<T[]>(owner, values.data()), 0, values.size()) { }
 
     public:
         ASTRA_INLINE T *data() const { return reinterpret_cast<T *>(reinterpret_cast<intptr_t>(ptr.get()) + offset); }
 
-        [[nodiscard]] ASTRA_INLINE bool is_aligned() const { return reinterpret_cast<intptr_t>(ptr.get() + offset) % ASTRA_ALIGNMENT; }
+        [[nodiscard]] ASTRA_INLINE bool is_aligned() const { return reinterpret_cast<intptr_t>(data()) % ASTRA_ALIGNMENT == 0; }
 
         [[nodiscard]] ASTRA_INLINE std::size_t size() const { return length; }
 
@@ -108,10 +254,45 @@ namespace astra::mem {
 
         Iterator end() const { return Iterator(data() + size()); }
 
-        [[maybe_unused]] void fill(const T &default_value) {
-            for (auto i = 0; i < length; ++i) {
-                ptr[i] = default_value;
+        [[maybe_unused]] ConstIterator cbegin() const { return ConstIterator(data()); }
+
+        [[maybe_unused]] ConstIterator cend() const { return ConstIterator(data() + size()); }
+
+        // runtime_array is a contiguous range, so it also converts to std::span<T> and std::span<const T> implicitly.
+        [[maybe_unused]] std::span<T> span() const { return {data(), size()}; }
+
+        [[maybe_unused]] void fill(const T &default_value) { detail::fill_n(data(), size(), default_value); }
+
+        // the same, split over up to `workers` threads for large arrays.
+        [[maybe_unused]] void fill(parallel::par_t, const T &default_value, std::size_t workers = 0) {
+            parallel::for_ranges(size(), detail::parallel_grain<T>(), [&](std::size_t first, std::size_t last) { detail::fill_n(data() + first, last - first, default_value); }, workers);
+        }
+
+        // element-wise equality, a memcmp when T has no padding or other bytes that don't take part in ==.
+        [[maybe_unused]] [[nodiscard]] bool equals(std::span<const T> other) const { return size() == other.size() && detail::equal_n(data(), other.data(), size()); }
+
+        [[maybe_unused]] [[nodiscard]] bool equals(parallel::par_t, std::span<const T> other, std::size_t workers = 0) const {
+            if (size() != other.size()) {
+                return false;
             }
+
+            std::atomic<bool> equal = true;
+            parallel::for_ranges(
+                size(), detail::parallel_grain<T>(),
+                [&](std::size_t first, std::size_t last) {
+                    if (equal.load(std::memory_order_relaxed) && !detail::equal_n(data() + first, other.data() + first, last - first)) {
+                        equal.store(false, std::memory_order_relaxed);
+                    }
+                },
+                workers);
+            return equal.load();
+        }
+
+        // lexicographical three-way comparison, bytes compare with memcmp.
+        template<typename U = T>
+            requires std::three_way_comparable<U>
+        [[maybe_unused]] [[nodiscard]] auto compare(std::span<const T> other) const {
+            return std::lexicographical_compare_three_way(data(), data() + size(), other.data(), other.data() + other.size());
         }
 
         [[maybe_unused]] T &get(uintptr_t index) const {
@@ -137,92 +318,123 @@ namespace astra::mem {
         template<typename U>
         [[maybe_unused]] U get(uintptr_t index) const {
             assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) < byte_size());
+            assert(sizeof(T) * index + sizeof(U) <= byte_size());
             return reinterpret_cast<U *>(data() + index)[0];
         }
 
         template<typename U>
         [[maybe_unused]] U rget(uintptr_t& index) const {
             assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) < byte_size());
+            assert(sizeof(T) * index + sizeof(U) <= byte_size());
             auto value = reinterpret_cast<U *>(data() + index)[0];
             index += sizeof(U) / sizeof(T);
             return value;
         }
 
         template<typename U>
-        [[maybe_unused]] U set(uintptr_t index, U value) {
+        [[maybe_unused]] void set(uintptr_t index, U value) {
             assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) < byte_size());
+            assert(sizeof(T) * index + sizeof(U) <= byte_size());
             reinterpret_cast<U *>(data() + index)[0] = value;
         }
 
         template<typename U>
-        [[maybe_unused]] U rset(uintptr_t& index, U value) {
+        [[maybe_unused]] void rset(uintptr_t& index, U value) {
             assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) < byte_size());
+            assert(sizeof(T) * index + sizeof(U) <= byte_size());
             reinterpret_cast<U *>(data() + index)[0] = value;
             index += sizeof(U) / sizeof(T);
         }
 
-        [[maybe_unused]] std::shared_ptr<runtime_array<T>> slice(uintptr_t index, std::size_t count) const {
-            assert(index < size());
-            assert(index + count < size());
+        // views share the storage of this array through the aliasing constructor, they are O(1) and never copy.
+        // the storage stays alive for as long as any view of it exists, use clone() if a private copy is needed.
+        [[maybe_unused]] runtime_array<T> view(uintptr_t index, std::size_t count) const {
+            assert(index + count <= size());
 
-            return std::make_shared<runtime_array<T>>(data(), count);
+            ASTRA_MEM_RECORD(T, view, 0);
+            return runtime_array<T>(ptr, offset + index * sizeof(T), count);
         }
 
         template<typename U>
-        [[maybe_unused]] std::shared_ptr<runtime_array<U>> slice(uintptr_t index, std::size_t count) const {
-            assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) * count < byte_size());
+        [[maybe_unused]] runtime_array<U> view(uintptr_t index, std::size_t count) const {
+            assert(sizeof(T) * index + sizeof(U) * count <= byte_size());
 
-            return std::make_shared<runtime_array<U>>(reinterpret_cast<U *>(data() + index), count);
+            ASTRA_MEM_RECORD(U, view, 0);
+            return runtime_array<U>(std::shared_ptr<U[]>(ptr, reinterpret_cast<U *>(ptr.get())), offset + index * sizeof(T), count);
         }
 
-        [[maybe_unused]] std::shared_ptr<runtime_array<T>> rslice(uintptr_t& index, std::size_t count) const {
-            assert(index < size());
-            assert(index + count < size());
+        [[maybe_unused]] std::shared_ptr<runtime_array<T>> slice(uintptr_t index, std::size_t count) const {
+            return std::make_shared<runtime_array<T>>(view(index, count));
+        }
+
+        template<typename U>
+        [[maybe_unused]] std::shared_ptr<runtime_array<U>> slice(uintptr_t index, std::size_t count) const {
+            return std::make_shared<runtime_array<U>>(view<U>(index, count));
+        }
 
-            auto value = std::make_shared<runtime_array<T>>(data(), count);
+        [[maybe_unused]] std::shared_ptr<runtime_array<T>> rslice(uintptr_t &index, std::size_t count) const {
+            auto value = slice(index, count);
             index += count;
             return value;
         }
 
         template<typename U>
-        [[maybe_unused]] std::shared_ptr<runtime_array<U>> rslice(uintptr_t& index, std::size_t count) const {
-            assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) * count < byte_size());
-
-            auto value = std::make_shared<runtime_array<U>>(reinterpret_cast<U *>(data() + index), count);
+        [[maybe_unused]] std::shared_ptr<runtime_array<U>> rslice(uintptr_t &index, std::size_t count) const {
+            auto value = slice<U>(index, count);
             index += (sizeof(U) / sizeof(T)) * count;
             return value;
         }
 
+        // deep copies, the result owns a freshly allocated buffer.
+        [[maybe_unused]] std::shared_ptr<runtime_array<T>> clone() const { return std::make_shared<runtime_array<T>>(data(), size()); }
+
+        [[maybe_unused]] std::shared_ptr<runtime_array<T>> clone(uintptr_t index, std::size_t count) const {
+            assert(index + count <= size());
+
+            return std::make_shared<runtime_array<T>>(data() + index, count);
+        }
+
         [[maybe_unused]] void copy_to(std::shared_ptr<runtime_array<T>> &array, uintptr_t index, std::size_t count) {
-            assert(array->size() > count);
-            assert(index < size());
-            assert(index + count < size());
+            assert(array->size() >= count);
+            assert(index + count <= size());
 
+            ASTRA_MEM_RECORD(T, copy, count * sizeof(T));
             std::copy_n((data() + index), count, array->data());
         }
 
         template<typename U>
         [[maybe_unused]] void copy_to(std::shared_ptr<runtime_array<U>> &array, uintptr_t index, std::size_t count) {
-            assert(array->size() > count);
-            assert(index < size());
-            assert(sizeof(T) * index + sizeof(U) * count < byte_size());
+            assert(array->size() >= count);
+            assert(sizeof(T) * index + sizeof(U) * count <= byte_size());
 
+            ASTRA_MEM_RECORD(U, copy, count * sizeof(U));
             std::copy_n(reinterpret_cast<U *>(data() + index), count, array->data());
         }
 
+        // copies dst.size() elements starting at `index` into `dst`, a memmove for trivially copyable types.
+        [[maybe_unused]] void copy_to(std::span<T> dst, uintptr_t index = 0) const {
+            assert(index + dst.size() <= size());
+
+            ASTRA_MEM_RECORD(T, copy, dst.size_bytes());
+            std::copy_n(data() + index, dst.size(), dst.data());
+        }
+
+        [[maybe_unused]] void copy_to(parallel::par_t, std::span<T> dst, uintptr_t index = 0, std::size_t workers = 0) const {
+            assert(index + dst.size() <= size());
+
+            ASTRA_MEM_RECORD(T, copy, dst.size_bytes());
+            parallel::for_ranges(dst.size(), detail::parallel_grain<T>(), [&](std::size_t first, std::size_t last) { std::copy_n(data() + index + first, last - first, dst.data() + first); }, workers);
+        }
+
 
         template<typename U = T>
         [[maybe_unused]] typename std::enable_if<sizeof(U) <= 2 && std::is_same<U, T>::value && std::is_integral<U>::value, void>::type ensure_null_terminated() {
-            auto buffer = data();
+            auto storage = ptr; // keep the old buffer alive until it has been copied.
+            auto buffer  = data();
             if (buffer[size() - 1] != 0) {
                 length += 1;
                 alloc(length);
+                ASTRA_MEM_RECORD(T, copy, (size() - 1) * sizeof(T));
                 std::copy_n(buffer, size() - 1, data());
                 data()[size() - 1] = static_cast<T>(0);
             }
@@ -261,6 +473,11 @@ namespace astra::mem {
             return std::iostream(reinterpret_cast<char *>(data()), std::ios::in | std::ios::out, byte_size());
         }
 
-        [[maybe_unused]] std::vector<T> to_vector() { return std::vector<T>(data(), data() + size()); }
+        [[maybe_unused]] std::vector<T> to_vector() {
+            ASTRA_MEM_RECORD(T, copy, byte_size());
+            return std::vector<T>(data(), data() + size());
+        }
     };
-} // namespace astra::mem
\ No newline at end of file
+
+    static_assert(std::ranges::contiguous_range<runtime_array<uint8_t>> && std::ranges::sized_range<runtime_array<uint8_t>>);
+} // namespace astra::mem
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "unique_runtime_array.hpp"
+
+// a runtime_array that keeps up to N elements inside the object itself, so short arrays in per-record loops never touch
+// the heap. longer arrays spill into a unique_runtime_array. moving an inline array moves its elements, so views of
+// it (which are non-owning, as with unique_runtime_array) don't survive a move.
+
+namespace astra::mem {
+    template<typename T, std::size_t N>
+    class small_runtime_array : public detail::array_access<small_runtime_array<T, N>, T> {
+        static_assert(N > 0, "use unique_runtime_array for arrays without inline storage");
+
+    private:
+        alignas(T) std::byte inline_storage[sizeof(T) * N];
+        unique_runtime_array<T> heap;
+        std::size_t length = 0;
+
+        [[nodiscard]] bool is_inline() const { return length <= N; }
+
+        [[nodiscard]] T *inline_data() const { return std::launder(reinterpret_cast<T *>(const_cast<std::byte *>(inline_storage))); }
+
+        void destroy() {
+            if (is_inline()) {
+                std::destroy_n(inline_data(), length);
+            }
+            heap   = {};
+            length = 0;
+        }
+
+        // moves the contents of `other` into this empty array and leaves `other` empty. length is only set once the
+        // elements are in place, so a throwing move leaves this array empty and `other` still owning its elements.
+        void take(small_runtime_array &&other) {
+            if (other.is_inline()) {
+                std::uninitialized_move_n(other.inline_data(), other.length, inline_data());
+                std::destroy_n(other.inline_data(), other.length);
+            } else {
+                heap = std::move(other.heap);
+            }
+            length       = other.length;
+            other.length = 0;
+        }
+
+    public:
+        small_runtime_array() = default;
+
+        // copies `size` elements from `ptr` unless it is nullptr, like runtime_array(ptr, size).
+        small_runtime_array(const T *ptr, std::size_t size) : length(size) {
+            if (!is_inline()) {
+                heap = unique_runtime_array<T>(ptr, size);
+                return;
+            }
+
+            if (ptr != nullptr) {
+                ASTRA_MEM_RECORD(T, copy, size * sizeof(T));
+                std::uninitialized_copy_n(ptr, size, inline_data());
+            } else {
+                std::uninitialized_default_construct_n(inline_data(), size);
+            }
+        }
+
+        [[maybe_unused]] small_runtime_array(const T *ptr, std::size_t size, const T &default_value) : small_runtime_array(ptr, size) { this->fill(default_value); }
+
+        small_runtime_array(const small_runtime_array &other) : small_runtime_array(other.data(), other.size()) { }
+
+        small_runtime_array(small_runtime_array &&other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(std::move(other)); }
+
+        small_runtime_array &operator=(const small_runtime_array &other) {
+            if (this != &other) {
+                auto copy = other;
+                *this     = std::move(copy);
+            }
+            return *this;
+        }
+
+        small_runtime_array &operator=(small_runtime_array &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+            if (this != &other) {
+                destroy();
+                take(std::move(other));
+            }
+            return *this;
+        }
+
+        ~small_runtime_array() { destroy(); }
+
+        ASTRA_INLINE T *data() const { return is_inline() ? inline_data() : heap.data(); }
+
+        [[nodiscard]] ASTRA_INLINE std::size_t size() const { return length; }
+
+        [[nodiscard]] static constexpr std::size_t inline_capacity() { return N; }
+
+        // a runtime_array with the same elements. spilled arrays hand their block over without copying and are empty
+        // afterwards, inline ones are copied once into shared storage.
+        [[maybe_unused]] runtime_array<T> share() && {
+            if (is_inline()) {
+                auto result = this->share_copy();
+                destroy();
+                return result;
+            }
+
+            length = 0;
+            return std::move(heap).share();
+        }
+    };
+} // namespace astra::mem
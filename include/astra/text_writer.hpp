@@ -0,0 +1,445 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifdef WIN32
+#    include <fcntl.h>
+#    include <io.h>
+#    include <sys/stat.h>
+#else
+#    include <fcntl.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
+
+#include "runtime_array.hpp"
+
+// a buffered writer for large text and json dumps, in place of std::ostream and indent. text is formatted straight into
+// one reusable buffer and handed to the file in large writes, payloads that don't fit the buffer go out together with
+// it in a single writev instead of being copied. numbers go through std::to_chars, so there's no locale and no
+// allocation, and indentation is a depth counter that is written from a static table of spaces.
+//
+// with background set a second buffer is swapped in whenever one fills up and a flush thread writes the full one, so
+// formatting and I/O overlap. write errors are rethrown on the formatting thread by the next handoff or flush.
+// the destructor flushes but can't report errors, call flush() before it when they matter.
+
+namespace astra::io {
+    struct text_writer_options_t {
+        size_t buffer_size  = 1 << 20; // per buffer, background writers use two.
+        size_t indent_width = 2;
+        bool background     = false;
+    };
+
+    namespace detail {
+        constexpr auto TEXT_SPACES = [] {
+            std::array<char, 256> spaces {};
+            spaces.fill(' ');
+            return spaces;
+        }();
+
+        constexpr char TEXT_HEX_DIGITS[] = "0123456789abcdef";
+
+        constexpr size_t TEXT_MIN_BUFFER  = 4096;
+        constexpr size_t TEXT_MAX_NUMBER  = 64; // the longest to_chars output of any arithmetic type.
+        constexpr size_t TEXT_MAX_COLUMNS = 64;
+
+        inline void close_descriptor(int fd) {
+#ifndef WIN32
+            ::close(fd);
+#else
+            ::_close(fd);
+#endif
+        }
+
+        // closes a descriptor the writer opened until it is released, so a constructor that throws doesn't leak it.
+        struct text_descriptor_guard {
+            int fd = -1;
+
+            ~text_descriptor_guard() {
+                if (fd >= 0) {
+                    close_descriptor(fd);
+                }
+            }
+
+            int release() { return std::exchange(fd, -1); }
+        };
+
+        // integers and floating point, bools included. character types are text and go through write(char) or
+        // write(std::string_view) instead, signed and unsigned char (int8_t, uint8_t) are numbers.
+        template<typename T>
+        concept text_number = std::is_floating_point_v<T> || (std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char8_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>);
+
+        // writes every segment to `fd`, retrying short writes.
+        inline void write_segments(int fd, std::string_view *segments, size_t count) {
+#ifndef WIN32
+            constexpr size_t max_segments = 8;
+            while (count > 0) {
+                iovec vectors[max_segments];
+                auto n = std::min(count, max_segments);
+                for (size_t i = 0; i < n; ++i) {
+                    vectors[i] = {const_cast<char *>(segments[i].data()), segments[i].size()};
+                }
+
+                auto written = ::writev(fd, vectors, static_cast<int>(n));
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "text_writer");
+                }
+
+                // drop what went out, the first segment left may be partially written.
+                auto done = static_cast<size_t>(written);
+                while (count > 0 && done >= segments->size()) {
+                    done -= segments->size();
+                    ++segments;
+                    --count;
+                }
+                if (count > 0) {
+                    segments->remove_prefix(done);
+                }
+            }
+#else
+            for (size_t i = 0; i < count; ++i) {
+                auto segment = segments[i];
+                while (!segment.empty()) {
+                    auto chunk   = static_cast<unsigned>(std::min<size_t>(segment.size(), 1u << 30));
+                    auto written = ::_write(fd, segment.data(), chunk);
+                    if (written < 0) {
+                        throw std::system_error(errno, std::generic_category(), "text_writer");
+                    }
+                    segment.remove_prefix(static_cast<size_t>(written));
+                }
+            }
+#endif
+        }
+    } // namespace detail
+
+    class text_writer {
+    private:
+        int fd     = -1;
+        bool owned = false;
+        std::function<void(std::string_view)> callback;
+
+        std::unique_ptr<char[]> active;
+        std::unique_ptr<char[]> spare;
+        size_t capacity     = 0;
+        size_t position     = 0;
+        size_t depth        = 0;
+        size_t indent_width = 2;
+
+        // background flushing, `pending` is the buffer the flush thread owns until it resets it to nullptr.
+        std::thread flusher;
+        std::mutex lock;
+        std::condition_variable wake;
+        const char *pending  = nullptr;
+        size_t pending_size  = 0;
+        bool stopping        = false;
+        std::exception_ptr error;
+
+        void emit(std::string_view *segments, size_t count) {
+            if (callback) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (!segments[i].empty()) {
+                        callback(segments[i]);
+                    }
+                }
+                return;
+            }
+            detail::write_segments(fd, segments, count);
+        }
+
+        void flush_loop() {
+            std::unique_lock guard(lock);
+            for (;;) {
+                wake.wait(guard, [this] { return pending != nullptr || stopping; });
+                if (pending == nullptr) {
+                    return;
+                }
+
+                std::string_view segment(pending, pending_size);
+                guard.unlock();
+                try {
+                    emit(&segment, 1);
+                } catch (...) {
+                    guard.lock();
+                    error = std::current_exception();
+                    guard.unlock();
+                }
+                guard.lock();
+                pending = nullptr;
+                wake.notify_all();
+            }
+        }
+
+        // waits until the flush thread is done with its buffer, and rethrows what went wrong while writing it.
+        void wait_idle() {
+            if (!flusher.joinable()) {
+                return;
+            }
+
+            std::unique_lock guard(lock);
+            wake.wait(guard, [this] { return pending == nullptr; });
+            if (error != nullptr) {
+                std::rethrow_exception(std::exchange(error, nullptr));
+            }
+        }
+
+        // hands the buffered text off, to the flush thread if there is one.
+        void drain() {
+            if (position == 0) {
+                return;
+            }
+
+            if (flusher.joinable()) {
+                wait_idle();
+                {
+                    std::lock_guard guard(lock);
+                    pending      = active.get();
+                    pending_size = position;
+                }
+                std::swap(active, spare);
+                position = 0;
+                wake.notify_all();
+                return;
+            }
+
+            std::string_view segment(active.get(), position);
+            position = 0;
+            emit(&segment, 1);
+        }
+
+        // room for `size` more bytes at the end of the buffer, `size` is at most the buffer size.
+        char *reserve(size_t size) {
+            if (capacity - position < size) {
+                drain();
+            }
+            return active.get() + position;
+        }
+
+        void start(const text_writer_options_t &options) {
+            capacity     = std::max(options.buffer_size, detail::TEXT_MIN_BUFFER);
+            indent_width = options.indent_width;
+            active       = std::make_unique_for_overwrite<char[]>(capacity);
+            if (options.background) {
+                spare   = std::make_unique_for_overwrite<char[]>(capacity);
+                flusher = std::thread([this] { flush_loop(); });
+            }
+        }
+
+    public:
+        // creates or truncates the file at `path`.
+        explicit text_writer(const std::filesystem::path &path, const text_writer_options_t &options = {}) : owned(true) {
+            detail::text_descriptor_guard guard;
+#ifndef WIN32
+            guard.fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#else
+            guard.fd = ::_wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#endif
+            if (guard.fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path.string());
+            }
+            fd = guard.fd;
+            start(options);
+            guard.release();
+        }
+
+        // writes to a descriptor the caller keeps open, such as STDOUT_FILENO.
+        explicit text_writer(int descriptor, const text_writer_options_t &options = {}) : fd(descriptor) { start(options); }
+
+        // hands every filled buffer to `sink`, for in-memory output or another stage such as lz4_compress.
+        explicit text_writer(std::function<void(std::string_view)> sink, const text_writer_options_t &options = {}) : callback(std::move(sink)) { start(options); }
+
+        text_writer(const text_writer &)            = delete;
+        text_writer &operator=(const text_writer &) = delete;
+
+        ~text_writer() {
+            try {
+                flush();
+            } catch (...) {
+                // see the note at the top of the file.
+            }
+
+            if (flusher.joinable()) {
+                {
+                    std::lock_guard guard(lock);
+                    stopping = true;
+                }
+                wake.notify_all();
+                flusher.join();
+            }
+
+            if (owned && fd >= 0) {
+                detail::close_descriptor(fd);
+            }
+        }
+
+        // writes out everything buffered so far and waits for it.
+        void flush() {
+            drain();
+            wait_idle();
+        }
+
+        text_writer &write(std::string_view text) {
+            if (text.size() <= capacity - position) {
+                std::memcpy(active.get() + position, text.data(), text.size());
+                position += text.size();
+                return *this;
+            }
+
+            if (text.size() < capacity / 2) {
+                drain();
+                std::memcpy(active.get(), text.data(), text.size());
+                position = text.size();
+                return *this;
+            }
+
+            // large payloads leave with the buffer in one writev instead of being copied through it.
+            wait_idle();
+            std::string_view segments[] = {{active.get(), position}, text};
+            position                    = 0;
+            emit(segments, 2);
+            return *this;
+        }
+
+        text_writer &write(char value) {
+            *reserve(1) = value;
+            ++position;
+            return *this;
+        }
+
+        // integers and floating point through std::to_chars, bools as true/false. int8_t and uint8_t are numbers.
+        template<detail::text_number T>
+        text_writer &write(T value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                return write(value ? std::string_view("true") : std::string_view("false"));
+            } else {
+                auto at     = reserve(detail::TEXT_MAX_NUMBER);
+                auto result = std::to_chars(at, at + detail::TEXT_MAX_NUMBER, value);
+                position += static_cast<size_t>(result.ptr - at);
+                return *this;
+            }
+        }
+
+        template<typename T>
+        text_writer &operator<<(const T &value) {
+            return write(value);
+        }
+
+        // `digits` lowercase hex digits of `value`, or as many as it needs when `digits` is 0.
+        text_writer &hex(uint64_t value, size_t digits = 0) {
+            digits  = std::min<size_t>(digits == 0 ? std::max<size_t>(1, (static_cast<size_t>(std::bit_width(value)) + 3) / 4) : digits, 16);
+            auto at = reserve(digits);
+            for (auto i = digits; i > 0; --i) {
+                at[i - 1] = detail::TEXT_HEX_DIGITS[value & 0xF];
+                value >>= 4;
+            }
+            position += digits;
+            return *this;
+        }
+
+        // fnv hashes at their full width, the way they are usually listed.
+        [[maybe_unused]] text_writer &hash(uint64_t value) { return hex(value, 16); }
+
+        [[maybe_unused]] text_writer &hash(uint32_t value) { return hex(value, 8); }
+
+        // the current indentation, `indent_width` spaces per level.
+        text_writer &write_indent() {
+            for (auto spaces = depth * indent_width; spaces > 0;) {
+                auto chunk = std::min(spaces, detail::TEXT_SPACES.size());
+                write(std::string_view(detail::TEXT_SPACES.data(), chunk));
+                spaces -= chunk;
+            }
+            return *this;
+        }
+
+        [[maybe_unused]] text_writer &indent(size_t levels = 1) {
+            depth += levels;
+            return *this;
+        }
+
+        [[maybe_unused]] text_writer &dedent(size_t levels = 1) {
+            depth -= std::min(levels, depth);
+            return *this;
+        }
+
+        [[maybe_unused]] [[nodiscard]] size_t indent_level() const { return depth; }
+
+        // one indented line made of all arguments, without arguments an empty line.
+        template<typename... Args>
+        text_writer &line(const Args &...args) {
+            if constexpr (sizeof...(Args) > 0) {
+                write_indent();
+                (write(args), ...);
+            }
+            return write('\n');
+        }
+
+        // a classic hex dump, one indented line per `columns` bytes: offset, hex bytes and printable ascii.
+        text_writer &hex_dump(std::span<const uint8_t> bytes, size_t columns = 16) {
+            if (columns == 0 || columns > detail::TEXT_MAX_COLUMNS) {
+                throw std::invalid_argument("text_writer: hex_dump columns must be between 1 and 64");
+            }
+
+            auto line_size = 8 + 2 + columns * 3 + 2 + columns + 2;
+            for (size_t offset = 0; offset < bytes.size(); offset += columns) {
+                auto count = std::min(columns, bytes.size() - offset);
+                write_indent();
+
+                auto at = reserve(line_size);
+                auto op = at;
+                for (int shift = 28; shift >= 0; shift -= 4) {
+                    *op++ = detail::TEXT_HEX_DIGITS[(offset >> shift) & 0xF];
+                }
+                *op++ = ':';
+                *op++ = ' ';
+                for (size_t i = 0; i < columns; ++i) {
+                    if (i < count) {
+                        op[0] = detail::TEXT_HEX_DIGITS[bytes[offset + i] >> 4];
+                        op[1] = detail::TEXT_HEX_DIGITS[bytes[offset + i] & 0xF];
+                    } else {
+                        op[0] = ' ';
+                        op[1] = ' ';
+                    }
+                    op[2] = ' ';
+                    op += 3;
+                }
+                *op++ = ' ';
+                *op++ = '|';
+                for (size_t i = 0; i < count; ++i) {
+                    auto c = bytes[offset + i];
+                    *op++  = c >= 0x20 && c < 0x7F ? static_cast<char>(c) : '.';
+                }
+                *op++ = '|';
+                *op++ = '\n';
+                position += static_cast<size_t>(op - at);
+            }
+            return *this;
+        }
+
+        template<typename T>
+        [[maybe_unused]] text_writer &hex_dump(const astra::mem::runtime_array<T> &values, size_t columns = 16) {
+            return hex_dump(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(values.data()), values.byte_size()), columns);
+        }
+    };
+} // namespace astra::io
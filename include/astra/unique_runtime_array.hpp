@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "allocator.hpp"
+#include "instrument.hpp"
+#include "macros.hpp"
+#include "runtime_array.hpp"
+
+// runtime_array without the shared ownership. unique_runtime_array owns one aligned heap block through a unique_ptr,
+// so moving it is two pointer copies and releasing it is one free, with no control block and no atomic refcounts.
+// share() hands the block to a runtime_array when it has to outlive its scope or cross threads, without copying.
+// views and slices are non-owning runtime_arrays, they are only valid while the array they came from is alive.
+
+namespace astra::mem {
+    namespace detail {
+        // the accessors that don't care how the storage is owned, for any Derived with data() and size().
+        template<typename Derived, typename T>
+        class array_access {
+        private:
+            [[nodiscard]] const Derived &self() const { return static_cast<const Derived &>(*this); }
+
+            [[nodiscard]] T *base() const { return self().data(); }
+
+            [[nodiscard]] std::size_t count() const { return self().size(); }
+
+        public:
+            using value_type      = T;
+            using size_type       = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using iterator        = typename runtime_array<T>::Iterator;
+            using const_iterator  = typename runtime_array<T>::ConstIterator;
+
+            [[nodiscard]] ASTRA_INLINE bool is_aligned() const { return reinterpret_cast<intptr_t>(base()) % ASTRA_ALIGNMENT == 0; }
+
+            [[nodiscard]] ASTRA_INLINE std::size_t byte_size() const { return count() * sizeof(T); }
+
+            [[maybe_unused]] [[nodiscard]] ASTRA_INLINE bool empty() const { return count() == 0; }
+
+            [[maybe_unused]] ASTRA_INLINE T &operator[](uintptr_t index) const { return get(index); }
+
+            iterator begin() const { return iterator(base()); }
+
+            iterator end() const { return iterator(base() + count()); }
+
+            [[maybe_unused]] const_iterator cbegin() const { return const_iterator(base()); }
+
+            [[maybe_unused]] const_iterator cend() const { return const_iterator(base() + count()); }
+
+            [[maybe_unused]] std::span<T> span() const { return {base(), count()}; }
+
+            [[maybe_unused]] void fill(const T &default_value) { detail::fill_n(base(), count(), default_value); }
+
+            [[maybe_unused]] [[nodiscard]] bool equals(std::span<const T> other) const { return count() == other.size() && detail::equal_n(base(), other.data(), count()); }
+
+            template<typename U = T>
+                requires std::three_way_comparable<U>
+            [[maybe_unused]] [[nodiscard]] auto compare(std::span<const T> other) const {
+                return std::lexicographical_compare_three_way(base(), base() + count(), other.data(), other.data() + other.size());
+            }
+
+            [[maybe_unused]] T &get(uintptr_t index) const {
+                assert(index < count());
+                return base()[index];
+            }
+
+            [[maybe_unused]] T &rget(uintptr_t &index) const {
+                assert(index < count());
+                return base()[index++];
+            }
+
+            [[maybe_unused]] void set(uintptr_t index, T value) {
+                assert(index < count());
+                base()[index] = value;
+            }
+
+            [[maybe_unused]] void rset(uintptr_t &index, T value) {
+                assert(index < count());
+                base()[index++] = value;
+            }
+
+            template<typename U>
+            [[maybe_unused]] U get(uintptr_t index) const {
+                assert(index < count());
+                assert(sizeof(T) * index + sizeof(U) <= byte_size());
+                return reinterpret_cast<U *>(base() + index)[0];
+            }
+
+            template<typename U>
+            [[maybe_unused]] U rget(uintptr_t &index) const {
+                auto value = get<U>(index);
+                index += sizeof(U) / sizeof(T);
+                return value;
+            }
+
+            template<typename U>
+            [[maybe_unused]] void set(uintptr_t index, U value) {
+                assert(index < count());
+                assert(sizeof(T) * index + sizeof(U) <= byte_size());
+                reinterpret_cast<U *>(base() + index)[0] = value;
+            }
+
+            template<typename U>
+            [[maybe_unused]] void rset(uintptr_t &index, U value) {
+                set<U>(index, value);
+                index += sizeof(U) / sizeof(T);
+            }
+
+            // non-owning views, see the note at the top of the file.
+            [[maybe_unused]] runtime_array<T> view(uintptr_t index, std::size_t size) const {
+                assert(index + size <= count());
+
+                ASTRA_MEM_RECORD(T, view, 0);
+                return runtime_array<T>(std::span<T>(base() + index, size));
+            }
+
+            template<typename U>
+            [[maybe_unused]] runtime_array<U> view(uintptr_t index, std::size_t size) const {
+                assert(sizeof(T) * index + sizeof(U) * size <= byte_size());
+
+                ASTRA_MEM_RECORD(U, view, 0);
+                return runtime_array<U>(std::span<U>(reinterpret_cast<U *>(base() + index), size));
+            }
+
+            [[maybe_unused]] std::shared_ptr<runtime_array<T>> slice(uintptr_t index, std::size_t size) const { return std::make_shared<runtime_array<T>>(view(index, size)); }
+
+            template<typename U>
+            [[maybe_unused]] std::shared_ptr<runtime_array<U>> slice(uintptr_t index, std::size_t size) const {
+                return std::make_shared<runtime_array<U>>(view<U>(index, size));
+            }
+
+            [[maybe_unused]] std::shared_ptr<runtime_array<T>> rslice(uintptr_t &index, std::size_t size) const {
+                auto value = slice(index, size);
+                index += size;
+                return value;
+            }
+
+            template<typename U>
+            [[maybe_unused]] std::shared_ptr<runtime_array<U>> rslice(uintptr_t &index, std::size_t size) const {
+                auto value = slice<U>(index, size);
+                index += (sizeof(U) / sizeof(T)) * size;
+                return value;
+            }
+
+            [[maybe_unused]] void copy_to(std::span<T> dst, uintptr_t index = 0) const {
+                assert(index + dst.size() <= count());
+
+                ASTRA_MEM_RECORD(T, copy, dst.size_bytes());
+                std::copy_n(base() + index, dst.size(), dst.data());
+            }
+
+            [[maybe_unused]] std::vector<T> to_vector() const {
+                ASTRA_MEM_RECORD(T, copy, byte_size());
+                return std::vector<T>(base(), base() + count());
+            }
+
+            // a shared copy, for when the storage can't be handed over.
+            [[maybe_unused]] runtime_array<T> share_copy() const { return runtime_array<T>(base(), count()); }
+        };
+
+        // frees a unique_runtime_array block, and gives it back to the allocator it came from if there was one.
+        template<typename T>
+        struct unique_array_delete {
+            std::shared_ptr<allocator> source = nullptr;
+            std::size_t count                 = 0;
+
+            void operator()(T *p) const {
+                ASTRA_MEM_RECORD(T, release, count * sizeof(T));
+                std::destroy_n(p, count);
+                if (source != nullptr) {
+                    source->deallocate(p, count * sizeof(T));
+                } else {
+                    ::operator delete[](p, std::align_val_t(ASTRA_ALIGNMENT));
+                }
+            }
+        };
+    } // namespace detail
+
+    template<typename T>
+    class unique_runtime_array : public detail::array_access<unique_runtime_array<T>, T> {
+    private:
+        std::unique_ptr<T[], detail::unique_array_delete<T>> storage = nullptr;
+        std::size_t length                                           = 0;
+
+        // the same storage runtime_array::alloc hands out: ASTRA_ALIGNMENT aligned, from current_allocator() if set.
+        void alloc(std::size_t size) {
+            auto &source = current_allocator();
+            auto buffer  = static_cast<T *>(source != nullptr ? source->allocate(size * sizeof(T)) : ::operator new[](size * sizeof(T), std::align_val_t(ASTRA_ALIGNMENT)));
+            std::uninitialized_default_construct_n(buffer, size);
+            storage = std::unique_ptr<T[], detail::unique_array_delete<T>>(buffer, {source, size});
+            ASTRA_MEM_RECORD(T, allocate, size * sizeof(T));
+        }
+
+    public:
+        unique_runtime_array() = default;
+
+        // allocates `size` elements and copies them from `ptr` unless it is nullptr, like runtime_array(ptr, size).
+        unique_runtime_array(const T *ptr, std::size_t size) : length(size) {
+            if (size == 0) {
+                return;
+            }
+
+            alloc(size);
+            if (ptr != nullptr) {
+                ASTRA_MEM_RECORD(T, copy, size * sizeof(T));
+                std::copy_n(ptr, size, data());
+            }
+        }
+
+        [[maybe_unused]] unique_runtime_array(const T *ptr, std::size_t size, const T &default_value) : unique_runtime_array(ptr, size) { this->fill(default_value); }
+
+        unique_runtime_array(unique_runtime_array &&other) noexcept : storage(std::move(other.storage)), length(std::exchange(other.length, 0)) { }
+
+        unique_runtime_array &operator=(unique_runtime_array &&other) noexcept {
+            storage = std::move(other.storage);
+            length  = std::exchange(other.length, 0);
+            return *this;
+        }
+
+        ASTRA_INLINE T *data() const { return storage.get(); }
+
+        [[nodiscard]] ASTRA_INLINE std::size_t size() const { return length; }
+
+        // hands the block to a runtime_array without copying, this array is empty afterwards.
+        [[maybe_unused]] runtime_array<T> share() && {
+            auto size = std::exchange(length, 0);
+            return runtime_array<T>(std::shared_ptr<T[]>(std::move(storage)), 0, size);
+        }
+
+        [[maybe_unused]] unique_runtime_array clone() const { return unique_runtime_array(data(), size()); }
+    };
+
+    static_assert(std::ranges::contiguous_range<unique_runtime_array<uint8_t>>);
+} // namespace astra::mem
@@ -0,0 +1,74 @@
+//
+// xxHash32, the checksum used by the lz4 frame format.
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+//
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "macros.hpp"
+
+namespace astra::hash {
+    constexpr uint32_t XXH_PRIME32_1 = 0x9E3779B1;
+    constexpr uint32_t XXH_PRIME32_2 = 0x85EBCA77;
+    constexpr uint32_t XXH_PRIME32_3 = 0xC2B2AE3D;
+    constexpr uint32_t XXH_PRIME32_4 = 0x27D4EB2F;
+    constexpr uint32_t XXH_PRIME32_5 = 0x165667B1;
+
+    namespace detail {
+        ASTRA_INLINE uint32_t xxh32_load(const uint8_t *bytes) {
+            uint32_t value;
+            std::memcpy(&value, bytes, 4);
+            if constexpr (std::endian::native == std::endian::big) {
+                value = std::byteswap(value);
+            }
+            return value;
+        }
+
+        ASTRA_INLINE uint32_t xxh32_round(uint32_t lane, uint32_t input) { return std::rotl(lane + input * XXH_PRIME32_2, 13) * XXH_PRIME32_1; }
+    } // namespace detail
+
+    // four independent lanes of 4 bytes each, so the main loop runs at several bytes per cycle.
+    [[maybe_unused]] inline uint32_t xxh32(const uint8_t *buf, size_t size, uint32_t seed = 0) {
+        auto end = buf + size;
+        uint32_t hash;
+        if (size >= 16) {
+            uint32_t v1 = seed + XXH_PRIME32_1 + XXH_PRIME32_2;
+            uint32_t v2 = seed + XXH_PRIME32_2;
+            uint32_t v3 = seed;
+            uint32_t v4 = seed - XXH_PRIME32_1;
+            for (auto limit = end - 16; buf <= limit; buf += 16) {
+                v1 = detail::xxh32_round(v1, detail::xxh32_load(buf));
+                v2 = detail::xxh32_round(v2, detail::xxh32_load(buf + 4));
+                v3 = detail::xxh32_round(v3, detail::xxh32_load(buf + 8));
+                v4 = detail::xxh32_round(v4, detail::xxh32_load(buf + 12));
+            }
+            hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        } else {
+            hash = seed + XXH_PRIME32_5;
+        }
+
+        hash += static_cast<uint32_t>(size);
+        for (; end - buf >= 4; buf += 4) {
+            hash = std::rotl(hash + detail::xxh32_load(buf) * XXH_PRIME32_3, 17) * XXH_PRIME32_4;
+        }
+
+        for (; buf < end; ++buf) {
+            hash = std::rotl(hash + *buf * XXH_PRIME32_5, 11) * XXH_PRIME32_1;
+        }
+
+        hash ^= hash >> 15;
+        hash *= XXH_PRIME32_2;
+        hash ^= hash >> 13;
+        hash *= XXH_PRIME32_3;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    [[maybe_unused]] inline uint32_t xxh32(std::span<const uint8_t> bytes, uint32_t seed = 0) { return xxh32(bytes.data(), bytes.size(), seed); }
+} // namespace astra::hash
@@ -0,0 +1,48 @@
+// size_class_pool recycles on its owning thread and takes back blocks that other threads release.
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <astra/allocator.hpp>
+
+#include "test.hpp"
+
+ASTRA_TEST(allocator_pool_recycles_on_owner) {
+    astra::mem::size_class_pool pool;
+    auto first = pool.allocate(100);
+    pool.deallocate(first, 100);
+    ASTRA_CHECK(pool.allocate(128) == first); // the same 128 byte class.
+    pool.deallocate(first, 128);
+}
+
+ASTRA_TEST(allocator_pool_takes_back_remote_frees) {
+    astra::mem::size_class_pool pool(1 << 20, 1024);
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 512; ++i) {
+        blocks.push_back(pool.allocate(4096));
+    }
+
+    std::vector<std::jthread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < blocks.size(); i += 4) {
+                pool.deallocate(blocks[i], 4096);
+            }
+            pool.deallocate(pool.allocate(64), 64); // other threads never touch the owner's lists.
+        });
+    }
+    threads.clear();
+
+    std::set<void *> released(blocks.begin(), blocks.end());
+    size_t reused = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i] = pool.allocate(4096);
+        reused += released.count(blocks[i]);
+    }
+    ASTRA_CHECK(reused == blocks.size());
+
+    for (auto block : blocks) {
+        pool.deallocate(block, 4096);
+    }
+}
@@ -0,0 +1,157 @@
+// every simd bcn kernel has to produce the scalar kernel's bytes exactly. surfaces are random blocks, sized so that the
+// simd main loops, their scalar tails and the ragged right and bottom edges all run.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+#include <astra/bcn.hpp>
+
+#include "test.hpp"
+
+namespace {
+    using astra::gdx::dxgi_format_t;
+    using astra::gdx::detail::bcn_isa;
+
+    struct surface_size_t {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // 1-3 wide surfaces are a single ragged block, 33 and 66 blocks leave every tail length of the 4- and 8-wide loops.
+    constexpr surface_size_t surface_sizes[] = {{1, 1}, {2, 3}, {3, 7}, {4, 4}, {5, 5}, {13, 9}, {31, 17}, {64, 4}, {131, 6}, {263, 11}, {132, 1}, {66, 66}};
+
+    std::vector<uint8_t> random_blocks(size_t count, size_t block_bytes, uint32_t seed) {
+        std::vector<uint8_t> blocks(count * block_bytes);
+        std::mt19937 rng(seed);
+        for (auto &byte : blocks) {
+            byte = static_cast<uint8_t>(rng());
+        }
+
+        // a few degenerate blocks: all zero, all ones and equal endpoints.
+        for (size_t i = 0; i < count; i += 7) {
+            std::memset(blocks.data() + i * block_bytes, i % 2 == 0 ? 0x00 : 0xFF, block_bytes);
+        }
+        for (size_t i = 3; i < count; i += 11) {
+            auto block = blocks.data() + i * block_bytes;
+            std::memcpy(block + block_bytes - 8 + 2, block + block_bytes - 8, 2);
+            block[1] = block[0];
+        }
+        return blocks;
+    }
+
+    std::vector<bcn_isa> simd_isas() {
+        std::vector<bcn_isa> isas;
+#ifdef ASTRA_X86
+        auto &cpu = astra::cpu::current();
+        if (cpu.sse41) {
+            isas.push_back(bcn_isa::sse41);
+        }
+        if (cpu.avx2 && cpu.bmi2) {
+            isas.push_back(bcn_isa::avx2);
+        }
+#endif
+        return isas;
+    }
+
+    const char *isa_name(bcn_isa isa) { return isa == bcn_isa::avx2 ? "avx2" : isa == bcn_isa::sse41 ? "sse4.1" : "scalar"; }
+
+    // decodes the same random surface with the scalar kernel and with `isa`. the destination rows carry 16 bytes of
+    // padding that both decodes must leave alone.
+    bool matches_scalar(dxgi_format_t format, bcn_isa isa, surface_size_t size, uint32_t seed) {
+        using namespace astra::gdx;
+
+        auto block_bytes = format_info(format).bytes_per_block;
+        auto pixel_bytes = format_info(bcn_decoded_format(format)).bits_per_pixel / 8;
+        auto blocks      = static_cast<size_t>((size.width + 3) / 4) * ((size.height + 3) / 4);
+        auto source      = random_blocks(blocks, block_bytes, seed);
+        auto pitch       = static_cast<size_t>(size.width) * pixel_bytes + 16;
+
+        std::vector<uint8_t> expected(pitch * size.height, 0xCD), actual(pitch * size.height, 0xCD);
+        detail::decode_surface(detail::bcn_kernel(format, bcn_isa::scalar), block_bytes, pixel_bytes, source.data(), size.width, size.height, expected.data(), pitch, 1);
+        detail::decode_surface(detail::bcn_kernel(format, isa), block_bytes, pixel_bytes, source.data(), size.width, size.height, actual.data(), pitch, 1);
+        if (expected == actual) {
+            return true;
+        }
+
+        auto at = std::mismatch(expected.begin(), expected.end(), actual.begin()).first - expected.begin();
+        std::fprintf(stderr, "format %d, %s, %ux%u: first difference at row %zu byte %zu\n", static_cast<int>(format), isa_name(isa), size.width, size.height, at / pitch, at % pitch);
+        return false;
+    }
+
+    void check_formats(std::initializer_list<dxgi_format_t> formats) {
+        auto isas = simd_isas();
+        if (isas.empty()) {
+            std::printf("no simd bcn kernels on this cpu, nothing to compare\n");
+            return;
+        }
+
+        uint32_t seed = 1;
+        for (auto format : formats) {
+            for (auto isa : isas) {
+                for (auto size : surface_sizes) {
+                    ASTRA_CHECK(matches_scalar(format, isa, size, seed++));
+                }
+            }
+        }
+    }
+} // namespace
+
+ASTRA_TEST(bcn_bc1_bc3_simd_matches_scalar) {
+    using enum dxgi_format_t;
+    check_formats({BC1_UNORM, BC2_UNORM, BC3_UNORM});
+}
+
+ASTRA_TEST(bcn_bc4_bc5_simd_matches_scalar) {
+    using enum dxgi_format_t;
+    check_formats({BC4_UNORM, BC4_SNORM, BC5_UNORM, BC5_SNORM});
+}
+
+// random blocks are mostly low bc7 modes and garbage bc6h headers, tests/bptc.cpp covers the modes one by one.
+ASTRA_TEST(bcn_bc6h_bc7_simd_matches_scalar) {
+    using enum dxgi_format_t;
+    check_formats({BC6H_UF16, BC6H_SF16, BC7_UNORM});
+}
+
+// the public entry point picks the best kernel itself, it has to agree with scalar on an odd surface too.
+ASTRA_TEST(bcn_decode_bcn_matches_scalar) {
+    using namespace astra::gdx;
+
+    for (auto format : {dxgi_format_t::BC1_UNORM, dxgi_format_t::BC3_UNORM, dxgi_format_t::BC5_SNORM}) {
+        auto source = random_blocks(static_cast<size_t>(26) * 10, format_info(format).bytes_per_block, 99);
+        std::vector<uint8_t> expected(101 * 37 * 4), actual(101 * 37 * 4);
+        detail::decode_surface(detail::bcn_kernel(format, bcn_isa::scalar), format_info(format).bytes_per_block, 4, source.data(), 101, 37, expected.data(), 101 * 4, 1);
+        decode_bcn(format, source.data(), 101, 37, actual.data(), 101 * 4, 4);
+        ASTRA_CHECK(expected == actual);
+    }
+}
+
+// a legacy cubemap stores only the faces caps2 flags, the decoded layout has to keep that many.
+ASTRA_TEST(bcn_decode_bcn_partial_cubemap) {
+    using namespace astra::gdx;
+
+    dds10_t header                 = {};
+    header.dx9.width               = 12;
+    header.dx9.height              = 8;
+    header.dx9.mip_count           = 2;
+    header.dx9.pixel_format.fourCC = 0x31545844; // DXT1
+    header.dx9.caps2               = 0x200 | 0x400 | 0x1000 | 0x4000;
+
+    dds_layout source(header);
+    auto target = bcn_decoded_layout(header);
+    ASTRA_CHECK(source.face_count == 3 && target.face_count == 3 && target.subresource_count() == source.subresource_count());
+
+    auto blocks = random_blocks(source.payload_size / 8, 8, 5);
+    astra::mem::runtime_array<uint8_t> payload(blocks.data(), blocks.size());
+    astra::mem::runtime_array<uint8_t> decoded(nullptr, target.payload_size);
+    decode_bcn(header, payload, decoded, 1);
+
+    auto &last = source.subresource(1, 0, 2);
+    std::vector<uint8_t> expected(6 * 4 * 4);
+    decode_bcn(dxgi_format_t::BC1_UNORM, payload.data() + last.offset, 6, 4, expected.data(), 6 * 4, 1);
+    ASTRA_CHECK(std::memcmp(decoded.data() + target.subresource(1, 0, 2).offset, expected.data(), expected.size()) == 0);
+}
@@ -0,0 +1,46 @@
+// encode_bcn_dds lays out the same subresources as its source, including cubemaps that store fewer than six faces.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <astra/bcn_encode.hpp>
+
+#include "test.hpp"
+
+ASTRA_TEST(bcn_encode_dds_partial_cubemap) {
+    using namespace astra::gdx;
+
+    dds10_t header                      = {};
+    header.dx9.width                    = 12;
+    header.dx9.height                   = 8;
+    header.dx9.mip_count                = 2;
+    header.dx9.pixel_format.flags       = 0x41; // DDPF_RGB | DDPF_ALPHAPIXELS
+    header.dx9.pixel_format.fourCC      = 0;
+    header.dx9.pixel_format.RGBBitCount = 32;
+    header.dx9.pixel_format.RBitMask    = 0x000000FF;
+    header.dx9.pixel_format.GBitMask    = 0x0000FF00;
+    header.dx9.pixel_format.BBitMask    = 0x00FF0000;
+    header.dx9.pixel_format.ABitMask    = 0xFF000000;
+    header.dx9.caps2                    = 0x200 | 0x800 | 0x2000 | 0x8000;
+
+    dds_layout source(header);
+    ASTRA_CHECK(source.format == dxgi_format_t::R8G8B8A8_UNORM && source.face_count == 3);
+
+    astra::mem::runtime_array<uint8_t> payload(nullptr, source.payload_size);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload.data()[i] = static_cast<uint8_t>(i * 37 + i / 5);
+    }
+
+    auto file = encode_bcn_dds(source, payload, dxgi_format_t::BC1_UNORM);
+
+    auto bc1   = source;
+    bc1.format = dxgi_format_t::BC1_UNORM;
+    bc1.build();
+    ASTRA_CHECK(file.size() == sizeof(dds10_t) + bc1.payload_size);
+
+    auto &from = source.subresource(1, 0, 2);
+    std::vector<uint8_t> expected(bc1.subresource(1, 0, 2).size);
+    encode_bcn(dxgi_format_t::BC1_UNORM, payload.data() + from.offset, from.width, from.height, from.row_pitch, expected.data());
+    ASTRA_CHECK(std::memcmp(file.data() + sizeof(dds10_t) + bc1.subresource(1, 0, 2).offset, expected.data(), expected.size()) == 0);
+}
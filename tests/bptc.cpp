@@ -0,0 +1,138 @@
+// the avx2 bc6h and bc7 kernels against the scalar ones, mode by mode. random blocks almost never reach the rarer bc7
+// modes or most partitions, so every block here has its mode and partition bits forced and only the rest is random.
+// endpoints at the ends of their range take the bc6h unquantize shortcuts for 0 and the largest value.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+#include <astra/bcn.hpp>
+
+#include "test.hpp"
+
+namespace {
+    using astra::gdx::dxgi_format_t;
+    using astra::gdx::detail::bcn_isa;
+    namespace detail = astra::gdx::detail;
+
+    void set_bits(uint8_t *block, size_t pos, size_t count, uint64_t value) {
+        for (size_t i = 0; i < count; ++i) {
+            auto bit = pos + i;
+            block[bit / 8] = static_cast<uint8_t>((block[bit / 8] & ~(1u << bit % 8)) | ((value >> i) & 1) << bit % 8);
+        }
+    }
+
+    struct field_t {
+        size_t pos;
+        size_t count;
+        uint64_t value;
+    };
+
+    struct block_set_t {
+        std::vector<uint8_t> bytes;
+        std::mt19937 rng;
+
+        explicit block_set_t(uint32_t seed) : rng(seed) { }
+
+        // `random` random blocks plus one of all zeros and one of all ones, with `fields` written over each of them.
+        void add(std::initializer_list<field_t> fields, size_t random) {
+            for (size_t i = 0; i < random + 2; ++i) {
+                uint8_t block[16];
+                for (auto &byte : block) {
+                    byte = i < random ? static_cast<uint8_t>(rng()) : i == random ? 0x00 : 0xFF;
+                }
+                for (auto &field : fields) {
+                    set_bits(block, field.pos, field.count, field.value);
+                }
+                bytes.insert(bytes.end(), block, block + 16);
+            }
+        }
+    };
+
+    bool row_matches_scalar(dxgi_format_t format, const std::vector<uint8_t> &blocks) {
+        using namespace astra::gdx;
+
+        auto count       = blocks.size() / 16;
+        auto pixel_bytes = format_info(bcn_decoded_format(format)).bits_per_pixel / 8;
+        auto pitch       = count * 4 * pixel_bytes;
+        std::vector<uint8_t> expected(pitch * 4, 0xCD), actual(pitch * 4, 0xCD);
+        detail::bcn_kernel(format, bcn_isa::scalar)(blocks.data(), count, expected.data(), pitch);
+        detail::bcn_kernel(format, bcn_isa::avx2)(blocks.data(), count, actual.data(), pitch);
+        if (expected == actual) {
+            return true;
+        }
+
+        auto at = static_cast<size_t>(std::mismatch(expected.begin(), expected.end(), actual.begin()).first - expected.begin());
+        auto block = (at % pitch) / (4 * pixel_bytes);
+        std::fprintf(stderr, "format %d: block %zu (first byte 0x%02x) differs at pixel row %zu\n", static_cast<int>(format), block, blocks[block * 16], at / pitch);
+        return false;
+    }
+
+    bool has_avx2() {
+#ifdef ASTRA_X86
+        auto &cpu = astra::cpu::current();
+        if (cpu.avx2 && cpu.bmi2) {
+            return true;
+        }
+#endif
+        std::printf("no avx2 bptc kernels on this cpu, nothing to compare\n");
+        return false;
+    }
+} // namespace
+
+ASTRA_TEST(bptc_bc7_modes_and_partitions) {
+    if (!has_avx2()) {
+        return;
+    }
+
+    block_set_t set(7);
+    for (size_t mode = 0; mode < 8; ++mode) {
+        auto &info = detail::bc7_modes[mode];
+        for (uint64_t partition = 0; partition < (uint64_t(1) << info.partition_bits); ++partition) {
+            // mode m is m zero bits and a one, the partition follows right after.
+            set.add({{0, mode + 1 + info.partition_bits, uint64_t(1) << mode | partition << (mode + 1)}}, 4);
+        }
+    }
+
+    // the reserved mode, a zero first byte, decodes to zero in both.
+    set.add({{0, 8, 0}}, 2);
+
+    detail::bc7_block_t unpacked;
+    for (size_t i = 0; i < set.bytes.size(); i += 16) {
+        ASTRA_CHECK(set.bytes[i] == 0 || detail::bc7_unpack(set.bytes.data() + i, unpacked));
+    }
+
+    ASTRA_CHECK(row_matches_scalar(dxgi_format_t::BC7_UNORM, set.bytes));
+    ASTRA_CHECK(row_matches_scalar(dxgi_format_t::BC7_UNORM_SRGB, set.bytes));
+}
+
+ASTRA_TEST(bptc_bc6h_modes_partitions_and_unquantize) {
+    if (!has_avx2()) {
+        return;
+    }
+
+    block_set_t set(11);
+    for (size_t code = 0; code < 32; ++code) {
+        size_t mode_bits = code < 2 ? 2 : 5;
+        if (code >= 2 && (code & 3) < 2) {
+            continue; // those 5-bit values start with one of the two 2-bit codes.
+        }
+
+        auto mode = detail::bc6h_lookup[code];
+        if (mode < 0 || detail::bc6h_modes[mode].subsets == 1) {
+            set.add({{0, mode_bits, code}}, 8); // reserved codes decode to zero.
+            continue;
+        }
+
+        // two-subset modes keep their 5-bit partition in bits 77-81.
+        for (uint64_t partition = 0; partition < 32; ++partition) {
+            set.add({{0, mode_bits, code}, {77, 5, partition}}, 2);
+        }
+    }
+
+    ASTRA_CHECK(row_matches_scalar(dxgi_format_t::BC6H_UF16, set.bytes));
+    ASTRA_CHECK(row_matches_scalar(dxgi_format_t::BC6H_SF16, set.bytes));
+}
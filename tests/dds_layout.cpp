@@ -0,0 +1,62 @@
+// dds_layout::header() describes the faces a layout actually stores, so reading it back gives the same layout.
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <astra/dds_layout.hpp>
+
+#include "test.hpp"
+
+namespace {
+    astra::gdx::dds10_t legacy_cubemap(uint32_t caps2) {
+        astra::gdx::dds10_t header     = {};
+        header.dx9.width               = 16;
+        header.dx9.height              = 16;
+        header.dx9.mip_count           = 3;
+        header.dx9.pixel_format.fourCC = 0x31545844; // DXT1
+        header.dx9.caps2               = caps2;
+        return header;
+    }
+} // namespace
+
+ASTRA_TEST(dds_layout_header_keeps_partial_cube_faces) {
+    using namespace astra::gdx;
+
+    dds_layout partial(legacy_cubemap(0x200 | 0x400 | 0x2000 | 0x8000));
+    ASTRA_CHECK(partial.face_count == 3 && partial.cube_faces == (0x400 | 0x2000 | 0x8000));
+
+    auto header = partial.header();
+    ASTRA_CHECK(header.dx9.caps2 == (0x200 | 0x400 | 0x2000 | 0x8000) && header.dx10.flags == 0x4);
+
+    dds_layout read_back(header);
+    ASTRA_CHECK(read_back.format == dxgi_format_t::BC1_UNORM && read_back.face_count == 3 && read_back.cube_faces == partial.cube_faces);
+    ASTRA_CHECK(read_back.payload_size == partial.payload_size);
+
+    dds_layout one_face(legacy_cubemap(0x200 | 0x1000));
+    ASTRA_CHECK(dds_layout(one_face.header()).face_count == 1 && dds_layout(one_face.header()).cube_faces == 0x1000);
+}
+
+ASTRA_TEST(dds_layout_header_full_cubemap) {
+    using namespace astra::gdx;
+
+    dds_layout cube(dxgi_format_t::R8G8B8A8_UNORM, 8, 8, 1, 2, true);
+    auto header = cube.header();
+    ASTRA_CHECK(header.dx9.caps2 == 0xFE00 && header.dx10.flags == 0x4);
+
+    dds_layout read_back(header);
+    ASTRA_CHECK(read_back.face_count == 6 && read_back.array_size == 2 && read_back.payload_size == cube.payload_size);
+
+    // a DX10 cubemap that leaves caps2 empty still stores all six faces.
+    header.dx9.caps2 = 0;
+    ASTRA_CHECK(dds_layout(header).face_count == 6);
+
+    ASTRA_CHECK(dds_layout(dxgi_format_t::R8G8B8A8_UNORM, 8, 8).header().dx9.caps2 == 0);
+}
+
+ASTRA_TEST(dds_layout_rejects_cubemap_without_faces) {
+    try {
+        astra::gdx::dds_layout layout(legacy_cubemap(0x200));
+        ASTRA_CHECK(false);
+    } catch (const std::invalid_argument &) {
+    }
+}
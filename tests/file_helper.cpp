@@ -0,0 +1,35 @@
+// write_files pairs every path with a buffer, lists of different lengths are rejected before anything is written.
+
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include <astra/file_helper.hpp>
+
+#include "test.hpp"
+
+ASTRA_TEST(file_helper_write_files_round_trip) {
+    auto dir = std::filesystem::temp_directory_path() / "astra_file_helper_test";
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::filesystem::path> paths = {dir / "a.bin", dir / "b.bin"};
+    std::vector<std::shared_ptr<astra::mem::runtime_array<uint8_t>>> buffers;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        buffers.push_back(std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, 1000 + i, static_cast<uint8_t>(i + 1)));
+    }
+    astra::io::write_files(paths, buffers, 2);
+
+    auto read = astra::io::read_files(paths, 2);
+    ASTRA_CHECK(read.size() == 2 && read[1]->size() == 1001 && read[1]->get(1000) == 2);
+    std::filesystem::remove_all(dir);
+}
+
+ASTRA_TEST(file_helper_write_files_rejects_mismatch) {
+    auto path = std::filesystem::temp_directory_path() / "astra_file_helper_mismatch.bin";
+    try {
+        astra::io::write_files({path, path}, {std::make_shared<astra::mem::runtime_array<uint8_t>>(nullptr, 4)});
+        ASTRA_CHECK(false);
+    } catch (const std::invalid_argument &) {
+    }
+    ASTRA_CHECK(!std::filesystem::exists(path));
+}
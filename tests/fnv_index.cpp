@@ -0,0 +1,51 @@
+// fnv_index finds every key it was built with, misses the rest, and rejects key layouts it doesn't know.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <astra/fnv_index.hpp>
+
+#include "test.hpp"
+
+ASTRA_TEST(fnv_index_find_many_matches_find) {
+    astra::io::fnv_index_builder<> builder;
+    std::mt19937_64 random(7);
+    std::vector<uint64_t> lookup;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        lookup.push_back(random());
+        builder.add(lookup.back(), {0, 0, i, i});
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        lookup.push_back(random()); // almost surely absent.
+    }
+
+    astra::io::fnv_index<> index(builder.build());
+    ASTRA_CHECK(index.size() == 5000);
+
+    std::vector<const astra::io::fnv_index_entry_t *> results(lookup.size());
+    index.find_many(lookup.data(), lookup.size(), results.data());
+    for (size_t i = 0; i < lookup.size(); ++i) {
+        ASTRA_CHECK(results[i] == index.find(lookup[i]));
+        ASTRA_CHECK(i < 5000 ? results[i] != nullptr && results[i]->offset == i : results[i] == nullptr);
+    }
+}
+
+ASTRA_TEST(fnv_index_rejects_unknown_layout) {
+    astra::io::fnv_index_builder<> builder;
+    builder.add(uint64_t{42}, {});
+    auto file = builder.build();
+    ASTRA_CHECK(astra::io::fnv_index<>(file).find(uint64_t{42}) != nullptr);
+
+    auto forged   = *file.clone();
+    uint16_t next = 1;
+    std::memcpy(forged.data() + offsetof(astra::io::fnv_index_header_t, layout), &next, sizeof(next));
+    try {
+        astra::io::fnv_index<> index(forged);
+        ASTRA_CHECK(false);
+    } catch (const std::invalid_argument &) {
+    }
+}
@@ -0,0 +1,94 @@
+// fnv_map behaves like std::unordered_map through inserts, erases, growth and in-place rehashes.
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <astra/fnv_map.hpp>
+
+#include "test.hpp"
+
+namespace {
+    // keys that share their low bits land in the same home group with the same tag, which forces long probes.
+    uint64_t colliding_key(std::mt19937_64 &random) { return random() % 4 == 0 ? (random() % 512) << 32 | 0x155 : random(); }
+
+    bool same(const astra::mem::fnv_map<std::string> &map, const std::unordered_map<uint64_t, std::string> &expected) {
+        if (map.size() != expected.size()) {
+            return false;
+        }
+
+        size_t visited = 0;
+        auto matches   = true;
+        map.for_each([&](uint64_t key, const std::string &value) {
+            auto it = expected.find(key);
+            matches = matches && it != expected.end() && it->second == value;
+            ++visited;
+        });
+        return matches && visited == expected.size();
+    }
+} // namespace
+
+ASTRA_TEST(fnv_map_matches_unordered_map) {
+    astra::mem::fnv_map<std::string> map;
+    std::unordered_map<uint64_t, std::string> expected;
+    std::vector<uint64_t> seen;
+    std::mt19937_64 random(17);
+
+    for (size_t i = 0; i < 200000; ++i) {
+        auto op = random() % 8;
+        if (op < 4 || seen.empty()) {
+            auto key               = colliding_key(random);
+            auto value             = std::to_string(i) + " a value long enough to live on the heap";
+            auto [entry, inserted] = map.emplace(key, value);
+            auto result            = expected.emplace(key, value);
+            ASTRA_CHECK(inserted == result.second && *entry == result.first->second);
+            seen.push_back(key);
+        } else if (op < 7) {
+            auto key = seen[random() % seen.size()];
+            ASTRA_CHECK(map.erase(key) == (expected.erase(key) == 1));
+        } else {
+            auto key   = random() % 2 == 0 ? seen[random() % seen.size()] : random();
+            auto found = map.find(key);
+            auto it    = expected.find(key);
+            ASTRA_CHECK(it == expected.end() ? found == nullptr : found != nullptr && *found == it->second);
+        }
+    }
+    ASTRA_CHECK(same(map, expected));
+
+    std::vector<std::string *> results(seen.size());
+    map.find_many(seen.data(), seen.size(), results.data());
+    for (size_t i = 0; i < seen.size(); ++i) {
+        auto it = expected.find(seen[i]);
+        ASTRA_CHECK(it == expected.end() ? results[i] == nullptr : results[i] == map.find(seen[i]));
+    }
+}
+
+ASTRA_TEST(fnv_map_reserve_and_grow) {
+    astra::mem::fnv_map<std::string> map;
+    std::unordered_map<uint64_t, std::string> expected;
+    std::mt19937_64 random(23);
+
+    map.reserve(1000);
+    auto reserved = map.capacity();
+    for (size_t i = 0; i < 1000; ++i) {
+        auto key = colliding_key(random);
+        map.insert_or_assign(key, std::to_string(i));
+        expected.insert_or_assign(key, std::to_string(i));
+    }
+    ASTRA_CHECK(map.capacity() == reserved && same(map, expected)); // no rehash while bulk loading.
+
+    for (size_t i = 0; i < 50000; ++i) {
+        auto key = random();
+        map[key]      = std::to_string(key);
+        expected[key] = std::to_string(key);
+    }
+    ASTRA_CHECK(map.capacity() > reserved && same(map, expected));
+
+    auto moved = std::move(map);
+    ASTRA_CHECK(map.size() == 0 && map.find(expected.begin()->first) == nullptr && same(moved, expected));
+
+    moved.clear();
+    ASTRA_CHECK(moved.empty() && moved.find(expected.begin()->first) == nullptr);
+}
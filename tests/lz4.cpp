@@ -0,0 +1,100 @@
+// lz4_decompress into a new buffer must size it from the blocks in the input, not from header fields it can't trust.
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <astra/lz4.hpp>
+
+#include "test.hpp"
+
+namespace {
+    astra::mem::runtime_array<uint8_t> compress(size_t size) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>(i / 7 % 13);
+        }
+
+        astra::mem::runtime_array<uint8_t> frame(nullptr, astra::io::lz4_frame_bound(size));
+        auto used = astra::io::lz4_compress(data, frame.span());
+        return frame.view(0, used);
+    }
+
+    // rewrites the 8 byte content size of a frame written with one and fixes up the header checksum.
+    void forge_content_size(astra::mem::runtime_array<uint8_t> &frame, uint64_t content_size) {
+        auto header = frame.data() + 4;
+        std::memcpy(header + 2, &content_size, 8);
+        header[10] = static_cast<uint8_t>(astra::hash::xxh32(header, 10) >> 8);
+    }
+
+    bool block_throws(std::vector<uint8_t> block) {
+        std::vector<uint8_t> out(1 << 16);
+        try {
+            (void) astra::io::lz4_decompress_block(block, out);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    }
+
+    template<typename E>
+    bool throws(const astra::mem::runtime_array<uint8_t> &frame, const astra::io::lz4_decode_options_t &options = {}) {
+        try {
+            (void) astra::io::lz4_decompress(frame, options);
+        } catch (const E &) {
+            return true;
+        }
+        return false;
+    }
+} // namespace
+
+ASTRA_TEST(lz4_decompress_round_trip) {
+    auto frame   = compress(3 << 20);
+    auto decoded = astra::io::lz4_decompress(frame);
+    ASTRA_CHECK(decoded.size() == (3 << 20) && decoded.get(1000) == 1000 / 7 % 13);
+}
+
+ASTRA_TEST(lz4_decompress_rejects_forged_content_size) {
+    auto frame = compress(4096).clone();
+    forge_content_size(*frame, uint64_t(1) << 40);
+    ASTRA_CHECK(throws<std::invalid_argument>(*frame));
+
+    forge_content_size(*frame, 4096);
+    ASTRA_CHECK(astra::io::lz4_decompress(*frame).size() == 4096);
+}
+
+ASTRA_TEST(lz4_decompress_honours_max_output) {
+    auto frame = compress(1 << 20);
+    ASTRA_CHECK(throws<std::out_of_range>(frame, {.max_output = (1 << 20) - 1}));
+    ASTRA_CHECK(astra::io::lz4_decompress(frame, {.max_output = 1 << 20}).size() == 1 << 20);
+}
+
+ASTRA_TEST(lz4_decompress_block_rejects_malformed) {
+    ASTRA_CHECK(block_throws({}));
+    ASTRA_CHECK(block_throws({0x10, 'a', 0x01, 0x00}));             // ends on a match.
+    ASTRA_CHECK(block_throws({0x1F, 'a', 0x01, 0x00, 0xFF, 0xFF})); // ends inside a match length.
+    ASTRA_CHECK(block_throws({0xF0, 0xFF, 0xFF}));                  // ends inside a literal length.
+    ASTRA_CHECK(block_throws({0x30, 'a', 'b'}));                    // literals run past the end.
+    ASTRA_CHECK(block_throws({0x10, 'a', 0x02, 0x00, 0x00}));       // offset before the start.
+    ASTRA_CHECK(block_throws({0x10, 'a', 0x01}));                   // ends inside an offset.
+    ASTRA_CHECK(!block_throws({0x10, 'a', 0x01, 0x00, 0x10, 'b'}));
+}
+
+ASTRA_TEST(lz4_decompress_block_random_input) {
+    // random blocks either decode or throw, they never read or write outside their buffers.
+    std::mt19937 random(11);
+    std::vector<uint8_t> out(1 << 12);
+    for (size_t i = 0; i < 20000; ++i) {
+        std::vector<uint8_t> block(random() % 32);
+        for (auto &byte : block) {
+            byte = static_cast<uint8_t>(random() % 4 == 0 ? 0xFF : random());
+        }
+        try {
+            (void) astra::io::lz4_decompress_block(block, out);
+        } catch (const std::invalid_argument &) {
+        } catch (const std::out_of_range &) {
+        }
+    }
+}
@@ -0,0 +1,34 @@
+// astra_tests runs every registered test, or only those whose name contains the first argument.
+//
+// astra_tests [filter]
+
+#include <cstdio>
+#include <exception>
+#include <string_view>
+
+#include "test.hpp"
+
+int main(int argc, char **argv) {
+    std::string_view filter = argc > 1 ? argv[1] : "";
+
+    size_t run = 0;
+    for (auto &test : astra::test::cases()) {
+        if (!filter.empty() && std::string_view(test.name).find(filter) == std::string_view::npos) {
+            continue;
+        }
+
+        auto before = astra::test::failures();
+        try {
+            test.fn();
+        } catch (const std::exception &error) {
+            ++astra::test::failures();
+            std::fprintf(stderr, "%s threw: %s\n", test.name, error.what());
+        }
+
+        std::printf("%-44s %s\n", test.name, astra::test::failures() == before ? "ok" : "FAILED");
+        ++run;
+    }
+
+    std::printf("%zu tests, %zu failures\n", run, astra::test::failures());
+    return astra::test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+// moving a small_runtime_array must not publish a length for elements that were never constructed.
+
+#include <stdexcept>
+#include <utility>
+
+#include <astra/small_runtime_array.hpp>
+
+#include "test.hpp"
+
+namespace {
+    // counts live instances and throws from the move constructor once `moves_left` reaches zero.
+    struct fragile {
+        static inline int live       = 0;
+        static inline int moves_left = -1;
+        int value                    = 0;
+
+        fragile() { ++live; }
+
+        fragile(const fragile &other) : value(other.value) { ++live; }
+
+        fragile(fragile &&other) : value(other.value) {
+            if (moves_left >= 0 && moves_left-- == 0) {
+                throw std::runtime_error("move failed");
+            }
+            ++live;
+        }
+
+        fragile &operator=(const fragile &) = default;
+
+        ~fragile() { --live; }
+    };
+} // namespace
+
+ASTRA_TEST(small_runtime_array_throwing_move_leaves_target_empty) {
+    {
+        astra::mem::small_runtime_array<fragile, 4> source(nullptr, 4);
+        for (int i = 0; i < 4; ++i) {
+            source.data()[i].value = i + 1;
+        }
+
+        // the target outlives the failed assignment, so its destructor sees whatever length take() left behind.
+        astra::mem::small_runtime_array<fragile, 4> target(nullptr, 3);
+        fragile::moves_left = 2;
+        try {
+            target = std::move(source);
+            ASTRA_CHECK(false);
+        } catch (const std::runtime_error &) {
+        }
+        fragile::moves_left = -1;
+
+        ASTRA_CHECK(target.size() == 0);
+        ASTRA_CHECK(source.size() == 4);
+        ASTRA_CHECK(fragile::live == 4);
+
+        target = std::move(source);
+        ASTRA_CHECK(source.size() == 0 && target.size() == 4 && target.data()[3].value == 4);
+    }
+    ASTRA_CHECK(fragile::live == 0);
+}
+
+ASTRA_TEST(small_runtime_array_move_spilled) {
+    astra::mem::small_runtime_array<int, 2> source(nullptr, 5, 7);
+    auto data = source.data();
+    astra::mem::small_runtime_array<int, 2> target(std::move(source));
+    ASTRA_CHECK(source.size() == 0 && target.size() == 5 && target.data() == data && target.data()[4] == 7);
+}
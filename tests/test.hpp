@@ -0,0 +1,44 @@
+// the smallest test registry that does the job: ASTRA_TEST(name) registers a function with astra_tests, ASTRA_CHECK
+// records a failure and keeps going so one run reports every mismatch.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+namespace astra::test {
+    struct case_t {
+        const char *name;
+        void (*fn)();
+    };
+
+    inline std::vector<case_t> &cases() {
+        static std::vector<case_t> list;
+        return list;
+    }
+
+    inline size_t &failures() {
+        static size_t count = 0;
+        return count;
+    }
+
+    struct registrar {
+        registrar(const char *name, void (*fn)()) { cases().push_back({name, fn}); }
+    };
+
+    inline bool check(bool ok, const char *expression, const char *file, int line) {
+        if (!ok) {
+            ++failures();
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        }
+        return ok;
+    }
+} // namespace astra::test
+
+#define ASTRA_TEST(name)                                                  \
+    static void name();                                                   \
+    static const astra::test::registrar name##_registrar(#name, &(name)); \
+    static void name()
+
+#define ASTRA_CHECK(expression) astra::test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
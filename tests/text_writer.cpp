@@ -0,0 +1,48 @@
+// text_writer formats numbers but not character types, and a path constructor that throws closes what it opened.
+
+#include <cstdint>
+#include <filesystem>
+#include <new>
+#include <string>
+
+#include <astra/text_writer.hpp>
+
+#include "test.hpp"
+
+namespace {
+    using astra::io::detail::text_number;
+
+    static_assert(text_number<bool> && text_number<int> && text_number<signed char> && text_number<uint8_t> && text_number<unsigned long long> && text_number<double>);
+    static_assert(!text_number<char> && !text_number<wchar_t> && !text_number<char8_t> && !text_number<char16_t> && !text_number<char32_t>);
+
+    [[maybe_unused]] size_t open_descriptors() {
+        size_t count = 0;
+        for ([[maybe_unused]] auto &entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+            ++count;
+        }
+        return count;
+    }
+} // namespace
+
+ASTRA_TEST(text_writer_numbers) {
+    std::string out;
+    {
+        astra::io::text_writer writer([&](std::string_view text) { out += text; });
+        writer << 42 << ' ' << true << ' ' << static_cast<int8_t>(-3) << ' ' << static_cast<uint8_t>(200) << ' ' << 2.5 << 'x';
+    }
+    ASTRA_CHECK(out == "42 true -3 200 2.5x");
+}
+
+ASTRA_TEST(text_writer_failed_start_closes_file) {
+#ifdef __linux__
+    auto path   = std::filesystem::temp_directory_path() / "astra_text_writer_test.txt";
+    auto before = open_descriptors();
+    try {
+        astra::io::text_writer writer(path, {.buffer_size = SIZE_MAX}); // the buffer allocation throws after the open.
+        ASTRA_CHECK(false);
+    } catch (const std::bad_alloc &) {
+    }
+    ASTRA_CHECK(open_descriptors() == before);
+    std::filesystem::remove(path);
+#endif
+}